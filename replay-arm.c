@@ -0,0 +1,284 @@
+#include <obs-module.h>
+#include <obs-frontend-api.h>
+#include <util/platform.h>
+#include <ctype.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <time.h>
+#include "replay.h"
+
+void replay_arm_init(struct replay_arm *arm)
+{
+	memset(arm, 0, sizeof(*arm));
+	pthread_mutex_init(&arm->mutex, NULL);
+	arm->created = os_gettime_ns();
+}
+
+void replay_arm_free(struct replay_arm *arm)
+{
+	bfree(arm->scene_name);
+	arm->scene_name = NULL;
+	pthread_mutex_destroy(&arm->mutex);
+}
+
+void replay_arm_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, SETTING_CAPTURE_POLICY, CAPTURE_POLICY_ALWAYS);
+	obs_data_set_default_string(settings, SETTING_CAPTURE_SCENE, "");
+	obs_data_set_default_string(settings, SETTING_CAPTURE_SCHEDULE, "");
+	obs_data_set_default_int(settings, SETTING_CAPTURE_DISARM_DELAY, 10000);
+}
+
+static bool replay_arm_policy_modified(obs_properties_t *props, obs_property_t *property, obs_data_t *data)
+{
+	UNUSED_PARAMETER(property);
+	const int policy = (int)obs_data_get_int(data, SETTING_CAPTURE_POLICY);
+	obs_property_set_visible(obs_properties_get(props, SETTING_CAPTURE_SCENE), policy == CAPTURE_POLICY_SCENE);
+	obs_property_set_visible(obs_properties_get(props, SETTING_CAPTURE_SCHEDULE), policy == CAPTURE_POLICY_SCHEDULE);
+	obs_property_set_visible(obs_properties_get(props, SETTING_CAPTURE_DISARM_DELAY), policy != CAPTURE_POLICY_ALWAYS);
+	return true;
+}
+
+static bool replay_arm_enum_scenes(void *data, obs_source_t *source)
+{
+	obs_property_t *prop = data;
+	obs_property_list_add_string(prop, obs_source_get_name(source), obs_source_get_name(source));
+	return true;
+}
+
+void replay_arm_properties(obs_properties_t *props)
+{
+	obs_property_t *prop = obs_properties_add_list(props, SETTING_CAPTURE_POLICY, obs_module_text("CapturePolicy"),
+						       OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(prop, obs_module_text("CapturePolicyAlways"), CAPTURE_POLICY_ALWAYS);
+	obs_property_list_add_int(prop, obs_module_text("CapturePolicyParentActive"), CAPTURE_POLICY_PARENT_ACTIVE);
+	obs_property_list_add_int(prop, obs_module_text("CapturePolicyScene"), CAPTURE_POLICY_SCENE);
+	obs_property_list_add_int(prop, obs_module_text("CapturePolicySchedule"), CAPTURE_POLICY_SCHEDULE);
+	obs_property_set_modified_callback(prop, replay_arm_policy_modified);
+	prop = obs_properties_add_list(props, SETTING_CAPTURE_SCENE, obs_module_text("CaptureScene"), OBS_COMBO_TYPE_EDITABLE,
+				       OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(prop, "", "");
+	obs_enum_scenes(replay_arm_enum_scenes, prop);
+	obs_properties_add_text(props, SETTING_CAPTURE_SCHEDULE, obs_module_text("CaptureSchedule"), OBS_TEXT_DEFAULT);
+	prop = obs_properties_add_int(props, SETTING_CAPTURE_DISARM_DELAY, obs_module_text("CaptureDisarmDelay"), 0,
+				      SETTING_CAPTURE_DISARM_DELAY_MAX, 1000);
+	obs_property_int_set_suffix(prop, "ms");
+}
+
+// minutes since midnight of a "HH:MM" time, -1 when malformed
+static int replay_arm_parse_time(const char **p)
+{
+	char *end = NULL;
+	const long hours = strtol(*p, &end, 10);
+	if (end == *p || *end != ':' || hours < 0 || hours > 24)
+		return -1;
+	const char *m = end + 1;
+	const long minutes = strtol(m, &end, 10);
+	if (end == m || minutes < 0 || minutes > 59 || hours * 60 + minutes > 24 * 60)
+		return -1;
+	*p = end;
+	return (int)(hours * 60 + minutes);
+}
+
+/* the schedule is a list of "HH:MM-HH:MM" windows in local time, separated
+ * by commas or semicolons, malformed windows are skipped */
+static void replay_arm_parse_schedule(struct replay_arm *arm, const char *text)
+{
+	arm->window_count = 0;
+	const char *p = text ? text : "";
+	while (*p && arm->window_count < REPLAY_ARM_MAX_WINDOWS) {
+		while (*p && (isspace((unsigned char)*p) || *p == ',' || *p == ';'))
+			p++;
+		if (!*p)
+			break;
+		const int from = replay_arm_parse_time(&p);
+		int to = -1;
+		if (from >= 0) {
+			while (isspace((unsigned char)*p))
+				p++;
+			if (*p == '-') {
+				p++;
+				while (isspace((unsigned char)*p))
+					p++;
+				to = replay_arm_parse_time(&p);
+			}
+		}
+		if (from < 0 || to < 0) {
+			while (*p && *p != ',' && *p != ';')
+				p++;
+			continue;
+		}
+		arm->window_from[arm->window_count] = from;
+		arm->window_to[arm->window_count] = to;
+		arm->window_count++;
+	}
+}
+
+void replay_arm_update(struct replay_arm *arm, obs_data_t *settings)
+{
+	pthread_mutex_lock(&arm->mutex);
+	arm->policy = (int)obs_data_get_int(settings, SETTING_CAPTURE_POLICY);
+	const char *scene_name = obs_data_get_string(settings, SETTING_CAPTURE_SCENE);
+	if (!arm->scene_name || strcmp(arm->scene_name, scene_name) != 0) {
+		bfree(arm->scene_name);
+		arm->scene_name = bstrdup(scene_name);
+	}
+	replay_arm_parse_schedule(arm, obs_data_get_string(settings, SETTING_CAPTURE_SCHEDULE));
+	arm->disarm_delay = (uint64_t)obs_data_get_int(settings, SETTING_CAPTURE_DISARM_DELAY) * MSEC_TO_NSEC;
+	// the next tick checks the new policy, always captures from right away
+	arm->check_timestamp = 0;
+	if (arm->policy == CAPTURE_POLICY_ALWAYS && !arm->armed) {
+		arm->armed_since = os_gettime_ns();
+		arm->armed = true;
+	}
+	pthread_mutex_unlock(&arm->mutex);
+}
+
+/* names of the program and preview scene, kept up to date from frontend
+ * events so the filter tick never calls into the frontend, the preview
+ * scene is only there in studio mode */
+static pthread_mutex_t replay_arm_scene_mutex;
+static char *replay_arm_program_scene;
+static char *replay_arm_preview_scene;
+
+static char *replay_arm_scene_name(obs_source_t *scene)
+{
+	char *name = scene ? bstrdup(obs_source_get_name(scene)) : NULL;
+	obs_source_release(scene);
+	return name;
+}
+
+static void replay_arm_frontend_event(enum obs_frontend_event event, void *data)
+{
+	UNUSED_PARAMETER(data);
+	char *program = NULL;
+	char *preview = NULL;
+	switch (event) {
+	case OBS_FRONTEND_EVENT_SCENE_CHANGED:
+	case OBS_FRONTEND_EVENT_PREVIEW_SCENE_CHANGED:
+	case OBS_FRONTEND_EVENT_STUDIO_MODE_ENABLED:
+	case OBS_FRONTEND_EVENT_STUDIO_MODE_DISABLED:
+	case OBS_FRONTEND_EVENT_SCENE_LIST_CHANGED:
+	case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CHANGED:
+	case OBS_FRONTEND_EVENT_FINISHED_LOADING:
+		program = replay_arm_scene_name(obs_frontend_get_current_scene());
+		preview = replay_arm_scene_name(obs_frontend_get_current_preview_scene());
+		break;
+	case OBS_FRONTEND_EVENT_SCENE_COLLECTION_CLEANUP:
+	case OBS_FRONTEND_EVENT_EXIT:
+		break;
+	default:
+		return;
+	}
+	pthread_mutex_lock(&replay_arm_scene_mutex);
+	char *old_program = replay_arm_program_scene;
+	char *old_preview = replay_arm_preview_scene;
+	replay_arm_program_scene = program;
+	replay_arm_preview_scene = preview;
+	pthread_mutex_unlock(&replay_arm_scene_mutex);
+	bfree(old_program);
+	bfree(old_preview);
+}
+
+void replay_arm_module_load(void)
+{
+	pthread_mutex_init(&replay_arm_scene_mutex, NULL);
+	obs_frontend_add_event_callback(replay_arm_frontend_event, NULL);
+}
+
+void replay_arm_module_unload(void)
+{
+	obs_frontend_remove_event_callback(replay_arm_frontend_event, NULL);
+	bfree(replay_arm_program_scene);
+	bfree(replay_arm_preview_scene);
+	replay_arm_program_scene = NULL;
+	replay_arm_preview_scene = NULL;
+	pthread_mutex_destroy(&replay_arm_scene_mutex);
+}
+
+static bool replay_arm_scene_live(const char *scene_name)
+{
+	if (!scene_name || !*scene_name)
+		return false;
+	pthread_mutex_lock(&replay_arm_scene_mutex);
+	const bool live = (replay_arm_program_scene && strcmp(replay_arm_program_scene, scene_name) == 0) ||
+			  (replay_arm_preview_scene && strcmp(replay_arm_preview_scene, scene_name) == 0);
+	pthread_mutex_unlock(&replay_arm_scene_mutex);
+	return live;
+}
+
+static bool replay_arm_scheduled(const struct replay_arm *arm)
+{
+	const time_t now = time(NULL);
+	struct tm local;
+#ifdef _WIN32
+	if (localtime_s(&local, &now) != 0)
+		return false;
+#else
+	if (!localtime_r(&now, &local))
+		return false;
+#endif
+	const int minute = local.tm_hour * 60 + local.tm_min;
+	for (size_t i = 0; i < arm->window_count; i++) {
+		const int from = arm->window_from[i];
+		const int to = arm->window_to[i];
+		if (from <= to ? (minute >= from && minute < to) : (minute >= from || minute < to))
+			return true;
+	}
+	return false;
+}
+
+static bool replay_arm_wanted(const struct replay_arm *arm, obs_source_t *parent)
+{
+	switch (arm->policy) {
+	case CAPTURE_POLICY_PARENT_ACTIVE:
+		return parent && (obs_source_active(parent) || obs_source_showing(parent));
+	case CAPTURE_POLICY_SCENE:
+		return replay_arm_scene_live(arm->scene_name);
+	case CAPTURE_POLICY_SCHEDULE:
+		return replay_arm_scheduled(arm);
+	default:
+		return true;
+	}
+}
+
+// checks the policy at most every REPLAY_ARM_CHECK_INTERVAL, returns true when capture just got disarmed
+bool replay_arm_tick(struct replay_arm *arm, obs_source_t *parent, const char *name)
+{
+	const uint64_t now = os_gettime_ns();
+	pthread_mutex_lock(&arm->mutex);
+	if (arm->check_timestamp && now < arm->check_timestamp + REPLAY_ARM_CHECK_INTERVAL) {
+		pthread_mutex_unlock(&arm->mutex);
+		return false;
+	}
+	arm->check_timestamp = now;
+	const bool wanted = replay_arm_wanted(arm, parent);
+	bool disarmed = false;
+	if (wanted) {
+		arm->wanted_timestamp = now;
+		if (!arm->armed) {
+			arm->armed_since = now;
+			arm->armed = true;
+			blog(LOG_INFO, "[replay_filter: '%s'] capture of '%s' armed", name, parent ? obs_source_get_name(parent) : "");
+		}
+	} else if (arm->armed && now >= arm->wanted_timestamp + arm->disarm_delay) {
+		arm->armed = false;
+		arm->armed_ns += now - arm->armed_since;
+		arm->disarm_count++;
+		disarmed = true;
+		blog(LOG_INFO, "[replay_filter: '%s'] capture of '%s' disarmed", name, parent ? obs_source_get_name(parent) : "");
+	}
+	pthread_mutex_unlock(&arm->mutex);
+	return disarmed;
+}
+
+void replay_arm_log_stats(struct replay_arm *arm, const char *name)
+{
+	if (!arm->disarm_count)
+		return;
+	const uint64_t now = os_gettime_ns();
+	const uint64_t armed = arm->armed_ns + (arm->armed ? now - arm->armed_since : 0);
+	blog(LOG_INFO, "[replay_filter: '%s'] capture armed %.1f%% of %.1f s, disarmed %" PRIu64 " times", name,
+	     now > arm->created ? (double)armed * 100.0 / (double)(now - arm->created) : 0.0,
+	     (double)(now - arm->created) / 1000000000.0, arm->disarm_count);
+}
@@ -22,8 +22,8 @@ static void replay_filter_update(void *data, obs_data_t *settings)
 	}
 	filter->duration = new_duration;
 	filter->internal_frames = obs_data_get_bool(settings, SETTING_INTERNAL_FRAMES);
-	const double db = obs_data_get_double(settings, SETTING_AUDIO_THRESHOLD);
-	filter->threshold = db_to_mul((float)db);
+	replay_trigger_update(&filter->trigger, settings);
+	replay_arm_update(&filter->arm, settings);
 }
 
 static void *replay_filter_create(obs_data_t *settings, obs_source_t *source)
@@ -31,6 +31,8 @@ static void *replay_filter_create(obs_data_t *settings, obs_source_t *source)
 	struct replay_filter *context = bzalloc(sizeof(struct replay_filter));
 	context->src = source;
 	pthread_mutex_init(&context->mutex, NULL);
+	replay_filter_init_queues(context);
+	replay_arm_init(&context->arm);
 	context->last_check = obs_get_video_frame_time();
 
 	replay_filter_update(context, settings);
@@ -42,12 +44,18 @@ static void replay_filter_destroy(void *data)
 {
 	struct replay_filter *filter = data;
 
+	replay_trigger_log_stats(&filter->trigger, obs_source_get_name(filter->src));
+	replay_arm_log_stats(&filter->arm, obs_source_get_name(filter->src));
+
 	pthread_mutex_lock(&filter->mutex);
 	free_video_data(filter);
 	free_audio_data(filter);
 	pthread_mutex_unlock(&filter->mutex);
 	circlebuf_free(&filter->video_frames);
 	circlebuf_free(&filter->audio_frames);
+	replay_filter_free_queues(filter);
+	obs_weak_source_release(filter->owner);
+	replay_arm_free(&filter->arm);
 	pthread_mutex_destroy(&filter->mutex);
 	bfree(data);
 }
@@ -76,19 +84,15 @@ struct async_frame {
 static struct obs_source_frame *replay_filter_video(void *data, struct obs_source_frame *frame)
 {
 	struct replay_filter *filter = data;
-	struct obs_source_frame *output;
+	if (!filter->arm.armed)
+		return frame;
 
-	uint64_t last_timestamp = 0;
+	uint64_t last_timestamp = filter->last_video_timestamp;
 
 	obs_source_t *target = filter->internal_frames ? obs_filter_get_parent(filter->src) : NULL;
 	const uint64_t os_time = obs_get_video_frame_time();
 	struct obs_source_frame *new_frame = NULL;
 
-	pthread_mutex_lock(&filter->mutex);
-	if (filter->video_frames.size) {
-		circlebuf_peek_back(&filter->video_frames, &output, sizeof(struct obs_source_frame *));
-		last_timestamp = output->timestamp;
-	}
 	if (target) {
 		if (filter->target_offset == 0) {
 			if (obs_get_version() < MAKE_SEMANTIC_VERSION(30, 0, 0)) {
@@ -120,7 +124,7 @@ static struct obs_source_frame *replay_filter_video(void *data, struct obs_sourc
 				}
 				new_frame->timestamp = adjusted_time;
 				last_timestamp = adjusted_time;
-				circlebuf_push_back(&filter->video_frames, &new_frame, sizeof(struct obs_source_frame *));
+				replay_filter_push_video(filter, new_frame);
 			}
 		}
 		pthread_mutex_unlock(async_mutex);
@@ -139,32 +143,8 @@ static struct obs_source_frame *replay_filter_video(void *data, struct obs_sourc
 			adjusted_time = os_time;
 		}
 		new_frame->timestamp = adjusted_time;
-		last_timestamp = adjusted_time;
-		circlebuf_push_back(&filter->video_frames, &new_frame, sizeof(struct obs_source_frame *));
-	}
-	if (!last_timestamp) {
-		pthread_mutex_unlock(&filter->mutex);
-		return frame;
+		replay_filter_push_video(filter, new_frame);
 	}
-	circlebuf_peek_front(&filter->video_frames, &output, sizeof(struct obs_source_frame *));
-
-	uint64_t cur_duration = last_timestamp - output->timestamp;
-	while (cur_duration > 0 && cur_duration > filter->duration) {
-
-		circlebuf_pop_front(&filter->video_frames, NULL, sizeof(struct obs_source_frame *));
-
-		if (os_atomic_dec_long(&output->refs) <= 0) {
-			obs_source_frame_destroy(output);
-			output = NULL;
-		}
-		if (filter->video_frames.size) {
-			circlebuf_peek_front(&filter->video_frames, &output, sizeof(struct obs_source_frame *));
-			cur_duration = last_timestamp - output->timestamp;
-		} else {
-			cur_duration = 0;
-		}
-	}
-	pthread_mutex_unlock(&filter->mutex);
 	return frame;
 }
 
@@ -178,8 +158,8 @@ static obs_properties_t *replay_filter_properties(void *unused)
 						      SETTING_DURATION_MAX, 1000);
 	obs_property_int_set_suffix(prop, "ms");
 	obs_properties_add_bool(props, SETTING_INTERNAL_FRAMES, obs_module_text("CaptureInternalFrames"));
-	obs_properties_add_float_slider(props, SETTING_AUDIO_THRESHOLD, obs_module_text("ThresholdDb"), SETTING_AUDIO_THRESHOLD_MIN,
-					SETTING_AUDIO_THRESHOLD_MAX, 0.1);
+	replay_trigger_properties(props);
+	replay_arm_properties(props);
 
 	return props;
 }
@@ -188,6 +168,7 @@ static void replay_filter_tick(void *data, float seconds)
 {
 	UNUSED_PARAMETER(seconds);
 	replay_filter_check(data);
+	replay_filter_buffer_tick(data);
 }
 
 struct obs_source_info replay_filter_async_info = {
@@ -198,6 +179,7 @@ struct obs_source_info replay_filter_async_info = {
 	.destroy = replay_filter_destroy,
 	.update = replay_filter_update,
 	.load = replay_filter_update,
+	.get_defaults = replay_filter_defaults,
 	.video_tick = replay_filter_tick,
 	.get_name = replay_filter_get_name,
 	.get_properties = replay_filter_properties,
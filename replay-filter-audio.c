@@ -19,12 +19,15 @@ static void replay_filter_update(void *data, obs_data_t *settings)
 
 	const uint64_t new_duration = (uint64_t)obs_data_get_int(settings, SETTING_DURATION) * MSEC_TO_NSEC;
 
-	if (new_duration < filter->duration)
+	if (new_duration < filter->duration) {
+		pthread_mutex_lock(&filter->mutex);
 		free_video_data(filter);
+		pthread_mutex_unlock(&filter->mutex);
+	}
 
 	filter->duration = new_duration;
-	const double db = obs_data_get_double(settings, SETTING_AUDIO_THRESHOLD);
-	filter->threshold = db_to_mul((float)db);
+	replay_trigger_update(&filter->trigger, settings);
+	replay_arm_update(&filter->arm, settings);
 }
 
 static void *replay_filter_create(obs_data_t *settings, obs_source_t *source)
@@ -32,6 +35,8 @@ static void *replay_filter_create(obs_data_t *settings, obs_source_t *source)
 	struct replay_filter *context = bzalloc(sizeof(struct replay_filter));
 	context->src = source;
 	pthread_mutex_init(&context->mutex, NULL);
+	replay_filter_init_queues(context);
+	replay_arm_init(&context->arm);
 	context->last_check = obs_get_video_frame_time();
 
 	replay_filter_update(context, settings);
@@ -43,12 +48,18 @@ static void replay_filter_destroy(void *data)
 {
 	struct replay_filter *filter = data;
 
+	replay_trigger_log_stats(&filter->trigger, obs_source_get_name(filter->src));
+	replay_arm_log_stats(&filter->arm, obs_source_get_name(filter->src));
+
 	pthread_mutex_lock(&filter->mutex);
 	free_video_data(filter);
 	free_audio_data(filter);
 	pthread_mutex_unlock(&filter->mutex);
 	circlebuf_free(&filter->video_frames);
 	circlebuf_free(&filter->audio_frames);
+	replay_filter_free_queues(filter);
+	obs_weak_source_release(filter->owner);
+	replay_arm_free(&filter->arm);
 	pthread_mutex_destroy(&filter->mutex);
 
 	bfree(data);
@@ -59,8 +70,10 @@ static void replay_filter_remove(void *data, obs_source_t *parent)
 	UNUSED_PARAMETER(parent);
 	struct replay_filter *filter = data;
 
+	pthread_mutex_lock(&filter->mutex);
 	free_video_data(filter);
 	free_audio_data(filter);
+	pthread_mutex_unlock(&filter->mutex);
 }
 
 static obs_properties_t *replay_filter_properties(void *unused)
@@ -72,8 +85,8 @@ static obs_properties_t *replay_filter_properties(void *unused)
 	obs_property_t *prop = obs_properties_add_int(props, SETTING_DURATION, obs_module_text("Duration"), SETTING_DURATION_MIN,
 						      SETTING_DURATION_MAX, 1000);
 	obs_property_int_set_suffix(prop, "ms");
-	obs_properties_add_float_slider(props, SETTING_AUDIO_THRESHOLD, obs_module_text("ThresholdDb"), SETTING_AUDIO_THRESHOLD_MIN,
-					SETTING_AUDIO_THRESHOLD_MAX, 0.1);
+	replay_trigger_properties(props);
+	replay_arm_properties(props);
 
 	return props;
 }
@@ -82,6 +95,7 @@ static void replay_filter_tick(void *data, float seconds)
 {
 	UNUSED_PARAMETER(seconds);
 	replay_filter_check(data);
+	replay_filter_buffer_tick(data);
 }
 
 struct obs_source_info replay_filter_audio_info = {
@@ -92,6 +106,7 @@ struct obs_source_info replay_filter_audio_info = {
 	.destroy = replay_filter_destroy,
 	.update = replay_filter_update,
 	.load = replay_filter_update,
+	.get_defaults = replay_filter_defaults,
 	.video_tick = replay_filter_tick,
 	.get_name = replay_filter_get_name,
 	.get_properties = replay_filter_properties,
@@ -30,8 +30,6 @@ void replay_filter_raw_video(void *data, struct video_data *frame)
 	if (!frame || !frame->data[0])
 		return;
 
-	struct obs_source_frame *output;
-
 	struct obs_source_frame *new_frame = obs_source_frame_create(VIDEO_FORMAT_BGRA, filter->known_width, filter->known_height);
 	new_frame->refs = 1;
 	new_frame->timestamp = frame->timestamp;
@@ -42,29 +40,17 @@ void replay_filter_raw_video(void *data, struct video_data *frame)
 	else
 		memcpy(new_frame->data[0], frame->data[0], new_frame->linesize[0] * filter->known_height);
 
-	pthread_mutex_lock(&filter->mutex);
-
-	circlebuf_push_back(&filter->video_frames, &new_frame, sizeof(struct obs_source_frame *));
-
-	circlebuf_peek_front(&filter->video_frames, &output, sizeof(struct obs_source_frame *));
-
-	uint64_t cur_duration = frame->timestamp - output->timestamp;
-	while (cur_duration > 0 && cur_duration > filter->duration) {
-
-		circlebuf_pop_front(&filter->video_frames, NULL, sizeof(struct obs_source_frame *));
+	replay_filter_push_video(filter, new_frame);
+}
 
-		if (os_atomic_dec_long(&output->refs) <= 0) {
-			obs_source_frame_destroy(output);
-			output = NULL;
-		}
-		if (filter->video_frames.size) {
-			circlebuf_peek_front(&filter->video_frames, &output, sizeof(struct obs_source_frame *));
-			cur_duration = frame->timestamp - output->timestamp;
-		} else {
-			cur_duration = 0;
-		}
-	}
-	pthread_mutex_unlock(&filter->mutex);
+// no more frames reach the filter once disconnected, closing waits for the output thread and is left to the release worker
+static void replay_filter_close_output(struct replay_filter *filter)
+{
+	if (!filter->video_output)
+		return;
+	video_output_disconnect(filter->video_output, replay_filter_raw_video, filter);
+	replay_release_video_output(filter->video_output);
+	filter->video_output = NULL;
 }
 
 void replay_filter_offscreen_render(void *data, uint32_t cx, uint32_t cy)
@@ -73,6 +59,22 @@ void replay_filter_offscreen_render(void *data, uint32_t cx, uint32_t cy)
 	UNUSED_PARAMETER(cy);
 	struct replay_filter *filter = data;
 
+	if (!filter->arm.armed) {
+		// nothing is rendered while disarmed, the output and staging surface are set up again on the first armed render
+		if (filter->video_output) {
+			replay_filter_close_output(filter);
+			if (filter->video_data) {
+				gs_stagesurface_unmap(filter->stagesurface);
+				filter->video_data = NULL;
+			}
+			gs_stagesurface_destroy(filter->stagesurface);
+			filter->stagesurface = NULL;
+			filter->known_width = 0;
+			filter->known_height = 0;
+		}
+		return;
+	}
+
 	obs_source_t *target = obs_filter_get_target(filter->src);
 	if (!target) {
 		return;
@@ -114,7 +116,7 @@ void replay_filter_offscreen_render(void *data, uint32_t cx, uint32_t cy)
 			vi.range = VIDEO_RANGE_DEFAULT;
 			vi.name = obs_source_get_name(filter->src);
 
-			video_output_close(filter->video_output);
+			replay_filter_close_output(filter);
 			video_output_open(&filter->video_output, &vi);
 			video_output_connect(filter->video_output, NULL, replay_filter_raw_video, filter);
 
@@ -160,12 +162,13 @@ static void replay_filter_update(void *data, obs_data_t *settings)
 	}
 
 	filter->duration = new_duration;
+	replay_arm_update(&filter->arm, settings);
 
 	obs_add_main_render_callback(replay_filter_offscreen_render, filter);
 
 	replay_filter_check(filter);
 
-	obs_source_t *s = obs_get_source_by_name(obs_source_get_name(filter->src));
+	obs_source_t *s = replay_filter_owner(filter);
 	if (s) {
 		if (obs_data_get_bool(settings, SETTING_SOUND_TRIGGER) && !filter->trigger_threshold) {
 			filter->threshold_data = obs_obj_get_data(s);
@@ -182,6 +185,8 @@ static void *replay_filter_create(obs_data_t *settings, obs_source_t *source)
 	struct replay_filter *context = bzalloc(sizeof(struct replay_filter));
 	context->src = source;
 	pthread_mutex_init(&context->mutex, NULL);
+	replay_filter_init_queues(context);
+	replay_arm_init(&context->arm);
 
 	context->texrender = gs_texrender_create(TEXFORMAT, GS_ZS_NONE);
 	context->video_data = NULL;
@@ -197,6 +202,7 @@ static void replay_filter_destroy(void *data)
 {
 	struct replay_filter *filter = data;
 
+	replay_arm_log_stats(&filter->arm, obs_source_get_name(filter->src));
 	obs_remove_main_render_callback(replay_filter_offscreen_render, filter);
 	pthread_mutex_lock(&filter->mutex);
 	video_output_close(filter->video_output);
@@ -211,6 +217,9 @@ static void replay_filter_destroy(void *data)
 	pthread_mutex_unlock(&filter->mutex);
 	circlebuf_free(&filter->video_frames);
 	circlebuf_free(&filter->audio_frames);
+	replay_filter_free_queues(filter);
+	obs_weak_source_release(filter->owner);
+	replay_arm_free(&filter->arm);
 	pthread_mutex_destroy(&filter->mutex);
 	bfree(data);
 }
@@ -224,6 +233,7 @@ static obs_properties_t *replay_filter_properties(void *unused)
 	obs_property_t *prop = obs_properties_add_int(props, SETTING_DURATION, obs_module_text("Duration"), SETTING_DURATION_MIN,
 						      SETTING_DURATION_MAX, 1000);
 	obs_property_int_set_suffix(prop, "ms");
+	replay_arm_properties(props);
 
 	return props;
 }
@@ -246,6 +256,7 @@ void replay_filter_tick(void *data, float seconds)
 	struct replay_filter *filter = data;
 	obs_get_video_info(&filter->ovi);
 	replay_filter_check(filter);
+	replay_filter_buffer_tick(filter);
 }
 
 void replay_filter_video_render(void *data, gs_effect_t *effect)
@@ -263,6 +274,7 @@ struct obs_source_info replay_filter_info = {
 	.destroy = replay_filter_destroy,
 	.update = replay_filter_update,
 	.load = replay_filter_update,
+	.get_defaults = replay_filter_defaults,
 	.get_name = replay_filter_get_name,
 	.get_properties = replay_filter_properties,
 	.filter_remove = replay_filter_remove,
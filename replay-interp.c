@@ -0,0 +1,460 @@
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/threading.h>
+#include <util/sse-intrin.h>
+#include <inttypes.h>
+#include "replay.h"
+
+#define PAIR_EMPTY 0
+#define PAIR_QUEUED 1
+#define PAIR_BUSY 2
+#define PAIR_READY 3
+
+/* motion is searched on a half resolution luma proxy in 8x8 blocks, which
+ * are 16x16 blocks of the frame, matching bilaterally around the block of
+ * the frame halfway between the two stored frames */
+#define PROXY_BLOCK 8
+#define FRAME_BLOCK 16
+#define SEARCH_RANGE 8
+#define SEARCH_PENALTY 4
+
+struct interp_plane {
+	uint32_t sx;
+	uint32_t sy;
+	uint32_t bpp;
+};
+
+struct interp_vector {
+	int8_t x;
+	int8_t y;
+};
+
+// plane subsampling and bytes per pixel, packed 4:2:2 formats use a macropixel of two pixels
+static size_t interp_planes(enum video_format format, struct interp_plane *planes)
+{
+	switch (format) {
+	case VIDEO_FORMAT_I420:
+		planes[0] = (struct interp_plane){1, 1, 1};
+		planes[1] = (struct interp_plane){2, 2, 1};
+		planes[2] = (struct interp_plane){2, 2, 1};
+		return 3;
+	case VIDEO_FORMAT_NV12:
+		planes[0] = (struct interp_plane){1, 1, 1};
+		planes[1] = (struct interp_plane){2, 2, 2};
+		return 2;
+	case VIDEO_FORMAT_I444:
+		planes[0] = (struct interp_plane){1, 1, 1};
+		planes[1] = (struct interp_plane){1, 1, 1};
+		planes[2] = (struct interp_plane){1, 1, 1};
+		return 3;
+	case VIDEO_FORMAT_Y800:
+		planes[0] = (struct interp_plane){1, 1, 1};
+		return 1;
+	case VIDEO_FORMAT_YVYU:
+	case VIDEO_FORMAT_YUY2:
+	case VIDEO_FORMAT_UYVY:
+		planes[0] = (struct interp_plane){2, 1, 4};
+		return 1;
+	case VIDEO_FORMAT_RGBA:
+	case VIDEO_FORMAT_BGRA:
+	case VIDEO_FORMAT_BGRX:
+		planes[0] = (struct interp_plane){1, 1, 4};
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+// out = (a * (256 - w) + b * w + 128) >> 8 for every byte
+static void blend_bytes(uint8_t *out, const uint8_t *a, const uint8_t *b, size_t count, int w)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i wa = _mm_set1_epi16((short)(256 - w));
+	const __m128i wb = _mm_set1_epi16((short)w);
+	const __m128i round = _mm_set1_epi16(128);
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		const __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), wa),
+					   _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), wb));
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), wa),
+					   _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), wb));
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packus_epi16(lo, hi));
+	}
+	for (; i < count; i++)
+		out[i] = (uint8_t)((a[i] * (256 - w) + b[i] * w + 128) >> 8);
+}
+
+static uint32_t sad_block(const uint8_t *a, const uint8_t *b, size_t stride)
+{
+	__m128i sum = _mm_setzero_si128();
+	for (size_t y = 0; y < PROXY_BLOCK; y += 2) {
+		const __m128i va = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(a + y * stride)),
+						      _mm_loadl_epi64((const __m128i *)(a + (y + 1) * stride)));
+		const __m128i vb = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)(b + y * stride)),
+						      _mm_loadl_epi64((const __m128i *)(b + (y + 1) * stride)));
+		sum = _mm_add_epi64(sum, _mm_sad_epu8(va, vb));
+	}
+	return (uint32_t)(_mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8)));
+}
+
+static void build_proxy(const struct obs_source_frame *frame, uint8_t *proxy, uint32_t pw, uint32_t ph)
+{
+	for (uint32_t y = 0; y < ph; y++) {
+		const uint8_t *row = frame->data[0] + (size_t)y * 2 * frame->linesize[0];
+		uint8_t *dst = proxy + (size_t)y * pw;
+		switch (frame->format) {
+		case VIDEO_FORMAT_RGBA:
+		case VIDEO_FORMAT_BGRA:
+		case VIDEO_FORMAT_BGRX:
+			for (uint32_t x = 0; x < pw; x++) {
+				const uint8_t *px = row + (size_t)x * 8;
+				dst[x] = (uint8_t)((px[0] + 2 * px[1] + px[2]) >> 2);
+			}
+			break;
+		case VIDEO_FORMAT_YVYU:
+		case VIDEO_FORMAT_YUY2:
+			for (uint32_t x = 0; x < pw; x++)
+				dst[x] = row[(size_t)x * 4];
+			break;
+		case VIDEO_FORMAT_UYVY:
+			for (uint32_t x = 0; x < pw; x++)
+				dst[x] = row[(size_t)x * 4 + 1];
+			break;
+		default:
+			for (uint32_t x = 0; x < pw; x++)
+				dst[x] = row[(size_t)x * 2];
+			break;
+		}
+	}
+}
+
+// finds per block the half vector h where a at -h best matches b at +h
+static void estimate_motion(const uint8_t *a, const uint8_t *b, uint32_t pw, uint32_t ph, uint32_t bw, uint32_t bh,
+			    struct interp_vector *vectors)
+{
+	for (uint32_t by = 0; by < bh; by++) {
+		for (uint32_t bx = 0; bx < bw; bx++) {
+			const int x0 = (int)(bx * PROXY_BLOCK);
+			const int y0 = (int)(by * PROXY_BLOCK);
+			const size_t center = (size_t)y0 * pw + (size_t)x0;
+			uint32_t best = sad_block(a + center, b + center, pw);
+			struct interp_vector v = {0, 0};
+			for (int hy = -SEARCH_RANGE; hy <= SEARCH_RANGE; hy++) {
+				const int ay = hy < 0 ? -hy : hy;
+				if (y0 < ay || y0 + ay + PROXY_BLOCK > (int)ph)
+					continue;
+				for (int hx = -SEARCH_RANGE; hx <= SEARCH_RANGE; hx++) {
+					const int ax = hx < 0 ? -hx : hx;
+					if ((!hx && !hy) || x0 < ax || x0 + ax + PROXY_BLOCK > (int)pw)
+						continue;
+					const uint32_t penalty = (uint32_t)(SEARCH_PENALTY * (ax + ay));
+					if (penalty >= best)
+						continue;
+					const uint32_t cost = sad_block(a + (size_t)(y0 - hy) * pw + (size_t)(x0 - hx),
+									b + (size_t)(y0 + hy) * pw + (size_t)(x0 + hx), pw) +
+							      penalty;
+					if (cost < best) {
+						best = cost;
+						v.x = (int8_t)hx;
+						v.y = (int8_t)hy;
+					}
+				}
+			}
+			vectors[by * bw + bx] = v;
+		}
+	}
+}
+
+// moves offset so the range [start + offset, end + offset) stays inside [0, size)
+static inline int clamp_offset(int offset, uint32_t start, uint32_t end, uint32_t size)
+{
+	if ((int)start + offset < 0)
+		return -(int)start;
+	if ((int)end + offset > (int)size)
+		return (int)size - (int)end;
+	return offset;
+}
+
+static void compensate(struct obs_source_frame *out, const struct obs_source_frame *a, const struct obs_source_frame *b,
+		       const struct interp_plane *planes, size_t plane_count, const struct interp_vector *vectors, uint32_t bw,
+		       uint32_t bh, uint32_t step, uint32_t steps)
+{
+	const int w = (int)(256 * step / steps);
+	const uint32_t blocks_x = (out->width + FRAME_BLOCK - 1) / FRAME_BLOCK;
+	const uint32_t blocks_y = (out->height + FRAME_BLOCK - 1) / FRAME_BLOCK;
+	for (uint32_t by = 0; by < blocks_y; by++) {
+		for (uint32_t bx = 0; bx < blocks_x; bx++) {
+			int mx = 0;
+			int my = 0;
+			if (vectors) {
+				const struct interp_vector *v =
+					&vectors[(by < bh ? by : bh - 1) * bw + (bx < bw ? bx : bw - 1)];
+				// the proxy is half size and h is half the motion from a to b
+				mx = v->x * 4;
+				my = v->y * 4;
+			}
+			const int dax = -mx * (int)step / (int)steps;
+			const int day = -my * (int)step / (int)steps;
+			const int dbx = mx * (int)(steps - step) / (int)steps;
+			const int dby = my * (int)(steps - step) / (int)steps;
+			for (size_t p = 0; p < plane_count; p++) {
+				const struct interp_plane *plane = &planes[p];
+				const uint32_t width = (out->width + plane->sx - 1) / plane->sx;
+				const uint32_t height = (out->height + plane->sy - 1) / plane->sy;
+				const uint32_t x0 = bx * FRAME_BLOCK / plane->sx;
+				const uint32_t y0 = by * FRAME_BLOCK / plane->sy;
+				uint32_t x1 = (bx + 1) * FRAME_BLOCK / plane->sx;
+				uint32_t y1 = (by + 1) * FRAME_BLOCK / plane->sy;
+				if (x1 > width)
+					x1 = width;
+				if (y1 > height)
+					y1 = height;
+				if (x0 >= x1 || y0 >= y1)
+					continue;
+				const int oax = clamp_offset(dax / (int)plane->sx, x0, x1, width);
+				const int oay = clamp_offset(day / (int)plane->sy, y0, y1, height);
+				const int obx = clamp_offset(dbx / (int)plane->sx, x0, x1, width);
+				const int oby = clamp_offset(dby / (int)plane->sy, y0, y1, height);
+				const size_t bytes = (size_t)(x1 - x0) * plane->bpp;
+				for (uint32_t y = y0; y < y1; y++) {
+					blend_bytes(out->data[p] + (size_t)y * out->linesize[p] + (size_t)x0 * plane->bpp,
+						    a->data[p] + (size_t)((int)y + oay) * a->linesize[p] +
+							    (size_t)((int)x0 + oax) * plane->bpp,
+						    b->data[p] + (size_t)((int)y + oby) * b->linesize[p] +
+							    (size_t)((int)x0 + obx) * plane->bpp,
+						    bytes, w);
+				}
+			}
+		}
+	}
+}
+
+// fills frames[1 .. steps - 1] and returns the number of frames synthesized
+static size_t interp_synthesize(const struct obs_source_frame *from, const struct obs_source_frame *to, uint32_t steps, int mode,
+				struct obs_source_frame **frames)
+{
+	struct interp_plane planes[MAX_AV_PLANES];
+	const size_t plane_count = interp_planes(from->format, planes);
+	if (!plane_count || from->format != to->format || from->width != to->width || from->height != to->height)
+		return 0;
+
+	struct interp_vector *vectors = NULL;
+	const uint32_t pw = from->width / 2;
+	const uint32_t ph = from->height / 2;
+	const uint32_t bw = pw / PROXY_BLOCK;
+	const uint32_t bh = ph / PROXY_BLOCK;
+	if (mode == INTERP_MODE_MOTION && bw && bh) {
+		uint8_t *proxy = bmalloc((size_t)pw * ph * 2);
+		build_proxy(from, proxy, pw, ph);
+		build_proxy(to, proxy + (size_t)pw * ph, pw, ph);
+		vectors = bmalloc((size_t)bw * bh * sizeof(struct interp_vector));
+		estimate_motion(proxy, proxy + (size_t)pw * ph, pw, ph, bw, bh, vectors);
+		bfree(proxy);
+	}
+
+	for (uint32_t step = 1; step < steps; step++) {
+		struct obs_source_frame *frame = obs_source_frame_create(from->format, from->width, from->height);
+		frame->refs = 1;
+		frame->timestamp = from->timestamp + (to->timestamp - from->timestamp) * step / steps;
+		frame->full_range = from->full_range;
+		frame->flip = from->flip;
+		memcpy(frame->color_matrix, from->color_matrix, sizeof(frame->color_matrix));
+		memcpy(frame->color_range_min, from->color_range_min, sizeof(frame->color_range_min));
+		memcpy(frame->color_range_max, from->color_range_max, sizeof(frame->color_range_max));
+		compensate(frame, from, to, planes, plane_count, vectors, bw, bh, step, steps);
+		frames[step] = frame;
+	}
+	bfree(vectors);
+	return steps - 1;
+}
+
+static void release_frame(struct obs_source_frame *frame)
+{
+	if (frame && os_atomic_dec_long(&frame->refs) <= 0)
+		obs_source_frame_destroy(frame);
+}
+
+static void clear_pair(struct replay_interp_pair *pair)
+{
+	release_frame(pair->from);
+	release_frame(pair->to);
+	for (size_t i = 0; i < REPLAY_INTERP_MAX_STEPS; i++) {
+		if (pair->frames[i])
+			obs_source_frame_destroy(pair->frames[i]);
+	}
+	memset(pair, 0, sizeof(*pair));
+}
+
+static void *interp_thread(void *data)
+{
+	struct replay_interp *interp = data;
+	os_set_thread_name("replay_source: interpolation");
+	while (os_sem_wait(interp->jobs) == 0 && !interp->stop) {
+		// the pair closest to the playhead first
+		pthread_mutex_lock(&interp->mutex);
+		struct replay_interp_pair *pair = NULL;
+		for (size_t i = 0; i < REPLAY_INTERP_PAIRS; i++) {
+			if (interp->pairs[i].state == PAIR_QUEUED &&
+			    (!pair || interp->pairs[i].from->timestamp < pair->from->timestamp))
+				pair = &interp->pairs[i];
+		}
+		if (!pair) {
+			pthread_mutex_unlock(&interp->mutex);
+			continue;
+		}
+		pair->state = PAIR_BUSY;
+		const struct obs_source_frame *from = pair->from;
+		const struct obs_source_frame *to = pair->to;
+		const uint32_t steps = pair->steps;
+		const int mode = pair->mode;
+		pthread_mutex_unlock(&interp->mutex);
+
+		struct obs_source_frame *frames[REPLAY_INTERP_MAX_STEPS] = {0};
+		const uint64_t start = os_gettime_ns();
+		const size_t count = interp_synthesize(from, to, steps, mode, frames);
+		const uint64_t elapsed = os_gettime_ns() - start;
+
+		pthread_mutex_lock(&interp->mutex);
+		memcpy(pair->frames, frames, sizeof(frames));
+		pair->state = PAIR_READY;
+		interp->frames_synthesized += count;
+		if (count)
+			interp->synthesize_ns += elapsed;
+		pthread_mutex_unlock(&interp->mutex);
+	}
+	return NULL;
+}
+
+void replay_interp_init(struct replay_interp *interp)
+{
+	memset(interp, 0, sizeof(*interp));
+	pthread_mutex_init(&interp->mutex, NULL);
+	os_sem_init(&interp->jobs, 0);
+}
+
+void replay_interp_free(struct replay_interp *interp)
+{
+	interp->stop = true;
+	for (size_t i = 0; i < interp->thread_count; i++)
+		os_sem_post(interp->jobs);
+	for (size_t i = 0; i < interp->thread_count; i++)
+		pthread_join(interp->threads[i], NULL);
+	interp->thread_count = 0;
+	for (size_t i = 0; i < REPLAY_INTERP_PAIRS; i++)
+		clear_pair(&interp->pairs[i]);
+	os_sem_destroy(interp->jobs);
+	pthread_mutex_destroy(&interp->mutex);
+}
+
+// the worker pool is only started once interpolation is first enabled
+void replay_interp_set_mode(struct replay_interp *interp, int mode)
+{
+	pthread_mutex_lock(&interp->mutex);
+	interp->mode = mode;
+	if (mode != INTERP_MODE_NONE && !interp->thread_count && interp->jobs) {
+		int threads = os_get_logical_cores() - 1;
+		if (threads < 1)
+			threads = 1;
+		if (threads > REPLAY_INTERP_MAX_THREADS)
+			threads = REPLAY_INTERP_MAX_THREADS;
+		for (int i = 0; i < threads; i++) {
+			if (pthread_create(&interp->threads[interp->thread_count], NULL, interp_thread, interp) == 0)
+				interp->thread_count++;
+		}
+	}
+	pthread_mutex_unlock(&interp->mutex);
+}
+
+// queues the pairs starting at frames[index] that are not synthesized yet and evicts the ones behind
+void replay_interp_prefetch(struct replay_interp *interp, struct obs_source_frame **frames, uint64_t count, uint64_t index,
+			    uint32_t steps)
+{
+	if (steps > REPLAY_INTERP_MAX_STEPS)
+		steps = REPLAY_INTERP_MAX_STEPS;
+	pthread_mutex_lock(&interp->mutex);
+	if (interp->mode == INTERP_MODE_NONE || !interp->thread_count) {
+		pthread_mutex_unlock(&interp->mutex);
+		return;
+	}
+	for (size_t i = 0; i < REPLAY_INTERP_PAIRS; i++) {
+		struct replay_interp_pair *pair = &interp->pairs[i];
+		if (pair->state == PAIR_EMPTY || pair->state == PAIR_BUSY)
+			continue;
+		bool wanted = false;
+		for (uint64_t j = index; pair->steps == steps && pair->mode == interp->mode && j + 1 < count &&
+					 j < index + REPLAY_INTERP_LOOKAHEAD;
+		     j++) {
+			if (pair->from == frames[j] && pair->to == frames[j + 1])
+				wanted = true;
+		}
+		if (!wanted)
+			clear_pair(pair);
+	}
+	for (uint64_t j = index; j + 1 < count && j < index + REPLAY_INTERP_LOOKAHEAD; j++) {
+		struct replay_interp_pair *empty = NULL;
+		bool queued = false;
+		for (size_t i = 0; i < REPLAY_INTERP_PAIRS; i++) {
+			struct replay_interp_pair *pair = &interp->pairs[i];
+			if (pair->state == PAIR_EMPTY) {
+				if (!empty)
+					empty = pair;
+			} else if (pair->from == frames[j] && pair->to == frames[j + 1] && pair->steps == steps &&
+				   pair->mode == interp->mode) {
+				queued = true;
+			}
+		}
+		if (queued)
+			continue;
+		if (!empty)
+			break;
+		os_atomic_inc_long(&frames[j]->refs);
+		os_atomic_inc_long(&frames[j + 1]->refs);
+		empty->from = frames[j];
+		empty->to = frames[j + 1];
+		empty->steps = steps;
+		empty->mode = interp->mode;
+		empty->state = PAIR_QUEUED;
+		os_sem_post(interp->jobs);
+	}
+	pthread_mutex_unlock(&interp->mutex);
+}
+
+// synthesized frame at step / steps between from and to, NULL when it is not ready in time
+struct obs_source_frame *replay_interp_get(struct replay_interp *interp, struct obs_source_frame *from,
+					   struct obs_source_frame *to, uint32_t steps, uint32_t step)
+{
+	if (steps > REPLAY_INTERP_MAX_STEPS)
+		steps = REPLAY_INTERP_MAX_STEPS;
+	if (!step || step >= steps)
+		return NULL;
+	struct obs_source_frame *frame = NULL;
+	pthread_mutex_lock(&interp->mutex);
+	for (size_t i = 0; i < REPLAY_INTERP_PAIRS; i++) {
+		struct replay_interp_pair *pair = &interp->pairs[i];
+		if (pair->state == PAIR_READY && pair->from == from && pair->to == to && pair->steps == steps &&
+		    pair->mode == interp->mode)
+			frame = pair->frames[step];
+	}
+	if (frame)
+		interp->hits++;
+	else
+		interp->misses++;
+	pthread_mutex_unlock(&interp->mutex);
+	return frame;
+}
+
+void replay_interp_log_stats(struct replay_interp *interp, const char *name)
+{
+	if (!interp->frames_synthesized || !interp->synthesize_ns)
+		return;
+	const double ms = (double)interp->synthesize_ns / 1000000.0 / (double)interp->frames_synthesized;
+	blog(LOG_INFO,
+	     "[replay_source: '%s'] interpolation synthesized %" PRIu64
+	     " frames at %.2f ms per frame on %d threads (%.1f frames/s capacity), %" PRIu64 " shown, %" PRIu64 " late",
+	     name, interp->frames_synthesized, ms, (int)interp->thread_count, (double)interp->thread_count * 1000.0 / ms,
+	     interp->hits, interp->misses);
+}
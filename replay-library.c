@@ -0,0 +1,143 @@
+#include <obs-module.h>
+#include "replay.h"
+
+/* an id is the slot index in the low half and the generation of the slot in
+ * the high half, a slot gets a new generation every time it is reused so ids
+ * of removed replays never match again */
+
+#define REPLAY_LIBRARY_NO_SLOT UINT32_MAX
+
+void replay_library_init(struct replay_library *library)
+{
+	memset(library, 0, sizeof(*library));
+	library->free_slot = REPLAY_LIBRARY_NO_SLOT;
+}
+
+static void replay_library_free_entry(struct replay_library_entry *entry)
+{
+	bfree(entry->source_name);
+	bfree(entry->tags);
+	bfree(entry->spill_path);
+	replay_thumbnails_release(entry->thumbnails);
+	entry->source_name = NULL;
+	entry->tags = NULL;
+	entry->spill_path = NULL;
+	entry->thumbnails = NULL;
+	entry->spilling = false;
+	entry->paging_in = false;
+	entry->replay = NULL;
+	entry->id = 0;
+}
+
+// the replays are owned by the caller and have to be removed first
+void replay_library_free(struct replay_library *library)
+{
+	for (uint32_t i = 0; i < library->capacity; i++)
+		replay_library_free_entry(&library->entries[i]);
+	bfree(library->entries);
+	bfree(library->order);
+	replay_library_init(library);
+}
+
+static uint32_t replay_library_take_slot(struct replay_library *library)
+{
+	if (library->free_slot == REPLAY_LIBRARY_NO_SLOT) {
+		const uint32_t capacity = library->capacity ? library->capacity * 2 : 16;
+		library->entries = brealloc(library->entries, capacity * sizeof(struct replay_library_entry));
+		memset(library->entries + library->capacity, 0,
+		       (capacity - library->capacity) * sizeof(struct replay_library_entry));
+		for (uint32_t i = capacity; i > library->capacity; i--) {
+			library->entries[i - 1].next_free = library->free_slot;
+			library->free_slot = i - 1;
+		}
+		library->capacity = capacity;
+	}
+	const uint32_t slot = library->free_slot;
+	library->free_slot = library->entries[slot].next_free;
+	return slot;
+}
+
+struct replay_library_entry *replay_library_add(struct replay_library *library, struct replay *replay, const char *source_name,
+						 uint64_t capture_time)
+{
+	if (library->first + library->count == library->order_capacity) {
+		if (library->first > library->count) {
+			// more than half of the window moved past the front, slide it back instead of growing
+			memmove(library->order, library->order + library->first, library->count * sizeof(uint32_t));
+			library->first = 0;
+		} else {
+			library->order_capacity = library->order_capacity ? library->order_capacity * 2 : 16;
+			library->order = brealloc(library->order, library->order_capacity * sizeof(uint32_t));
+		}
+	}
+	const uint32_t slot = replay_library_take_slot(library);
+	struct replay_library_entry *entry = &library->entries[slot];
+	entry->generation++;
+	entry->id = ((uint64_t)entry->generation << 32) | slot;
+	entry->replay = replay;
+	entry->source_name = source_name && *source_name ? bstrdup(source_name) : NULL;
+	entry->capture_time = capture_time;
+	entry->last_used = capture_time;
+	entry->tags = NULL;
+	library->order[library->first + library->count++] = slot;
+	return entry;
+}
+
+// removes the replay at position and returns it to the caller to release
+struct replay *replay_library_remove(struct replay_library *library, size_t position)
+{
+	if (position >= library->count)
+		return NULL;
+	uint32_t *order = library->order + library->first;
+	const uint32_t slot = order[position];
+	// close the gap from the nearest end, removing the first or last replay moves nothing
+	if (position < library->count / 2) {
+		memmove(order + 1, order, position * sizeof(uint32_t));
+		library->first++;
+	} else {
+		memmove(order + position, order + position + 1, (library->count - position - 1) * sizeof(uint32_t));
+	}
+	library->count--;
+	if (!library->count)
+		library->first = 0;
+
+	struct replay_library_entry *entry = &library->entries[slot];
+	struct replay *replay = entry->replay;
+	replay_library_free_entry(entry);
+	entry->next_free = library->free_slot;
+	library->free_slot = slot;
+	return replay;
+}
+
+struct replay_library_entry *replay_library_at(struct replay_library *library, size_t position)
+{
+	if (position >= library->count)
+		return NULL;
+	return &library->entries[library->order[library->first + position]];
+}
+
+struct replay_library_entry *replay_library_find(struct replay_library *library, uint64_t id)
+{
+	const uint32_t slot = (uint32_t)(id & 0xFFFFFFFF);
+	if (!id || slot >= library->capacity || library->entries[slot].id != id)
+		return NULL;
+	return &library->entries[slot];
+}
+
+// position of the replay with id, the count when it is not in the library
+size_t replay_library_position(const struct replay_library *library, uint64_t id)
+{
+	const uint32_t *order = library->order + library->first;
+	const uint32_t slot = (uint32_t)(id & 0xFFFFFFFF);
+	for (size_t i = 0; id && i < library->count; i++) {
+		if (order[i] == slot && library->entries[slot].id == id)
+			return i;
+	}
+	return library->count;
+}
+
+void replay_library_set_tags(struct replay_library_entry *entry, const char *tags)
+{
+	bfree(entry->tags);
+	entry->tags = tags && *tags ? bstrdup(tags) : NULL;
+}
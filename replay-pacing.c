@@ -0,0 +1,162 @@
+#include <obs-module.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <math.h>
+#include "replay.h"
+
+/* the pacing plan picks the source frame for each upcoming render tick like
+ * a pulldown: a phase in frames advances by the nominal number of source
+ * frames per tick and is only pulled back once it drifts outside a dead band
+ * around the frame timestamps, so capture jitter in those timestamps does
+ * not turn into uneven cadence */
+
+void replay_pacing_reset(struct replay_pacing *pacing)
+{
+	pacing->timestamps = NULL;
+	pacing->count = 0;
+	pacing->planned = 0;
+	pacing->anchored = false;
+	pacing->paced.active = false;
+	pacing->unpaced.active = false;
+}
+
+// fractional frame index at a source timestamp
+static double frame_position(const uint64_t *timestamps, uint64_t count, uint64_t ts)
+{
+	uint64_t i = 0;
+	uint64_t j = count;
+	while (i < j) {
+		const uint64_t mid = i + (j - i) / 2;
+		if (timestamps[mid] < ts)
+			i = mid + 1;
+		else
+			j = mid;
+	}
+	if (!i)
+		return 0.0;
+	if (i >= count)
+		return (double)(count - 1);
+	return (double)(i - 1) + (double)(ts - timestamps[i - 1]) / (double)(timestamps[i] - timestamps[i - 1]);
+}
+
+// average frame duration around a frame
+static double frame_duration(const uint64_t *timestamps, uint64_t count, uint64_t index)
+{
+	const uint64_t from = index > REPLAY_PACING_WINDOW ? index - REPLAY_PACING_WINDOW : 0;
+	const uint64_t to = index + REPLAY_PACING_WINDOW < count ? index + REPLAY_PACING_WINDOW : count - 1;
+	if (to <= from)
+		return 0.0;
+	return (double)(timestamps[to] - timestamps[from]) / (double)(to - from);
+}
+
+static void replay_pacing_plan(struct replay_pacing *pacing, const struct replay_time_map *map, uint64_t tick_timestamp)
+{
+	const uint64_t first = pacing->timestamps[0];
+	// the phase carries over when the new plan continues the previous one
+	if (tick_timestamp != pacing->next_tick)
+		pacing->anchored = false;
+	pacing->plan_start = tick_timestamp;
+	for (size_t k = 0; k < REPLAY_PACING_PLAN; k++) {
+		const uint64_t tick = tick_timestamp + k * pacing->interval;
+		const int64_t output = (int64_t)(tick - pacing->start_timestamp);
+		int64_t source = replay_time_map_source(map, (int64_t)(output * pacing->speed_percent / 100.0));
+		if (source < 0)
+			source = 0;
+		const double actual = frame_position(pacing->timestamps, pacing->count, first + (uint64_t)source);
+		if (!pacing->anchored) {
+			pacing->phase = actual;
+			pacing->anchored = true;
+		} else {
+			uint64_t index = (uint64_t)pacing->phase;
+			if (index >= pacing->count)
+				index = pacing->count - 1;
+			const double duration = frame_duration(pacing->timestamps, pacing->count, index);
+			if (duration > 0.0)
+				pacing->phase += (double)pacing->interval * pacing->speed_percent / 100.0 *
+						 replay_time_map_speed(map, source) / duration;
+			const double error = actual - pacing->phase;
+			// gaps in the source or a seek re-anchor the phase
+			if (fabs(error) > 1.0)
+				pacing->phase = actual;
+			else if (error > REPLAY_PACING_DEAD_BAND)
+				pacing->phase += error - REPLAY_PACING_DEAD_BAND;
+			else if (error < -REPLAY_PACING_DEAD_BAND)
+				pacing->phase += error + REPLAY_PACING_DEAD_BAND;
+		}
+		uint64_t frame = (uint64_t)(pacing->phase + 0.5);
+		if (frame >= pacing->count)
+			frame = pacing->count - 1;
+		if (k && frame < pacing->plan[k - 1])
+			frame = pacing->plan[k - 1];
+		pacing->plan[k] = frame;
+	}
+	pacing->planned = REPLAY_PACING_PLAN;
+	pacing->next_tick = tick_timestamp + REPLAY_PACING_PLAN * pacing->interval;
+}
+
+// planned source frame for the render tick at tick_timestamp, plans the next ticks when needed
+uint64_t replay_pacing_frame(struct replay_pacing *pacing, const uint64_t *timestamps, uint64_t count,
+			     const struct replay_time_map *map, float speed_percent, uint64_t start_timestamp,
+			     uint64_t tick_timestamp)
+{
+	if (!count)
+		return 0;
+	const uint64_t interval = obs_get_frame_interval_ns();
+	if (pacing->timestamps != timestamps || pacing->count != count || pacing->speed_percent != speed_percent ||
+	    pacing->start_timestamp != start_timestamp || pacing->interval != interval || !interval) {
+		replay_pacing_reset(pacing);
+		pacing->timestamps = timestamps;
+		pacing->count = count;
+		pacing->speed_percent = speed_percent;
+		pacing->start_timestamp = start_timestamp;
+		pacing->interval = interval ? interval : 1;
+	}
+
+	size_t k = REPLAY_PACING_PLAN;
+	if (pacing->planned && tick_timestamp >= pacing->plan_start) {
+		const uint64_t offset = tick_timestamp - pacing->plan_start;
+		const uint64_t tick = (offset + pacing->interval / 2) / pacing->interval;
+		// a tick off the planned grid starts a new plan
+		if (llabs((int64_t)(offset - tick * pacing->interval)) < (int64_t)(pacing->interval / 4))
+			k = tick < REPLAY_PACING_PLAN ? (size_t)tick : REPLAY_PACING_PLAN;
+	}
+	if (k >= pacing->planned) {
+		replay_pacing_plan(pacing, map, tick_timestamp);
+		k = 0;
+	}
+	return pacing->plan[k];
+}
+
+// records when a frame got presented compared to when it should have been
+void replay_pacing_track(struct replay_pacing_track *track, uint64_t frame, uint64_t presented, uint64_t ideal)
+{
+	if (track->active && frame == track->frame)
+		return;
+	const int64_t error = (int64_t)(presented - ideal);
+	if (track->active) {
+		const int64_t jitter = error - track->error;
+		track->jitter_sum += (double)jitter * (double)jitter;
+		if (llabs(jitter) > track->jitter_max)
+			track->jitter_max = llabs(jitter);
+		if (frame > track->frame + 1)
+			track->skipped += frame - track->frame - 1;
+		track->frames++;
+	}
+	track->active = true;
+	track->frame = frame;
+	track->error = error;
+}
+
+void replay_pacing_log_stats(struct replay_pacing *pacing, const char *name)
+{
+	const struct replay_pacing_track *paced = &pacing->paced;
+	const struct replay_pacing_track *unpaced = &pacing->unpaced;
+	if (!paced->frames || !unpaced->frames)
+		return;
+	blog(LOG_INFO,
+	     "[replay_source: '%s'] frame pacing jitter %.3f ms rms %.3f ms max over %" PRIu64
+	     " frames, %" PRIu64 " skipped, unpaced %.3f ms rms %.3f ms max, %" PRIu64 " skipped",
+	     name, sqrt(paced->jitter_sum / (double)paced->frames) / 1000000.0, (double)paced->jitter_max / 1000000.0,
+	     paced->frames, paced->skipped, sqrt(unpaced->jitter_sum / (double)unpaced->frames) / 1000000.0,
+	     (double)unpaced->jitter_max / 1000000.0, unpaced->skipped);
+}
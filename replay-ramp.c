@@ -0,0 +1,185 @@
+#include <obs-module.h>
+#include <util/dstr.h>
+#include <ctype.h>
+#include <math.h>
+#include "replay.h"
+
+/* a speed ramp is a list of "time:speed" points, time in ms from the start
+ * of the replay or from the end when prefixed with '-', speed in percent,
+ * the speed changes linearly between points */
+void replay_speed_ramp_parse(struct replay_speed_ramp *ramp, const char *text)
+{
+	memset(ramp, 0, sizeof(*ramp));
+	if (!text)
+		return;
+	const char *p = text;
+	while (*p && ramp->count < REPLAY_RAMP_MAX_POINTS) {
+		while (*p && (isspace((unsigned char)*p) || *p == ',' || *p == ';'))
+			p++;
+		if (!*p)
+			break;
+		const bool from_end = *p == '-';
+		if (from_end)
+			p++;
+		char *end = NULL;
+		const double time = strtod(p, &end);
+		if (end == p || *end != ':') {
+			// skip the malformed point
+			while (*p && *p != ',' && *p != ';')
+				p++;
+			continue;
+		}
+		p = end + 1;
+		const double speed = strtod(p, &end);
+		if (end == p || speed < SETTING_SPEED_MIN || speed > SETTING_SPEED_MAX) {
+			while (*p && *p != ',' && *p != ';')
+				p++;
+			continue;
+		}
+		p = end;
+		ramp->time[ramp->count] = (int64_t)(time * 1000000.0);
+		ramp->from_end[ramp->count] = from_end;
+		ramp->speed[ramp->count] = speed / 100.0;
+		ramp->count++;
+	}
+}
+
+void replay_time_map_free(struct replay_time_map *map)
+{
+	bfree(map->source);
+	bfree(map->output);
+	bfree(map->speed);
+	memset(map, 0, sizeof(*map));
+}
+
+static inline size_t ramp_segments(int64_t from, int64_t to, double speed_from, double speed_to)
+{
+	if (to <= from)
+		return 0;
+	if (speed_from == speed_to)
+		return 1;
+	return (size_t)((to - from + REPLAY_RAMP_STEP - 1) / REPLAY_RAMP_STEP);
+}
+
+// precomputes the knots of the piecewise linear map for a replay of the given duration, no ramp leaves the identity map
+void replay_time_map_build(struct replay_time_map *map, const struct replay_speed_ramp *ramp, uint64_t duration)
+{
+	replay_time_map_free(map);
+	if (!ramp->count)
+		return;
+
+	int64_t position[REPLAY_RAMP_MAX_POINTS];
+	double speed[REPLAY_RAMP_MAX_POINTS];
+	size_t count = 0;
+	for (size_t i = 0; i < ramp->count; i++) {
+		int64_t p = ramp->from_end[i] ? (int64_t)duration - ramp->time[i] : ramp->time[i];
+		if (p < 0)
+			p = 0;
+		if (p > (int64_t)duration)
+			p = (int64_t)duration;
+		// insertion sort keeps points at the same position in the order they were given
+		size_t j = count;
+		while (j > 0 && position[j - 1] > p) {
+			position[j] = position[j - 1];
+			speed[j] = speed[j - 1];
+			j--;
+		}
+		position[j] = p;
+		speed[j] = ramp->speed[i];
+		count++;
+	}
+
+	size_t knots = 2;
+	for (size_t i = 0; i + 1 < count; i++)
+		knots += ramp_segments(position[i], position[i + 1], speed[i], speed[i + 1]);
+	map->source = bmalloc(knots * sizeof(int64_t));
+	map->output = bmalloc(knots * sizeof(int64_t));
+	map->speed = bmalloc(knots * sizeof(double));
+
+	size_t k = 0;
+	map->source[k] = 0;
+	map->output[k] = 0;
+	map->speed[k] = speed[0];
+	if (position[0] > 0) {
+		k++;
+		map->source[k] = position[0];
+		map->output[k] = (int64_t)((double)position[0] / speed[0]);
+		map->speed[k] = speed[0];
+	}
+	for (size_t i = 0; i + 1 < count; i++) {
+		const size_t n = ramp_segments(position[i], position[i + 1], speed[i], speed[i + 1]);
+		for (size_t s = 0; s < n; s++) {
+			const int64_t from = position[i] + (position[i + 1] - position[i]) * (int64_t)s / (int64_t)n;
+			const int64_t to = position[i] + (position[i + 1] - position[i]) * (int64_t)(s + 1) / (int64_t)n;
+			// each segment plays at the speed halfway through it
+			const double mid = ((double)s + 0.5) / (double)n;
+			map->speed[k] = speed[i] + (speed[i + 1] - speed[i]) * mid;
+			map->source[k + 1] = to;
+			map->output[k + 1] = map->output[k] + (int64_t)((double)(to - from) / map->speed[k]);
+			map->speed[k + 1] = speed[i + 1];
+			k++;
+		}
+	}
+	map->speed[k] = speed[count - 1];
+	map->count = k + 1;
+}
+
+static size_t map_segment(const int64_t *knots, size_t count, int64_t t)
+{
+	// last knot at or before t
+	size_t i = 1;
+	size_t j = count;
+	while (i < j) {
+		const size_t mid = i + (j - i) / 2;
+		if (knots[mid] <= t)
+			i = mid + 1;
+		else
+			j = mid;
+	}
+	return i - 1;
+}
+
+// output time at the base speed for a source offset from the first frame
+int64_t replay_time_map_output(const struct replay_time_map *map, int64_t source)
+{
+	if (!map->count)
+		return source;
+	const size_t k = map_segment(map->source, map->count, source);
+	return map->output[k] + (int64_t)((double)(source - map->source[k]) / map->speed[k]);
+}
+
+// source offset from the first frame for an output time at the base speed
+int64_t replay_time_map_source(const struct replay_time_map *map, int64_t output)
+{
+	if (!map->count)
+		return output;
+	const size_t k = map_segment(map->output, map->count, output);
+	return map->source[k] + (int64_t)((double)(output - map->output[k]) * map->speed[k]);
+}
+
+// speed ratio of the ramp at a source offset, 1.0 without a ramp
+double replay_time_map_speed(const struct replay_time_map *map, int64_t source)
+{
+	if (!map->count)
+		return 1.0;
+	return map->speed[map_segment(map->source, map->count, source)];
+}
+
+// the map of a replay that starts offset later in the source, so the ramp stays at the same frames
+void replay_time_map_slice(struct replay_time_map *map, const struct replay_time_map *from, int64_t offset)
+{
+	replay_time_map_free(map);
+	if (!from->count)
+		return;
+	const size_t first = map_segment(from->source, from->count, offset);
+	const int64_t output = replay_time_map_output(from, offset);
+	map->count = from->count - first;
+	map->source = bmalloc(map->count * sizeof(int64_t));
+	map->output = bmalloc(map->count * sizeof(int64_t));
+	map->speed = bmalloc(map->count * sizeof(double));
+	for (size_t i = 0; i < map->count; i++) {
+		map->source[i] = i ? from->source[first + i] - offset : 0;
+		map->output[i] = i ? from->output[first + i] - output : 0;
+		map->speed[i] = from->speed[first + i];
+	}
+}
@@ -7,6 +7,7 @@
 #include <media-io/video-frame.h>
 #include <media-io/video-scaler.h>
 #include <obs-frontend-api.h>
+#include <util/sse-intrin.h>
 #include "replay.h"
 #include <inttypes.h>
 #include <string.h>
@@ -25,6 +26,11 @@
 #define END_ACTION_LOOP_ALL 6
 #define END_ACTION_REVERSE_ALL 7
 
+// how long before the end of a replay the next one is prepared
+#define NEXT_REPLAY_PREFETCH (500 * MSEC_TO_NSEC)
+// the next replay starts at the current tick instead of the end time when that is longer ago
+#define NEXT_REPLAY_MAX_LATE (100 * MSEC_TO_NSEC)
+
 enum saving_status {
 	SAVING_STATUS_NONE = 0,
 	SAVING_STATUS_STARTING = 1,
@@ -33,17 +39,41 @@ enum saving_status {
 	SAVING_STATUS_STOPPING = 4
 };
 
+/* a source a replay source depends on, looked up by name once and then
+ * followed through a weak reference so it survives renames, a failed lookup
+ * is only retried once the bindings generation changed */
+struct replay_binding {
+	char *name;
+	obs_weak_source_t *weak;
+	long generation;
+};
+
+/* changes on source create, rename and every replay source update */
+static volatile long replay_bindings_generation = 0;
+
+/* replays are shared between the replay list, playback and saving, the
+ * frames, audio and trims are never modified after the replay is published */
 struct replay {
+	volatile long refs;
 	struct obs_source_frame **video_frames;
 	uint64_t video_frame_count;
 	struct obs_audio_data *audio_frames;
 	struct audio_convert_info oai;
 	uint64_t audio_frame_count;
+	/* contiguous copies of the frame timestamps for searching */
+	uint64_t *video_timestamps;
+	uint64_t *audio_timestamps;
 	uint64_t first_frame_timestamp;
 	uint64_t last_frame_timestamp;
 	uint64_t duration;
 	int64_t trim_front;
 	int64_t trim_end;
+	/* output time of the speed ramp the replay was loaded with */
+	struct replay_time_map time_map;
+	/* replays of the other camera angles over the same time range, the
+	 * replay in the list holds a reference to each, angles[0] is itself */
+	struct replay **angles;
+	size_t angle_count;
 };
 
 struct replay_source {
@@ -52,6 +82,24 @@ struct replay_source {
 	obs_source_t *source_audio_filter;
 	char *source_name;
 	char *source_audio_name;
+	/* name of the replay filters to read, another replay source shares its filters */
+	char *filter_name;
+	struct replay_filter_cursor cursor;
+	/* bindings_mutex guards the bindings, they are used from the render, hotkey and trigger threads */
+	pthread_mutex_t bindings_mutex;
+	struct replay_binding source_binding;
+	struct replay_binding source_audio_binding;
+	struct replay_binding filter_binding;
+	struct replay_binding audio_filter_binding;
+	struct replay_binding text_binding;
+	struct replay_binding next_scene_binding;
+	struct replay_binding load_switch_scene_binding;
+	struct replay_binding progress_binding;
+	char **angle_names;
+	struct replay_filter_cursor *angle_cursors;
+	struct replay_binding *angle_bindings;
+	size_t angle_name_count;
+	int angle;
 	float speed_percent;
 	bool backward;
 	bool backward_start;
@@ -81,6 +129,7 @@ struct replay_source {
 	obs_hotkey_id trim_front_hotkey;
 	obs_hotkey_id trim_end_hotkey;
 	obs_hotkey_id trim_reset_hotkey;
+	obs_hotkey_id trim_commit_hotkey;
 	obs_hotkey_id reverse_hotkey;
 	obs_hotkey_id forward_hotkey;
 	obs_hotkey_id backward_hotkey;
@@ -97,16 +146,72 @@ struct replay_source {
 	obs_hotkey_id prev_frame_hotkey;
 	obs_hotkey_id next_n_frames_hotkey;
 	obs_hotkey_id prev_n_frames_hotkey;
+	obs_hotkey_id next_angle_hotkey;
 	uint64_t start_timestamp;
 	uint64_t previous_frame_timestamp;
 	uint64_t pause_timestamp;
 	int64_t start_delay;
 	int64_t retrieve_delay;
 	int64_t frame_step_count;
-	uint64_t retrieve_timestamp;
-	uint64_t threshold_timestamp;
+	/* the timestamps are shared by the hotkeys, the audio, trigger and
+	 * video threads and only accessed with replay_atomic_*_u64 */
+	volatile uint64_t retrieve_timestamp;
+	volatile uint64_t threshold_timestamp;
+	/* duration and output duration at normal speed of the current replay,
+	 * set on every publish so the audio thread never takes a reference */
+	volatile uint64_t current_duration;
+	volatile uint64_t current_output_duration;
 	struct obs_source_audio audio;
 
+	/* retrieves from the hotkeys, the trigger thread and the tick are
+	 * serialized, they share the cursors and the filter bindings */
+	pthread_mutex_t retrieve_mutex;
+
+	/* sound triggers are posted from the audio thread and retrieved here */
+	pthread_t trigger_thread;
+	os_sem_t *trigger_sem;
+	volatile uint64_t trigger_timestamp;
+	volatile bool trigger_stop;
+	bool trigger_thread_active;
+
+	/* replays past replay_max are written to spill_directory by the spill
+	 * thread and read back when selected, spill_mutex guards the jobs and
+	 * the directory */
+	char *spill_directory;
+	int spill_max;
+	pthread_t spill_thread;
+	os_sem_t *spill_sem;
+	pthread_mutex_t spill_mutex;
+	struct replay_circlebuf spill_jobs;
+	volatile bool spill_stop;
+	bool spill_thread_active;
+	/* replay_id is the entry that is playing, page_in_id the selected entry
+	 * that is still being read back, replay_position only moves to it when
+	 * the tick publishes it after the spill thread set spill_in_done */
+	uint64_t replay_id;
+	uint64_t page_in_id;
+	volatile bool spill_in_done;
+	uint64_t spill_writes;
+	uint64_t spill_write_bytes;
+	uint64_t spill_write_ns;
+	uint64_t spill_reads;
+	uint64_t spill_read_ns;
+
+	/* thumbnail strips of new replays are made by the thumbnail thread
+	 * and kept in the library entry, thumbnail_mutex guards the jobs */
+	int thumbnail_count;
+	pthread_t thumbnail_thread;
+	os_sem_t *thumbnail_sem;
+	pthread_mutex_t thumbnail_mutex;
+	struct replay_circlebuf thumbnail_jobs;
+	volatile bool thumbnail_stop;
+	bool thumbnail_thread_active;
+	struct replay_thumbnail_scaler thumbnail_scaler;
+	long long thumbnail_serial;
+	uint64_t thumbnail_strips;
+	uint64_t thumbnail_ns;
+	uint64_t thumbnail_max_ns;
+
 	bool disabled;
 	bool play;
 	bool restart;
@@ -117,21 +222,74 @@ struct replay_source {
 
 	int replay_position;
 	int replay_max;
-#if LIBOBS_API_VER >= MAKE_SEMANTIC_VERSION(30, 1, 0)
-	struct deque replays;
-#else
-	struct circlebuf replays;
-#endif
-	struct replay current_replay;
-	struct replay saving_replay;
+	struct replay_library replays;
+	/* published replay snapshots, current_replay is only replaced with
+	 * the video mutex locked and saving_replay only from the video tick,
+	 * readers on other threads use replay_snapshot */
+	struct replay *volatile current_replay;
+	struct replay *volatile saving_replay;
+	volatile long snapshot_readers;
 
 	uint64_t video_frame_position;
 	uint64_t video_save_position;
 
 	/* stores the audio data */
 	uint64_t audio_frame_position;
+	/* samples to skip in the audio frame at audio_frame_position after a seek */
+	uint32_t audio_sample_offset;
+
+	/* backward audio is rendered per block, reverse_offset is the source
+	 * time already rendered counting back from the last frame */
+	struct replay *reverse_replay;
+	int64_t reverse_offset;
+	float *reverse_buffer;
 	struct obs_audio_data audio_output;
 
+	/* pitch preserving audio is rendered ahead by the stretch thread up to
+	 * stretch_until, stretch_source is the source time at the last reset
+	 * and stretch_output the output timestamp of the next hop */
+	bool preserve_pitch;
+	struct replay_speed_ramp speed_ramp;
+	pthread_t stretch_thread;
+	os_event_t *stretch_event;
+	pthread_mutex_t stretch_mutex;
+	volatile bool stretch_stop;
+	bool stretch_thread_active;
+	struct replay_stretch stretch;
+	struct replay *stretch_replay;
+	uint64_t stretch_source;
+	uint64_t stretch_output;
+	uint64_t stretch_until;
+	uint64_t stretch_end;
+	double stretch_speed;
+
+	/* synthesized frames between stored frames in slow motion */
+	struct replay_interp interp;
+	bool frame_pacing;
+	struct replay_pacing pacing;
+
+	/* the replay a play all end action switches to, resolved before the
+	 * current one ends so playback continues at its exact end time */
+	struct replay *next_replay;
+	int next_position;
+	uint64_t next_video_position;
+	uint64_t next_audio_position;
+	uint32_t next_audio_sample_offset;
+
+	/* live mode plays the capture ring of the filters in place instead of
+	 * retrieved replays, live_position is the capture time on screen and
+	 * live_frame the referenced frame shown at it */
+	bool live;
+	uint64_t live_delay;
+	double live_catch_up;
+	uint64_t live_position;
+	uint64_t live_tick;
+	uint64_t live_audio;
+	struct obs_source_frame *live_frame;
+
+	/* locked in this order when nested: replay_mutex guards the library and
+	 * the position in it, video_mutex the playback and audio_mutex the audio
+	 * position */
 	pthread_mutex_t video_mutex;
 	pthread_mutex_t audio_mutex;
 	pthread_mutex_t replay_mutex;
@@ -146,135 +304,353 @@ struct replay_source {
 	video_scaler_t *scaler;
 	bool lossless;
 	char *file_format;
+	/* full path of the next save, set by the control api, otherwise the directory and file format are used */
+	char *save_path;
 	char *directory;
 	uint64_t start_save_timestamp;
 	obs_encoder_t *aac;
 	char *progress_source_name;
+	/* scene items showing the progress source with a reference each, only touched with the video mutex held and
+	 * rebound there when progress_dirty is set by the item signals of the watched scenes or a new source */
+	obs_weak_source_t *progress_weak;
+	obs_sceneitem_t **progress_items;
+	size_t progress_item_count;
+	obs_weak_source_t **progress_scenes;
+	size_t progress_scene_count;
+	volatile bool progress_dirty;
+	int64_t progress_crop;
 	char *text_source_name;
 	char *text_format;
+	/* text_mutex guards the compiled format and the last text sent to the text source */
+	pthread_mutex_t text_mutex;
+	struct replay_text_template text_template;
+	struct dstr text_buffer;
+	struct dstr text_last;
+	obs_data_t *text_settings;
+	uint64_t text_renders;
+	uint64_t text_updates;
+	uint64_t text_update_ns;
+	uint64_t text_first_update;
 	bool sound_trigger;
 	bool filter_loaded;
-	bool free_after_save;
+	/* set when a source got created or removed so connecting the filters is retried once */
+	volatile bool bindings_dirty;
+	/* the last tick found nothing to play or output, ticks return right away until playback starts again */
+	bool idle;
+	uint64_t tick_count;
+	uint64_t tick_idle_count;
+	uint64_t tick_ns;
+	uint64_t tick_max_ns;
+	uint64_t control_calls;
+	uint64_t control_ns;
+	uint64_t action_updates;
+	uint64_t action_update_ns;
 };
 
-static void replace_text(struct dstr *str, size_t pos, size_t len, const char *new_text)
+static void replay_release(struct replay *replay);
+
+static void replay_free_replay(struct replay *replay)
 {
-	struct dstr front = {0};
-	struct dstr back = {0};
+	for (uint64_t i = 0; i < replay->video_frame_count; i++) {
+		struct obs_source_frame *frame = replay->video_frames[i];
+		if (frame && os_atomic_dec_long(&frame->refs) <= 0) {
+			obs_source_frame_destroy(frame);
+			replay->video_frames[i] = NULL;
+		}
+	}
+	replay->video_frame_count = 0;
+	if (replay->video_frames) {
+		bfree(replay->video_frames);
+		replay->video_frames = NULL;
+	}
 
-	dstr_left(&front, str, pos);
-	dstr_right(&back, str, pos + len);
-	dstr_copy_dstr(str, &front);
-	dstr_cat(str, new_text);
-	dstr_cat_dstr(str, &back);
-	dstr_free(&front);
-	dstr_free(&back);
+	for (uint64_t i = 0; i < replay->audio_frame_count; i++) {
+		free_audio_packet(&replay->audio_frames[i]);
+	}
+	replay->audio_frame_count = 0;
+	if (replay->audio_frames) {
+		bfree(replay->audio_frames);
+		replay->audio_frames = NULL;
+	}
+	bfree(replay->video_timestamps);
+	replay->video_timestamps = NULL;
+	bfree(replay->audio_timestamps);
+	replay->audio_timestamps = NULL;
+	replay_time_map_free(&replay->time_map);
+	for (size_t i = 1; i < replay->angle_count; i++)
+		replay_release(replay->angles[i]);
+	bfree(replay->angles);
+	replay->angles = NULL;
+	replay->angle_count = 0;
 }
 
-static void replay_update_text(struct replay_source *c)
+static void replay_index_timestamps(struct replay *replay)
 {
-	if (!c->text_source_name || !c->text_format)
-		return;
-	obs_source_t *s = obs_get_source_by_name(c->text_source_name);
-	if (!s)
-		return;
+	bfree(replay->video_timestamps);
+	replay->video_timestamps = NULL;
+	if (replay->video_frame_count) {
+		replay->video_timestamps = bmalloc((size_t)replay->video_frame_count * sizeof(uint64_t));
+		for (uint64_t i = 0; i < replay->video_frame_count; i++)
+			replay->video_timestamps[i] = replay->video_frames[i]->timestamp;
+	}
+	bfree(replay->audio_timestamps);
+	replay->audio_timestamps = NULL;
+	if (replay->audio_frame_count) {
+		replay->audio_timestamps = bmalloc((size_t)replay->audio_frame_count * sizeof(uint64_t));
+		for (uint64_t i = 0; i < replay->audio_frame_count; i++)
+			replay->audio_timestamps[i] = replay->audio_frames[i].timestamp;
+	}
+}
 
-	struct dstr sf;
-	size_t pos = 0;
-	struct dstr buffer;
-	dstr_init(&buffer);
-	dstr_init_copy(&sf, c->text_format);
-	while (pos < sf.len) {
-		//duration, speed, index, count
-		const char *cmp = sf.array + pos;
-		if (astrcmp_n(cmp, "%SPEED%", 7) == 0) {
-			dstr_printf(&buffer, "%.1f", c->speed_percent * (c->backward ? -1.0f : 1.0f));
-			dstr_cat_ch(&buffer, '%');
-			replace_text(&sf, pos, 7, buffer.array);
-			pos += buffer.len;
-		} else if (astrcmp_n(cmp, "%PROGRESS%", 10) == 0) {
-			if (c->current_replay.video_frame_count && c->video_frame_position < c->current_replay.video_frame_count) {
-				dstr_printf(&buffer, "%.1f", c->video_frame_position * 100.0 / c->current_replay.video_frame_count);
-				dstr_cat_ch(&buffer, '%');
-			} else {
-				dstr_copy(&buffer, "");
-			}
-			replace_text(&sf, pos, 10, buffer.array);
-			pos += buffer.len;
-		} else if (astrcmp_n(cmp, "%COUNT%", 7) == 0) {
-			dstr_printf(&buffer, "%d", (int)(c->replays.size / sizeof c->current_replay));
-			replace_text(&sf, pos, 7, buffer.array);
-			pos += buffer.len;
-		} else if (astrcmp_n(cmp, "%INDEX%", 7) == 0) {
-			if (c->replays.size) {
-				dstr_printf(&buffer, "%d", c->replay_position + 1);
-			} else {
-				dstr_copy(&buffer, "0");
-			}
-			replace_text(&sf, pos, 7, buffer.array);
-			pos += buffer.len;
-		} else if (astrcmp_n(cmp, "%DURATION%", 10) == 0) {
-			if (c->replays.size) {
-				dstr_printf(&buffer, "%.2f", (double)c->current_replay.duration / (double)1000000000.0);
-			} else {
-				dstr_copy(&buffer, "");
-			}
-			replace_text(&sf, pos, 10, buffer.array);
-			pos += buffer.len;
-		} else if (astrcmp_n(cmp, "%TIME%", 6) == 0) {
-			if (c->replays.size && c->start_timestamp) {
-				int64_t time = 0;
-				if (c->pause_timestamp > c->start_timestamp) {
-					time = c->pause_timestamp - c->start_timestamp;
-				} else {
-					time = obs_get_video_frame_time() - c->start_timestamp;
-				}
-				if (c->speed_percent != 100.0f) {
-					time = (int64_t)((float)time * c->speed_percent / 100.0f);
-				}
-				dstr_printf(&buffer, "%.2f", (double)time / (double)1000000000.0);
-			} else {
-				dstr_copy(&buffer, "");
-			}
-			replace_text(&sf, pos, 6, buffer.array);
-			pos += buffer.len;
-		} else if (astrcmp_n(cmp, "%FPS%", 5) == 0) {
-			if (c->current_replay.video_frame_count && c->current_replay.duration) {
-				dstr_printf(&buffer, "%d",
-					    (int)(c->current_replay.video_frame_count * 1000000000U / c->current_replay.duration));
-			} else {
-				dstr_copy(&buffer, "0");
+// index of the first timestamp that is not lower than ts, count if there is none
+static uint64_t replay_lower_bound(const uint64_t *timestamps, uint64_t count, uint64_t ts)
+{
+	uint64_t i = 0;
+	uint64_t j = count;
+	while (i < j) {
+		const uint64_t mid = i + (j - i) / 2;
+		if (timestamps[mid] < ts)
+			i = mid + 1;
+		else
+			j = mid;
+	}
+	return i;
+}
+
+static struct replay *replay_create(void)
+{
+	struct replay *replay = bzalloc(sizeof(struct replay));
+	replay->refs = 1;
+	return replay;
+}
+
+static inline void replay_addref(struct replay *replay)
+{
+	if (replay)
+		os_atomic_inc_long(&replay->refs);
+}
+
+static void replay_release(struct replay *replay)
+{
+	if (replay && os_atomic_dec_long(&replay->refs) == 0) {
+		replay_free_replay(replay);
+		bfree(replay);
+	}
+}
+
+// takes a reference to the replay published in the slot without locking
+static struct replay *replay_snapshot(struct replay_source *context, struct replay *volatile *slot)
+{
+	os_atomic_inc_long(&context->snapshot_readers);
+	struct replay *replay = replay_atomic_load_ptr((void *volatile *)slot);
+	replay_addref(replay);
+	os_atomic_dec_long(&context->snapshot_readers);
+	return replay;
+}
+
+// replaces the replay in the slot, the previous one is released after
+// all readers that could have loaded it took their own reference
+static void replay_publish(struct replay_source *context, struct replay *volatile *slot, struct replay *replay)
+{
+	replay_addref(replay);
+	if (slot == &context->current_replay) {
+		const uint64_t duration = replay ? replay->duration : 0;
+		replay_atomic_set_u64(&context->current_duration, duration);
+		replay_atomic_set_u64(&context->current_output_duration,
+				      replay ? (uint64_t)replay_time_map_output(&replay->time_map, (int64_t)duration) : 0);
+	}
+	struct replay *old = replay_atomic_exchange_ptr((void *volatile *)slot, replay);
+	while (os_atomic_load_long(&context->snapshot_readers) > 0)
+		os_sleep_ms(0);
+	replay_release(old);
+}
+
+static inline int replay_list_count(struct replay_source *context)
+{
+	return (int)replay_library_count(&context->replays);
+}
+
+static inline struct replay *replay_at(struct replay_source *context, int position)
+{
+	return replay_library_at(&context->replays, (size_t)position)->replay;
+}
+
+// the replay of a camera angle of a replay in the list, the replay itself for angle 0 or a missing angle
+static inline struct replay *replay_angle(struct replay *replay, int angle)
+{
+	if (angle <= 0 || (size_t)angle >= replay->angle_count)
+		return replay;
+	return replay->angles[angle];
+}
+
+// output time from the start of forward playback to a source offset from the first frame, following the speed ramp
+static inline int64_t replay_output_offset(const struct replay_source *c, const struct replay *replay, int64_t source)
+{
+	return (int64_t)(replay_time_map_output(&replay->time_map, source) * 100.0 / c->speed_percent);
+}
+
+// source offset from the first frame reached after playing forward for output time
+static inline int64_t replay_source_offset(const struct replay_source *c, const struct replay *replay, int64_t output)
+{
+	return replay_time_map_source(&replay->time_map, (int64_t)(output * c->speed_percent / 100.0));
+}
+
+// output time from the start of backward playback to a source offset counted back from the last frame
+static inline int64_t replay_output_offset_back(const struct replay_source *c, const struct replay *replay, int64_t back)
+{
+	if (!replay->time_map.count)
+		return (int64_t)(back * 100.0 / c->speed_percent);
+	const int64_t duration = (int64_t)(replay->last_frame_timestamp - replay->first_frame_timestamp);
+	return replay_output_offset(c, replay, duration) - replay_output_offset(c, replay, duration - back);
+}
+
+// source offset counted back from the last frame reached after playing backward for output time
+static inline int64_t replay_source_offset_back(const struct replay_source *c, const struct replay *replay, int64_t output)
+{
+	if (!replay->time_map.count)
+		return (int64_t)(output * c->speed_percent / 100.0);
+	const int64_t duration = (int64_t)(replay->last_frame_timestamp - replay->first_frame_timestamp);
+	const int64_t total = replay_time_map_output(&replay->time_map, duration);
+	return duration - replay_time_map_source(&replay->time_map, total - (int64_t)(output * c->speed_percent / 100.0));
+}
+
+// playback speed in percent at a source offset from the first frame
+static inline double replay_speed_at(const struct replay_source *c, const struct replay *replay, int64_t source)
+{
+	return c->speed_percent * replay_time_map_speed(&replay->time_map, source);
+}
+
+static void replay_unbind(struct replay_binding *b)
+{
+	bfree(b->name);
+	b->name = NULL;
+	obs_weak_source_release(b->weak);
+	b->weak = NULL;
+}
+
+// the source with the name, a reference the caller releases like obs_get_source_by_name but without the name lookup once bound
+static obs_source_t *replay_bind(struct replay_source *c, struct replay_binding *b, const char *name)
+{
+	if (!name || !*name)
+		return NULL;
+	pthread_mutex_lock(&c->bindings_mutex);
+	const long generation = os_atomic_load_long(&replay_bindings_generation);
+	if (b->name && strcmp(b->name, name) == 0) {
+		if (b->weak) {
+			obs_source_t *s = obs_weak_source_get_source(b->weak);
+			if (s && !obs_source_removed(s)) {
+				pthread_mutex_unlock(&c->bindings_mutex);
+				return s;
 			}
-			replace_text(&sf, pos, 5, buffer.array);
-			pos += buffer.len;
+			obs_source_release(s);
+		} else if (b->generation == generation) {
+			pthread_mutex_unlock(&c->bindings_mutex);
+			return NULL;
+		}
+	}
+	replay_unbind(b);
+	b->name = bstrdup(name);
+	b->generation = generation;
+	obs_source_t *s = obs_get_source_by_name(name);
+	if (s)
+		b->weak = obs_source_get_weak_source(s);
+	pthread_mutex_unlock(&c->bindings_mutex);
+	return s;
+}
+
+// renders the text overlay and only updates the text source when the text changed
+static void replay_update_text(struct replay_source *c)
+{
+	pthread_mutex_lock(&c->text_mutex);
+	if (!c->text_source_name || !c->text_template.count) {
+		pthread_mutex_unlock(&c->text_mutex);
+		return;
+	}
+	const uint32_t used = c->text_template.used;
+	struct replay *replay = replay_snapshot(c, &c->current_replay);
+	struct replay_text_values values = {0};
+	values.speed = c->speed_percent * (c->backward ? -1.0f : 1.0f);
+	if (used & (1u << REPLAY_TEXT_PROGRESS) && replay->video_frame_count &&
+	    c->video_frame_position < replay->video_frame_count) {
+		values.has_progress = true;
+		values.progress = c->video_frame_position * 100.0 / replay->video_frame_count;
+	}
+	values.count = replay_list_count(c);
+	values.index = replay_list_count(c) ? c->replay_position + 1 : 0;
+	if (replay_list_count(c)) {
+		values.has_duration = true;
+		values.duration = (double)replay->duration / (double)1000000000.0;
+	}
+	if (used & (1u << REPLAY_TEXT_TIME) && replay_list_count(c) && c->start_timestamp) {
+		int64_t time = 0;
+		if (c->pause_timestamp > c->start_timestamp) {
+			time = c->pause_timestamp - c->start_timestamp;
 		} else {
-			pos++;
+			time = obs_get_video_frame_time() - c->start_timestamp;
 		}
+		if (c->speed_percent != 100.0f || replay->time_map.count) {
+			time = c->backward ? replay_source_offset_back(c, replay, time) : replay_source_offset(c, replay, time);
+		}
+		values.has_time = true;
+		values.time = (double)time / (double)1000000000.0;
 	}
-	obs_data_t *settings = obs_data_create();
-	obs_data_set_string(settings, "text", sf.array);
-	obs_source_update(s, settings);
-	obs_data_release(settings);
-	dstr_free(&sf);
-	dstr_free(&buffer);
-	obs_source_release(s);
+	if (replay->video_frame_count && replay->duration)
+		values.fps = (int)(replay->video_frame_count * 1000000000U / replay->duration);
+	replay_release(replay);
+
+	replay_text_render(&c->text_template, &values, &c->text_buffer);
+	c->text_renders++;
+	if (c->text_last.array && strcmp(c->text_last.array, c->text_buffer.array) == 0) {
+		pthread_mutex_unlock(&c->text_mutex);
+		return;
+	}
+	obs_source_t *s = replay_bind(c, &c->text_binding, c->text_source_name);
+	if (s) {
+		const uint64_t start = os_gettime_ns();
+		if (!c->text_settings)
+			c->text_settings = obs_data_create();
+		obs_data_set_string(c->text_settings, "text", c->text_buffer.array);
+		obs_source_update(s, c->text_settings);
+		obs_source_release(s);
+		dstr_copy_dstr(&c->text_last, &c->text_buffer);
+		if (!c->text_updates)
+			c->text_first_update = start;
+		c->text_updates++;
+		c->text_update_ns += os_gettime_ns() - start;
+	}
+	pthread_mutex_unlock(&c->text_mutex);
+}
+
+// runs on the signal thread, the bindings are only marked and rebuilt by the next crop update
+static void replay_progress_item_changed(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(cd);
+	struct replay_source *context = data;
+	os_atomic_set_bool(&context->progress_dirty, true);
+}
+
+static void replay_progress_watch_scene(struct replay_source *context, obs_scene_t *scene)
+{
+	obs_source_t *source = obs_scene_get_source(scene);
+	signal_handler_t *sh = obs_source_get_signal_handler(source);
+	signal_handler_connect(sh, "item_add", replay_progress_item_changed, context);
+	signal_handler_connect(sh, "item_remove", replay_progress_item_changed, context);
+	context->progress_scenes =
+		brealloc(context->progress_scenes, (context->progress_scene_count + 1) * sizeof(obs_weak_source_t *));
+	context->progress_scenes[context->progress_scene_count++] = obs_source_get_weak_source(source);
 }
 
-struct siu {
-	uint32_t crop_width;
-	obs_source_t *source;
-};
 static bool EnumSceneItem(obs_scene_t *scene, obs_sceneitem_t *item, void *data)
 {
 	UNUSED_PARAMETER(scene);
-	struct siu *siu = data;
-	if (obs_sceneitem_get_source(item) == siu->source) {
-		struct obs_sceneitem_crop crop;
-		obs_sceneitem_get_crop(item, &crop);
-		crop.left = 0;
-		crop.right = siu->crop_width;
-		obs_sceneitem_set_crop(item, &crop);
+	struct replay_source *context = data;
+	if (obs_weak_source_references_source(context->progress_weak, obs_sceneitem_get_source(item))) {
+		obs_sceneitem_addref(item);
+		context->progress_items =
+			brealloc(context->progress_items, (context->progress_item_count + 1) * sizeof(obs_sceneitem_t *));
+		context->progress_items[context->progress_item_count++] = item;
 	} else if (obs_sceneitem_is_group(item)) {
+		replay_progress_watch_scene(context, obs_sceneitem_group_get_scene(item));
 		obs_scene_enum_items(obs_sceneitem_group_get_scene(item), EnumSceneItem, data);
 	}
 	return true;
@@ -283,30 +659,81 @@ static bool EnumSceneItem(obs_scene_t *scene, obs_sceneitem_t *item, void *data)
 static bool EnumScenesItems(void *data, obs_source_t *source)
 {
 	obs_scene_t *scene = obs_scene_from_source(source);
+	replay_progress_watch_scene(data, scene);
 	obs_scene_enum_items(scene, EnumSceneItem, data);
 	return true;
 }
 
+static void replay_progress_unbind(struct replay_source *context)
+{
+	for (size_t i = 0; i < context->progress_scene_count; i++) {
+		obs_source_t *source = obs_weak_source_get_source(context->progress_scenes[i]);
+		if (source) {
+			signal_handler_t *sh = obs_source_get_signal_handler(source);
+			signal_handler_disconnect(sh, "item_add", replay_progress_item_changed, context);
+			signal_handler_disconnect(sh, "item_remove", replay_progress_item_changed, context);
+			obs_source_release(source);
+		}
+		obs_weak_source_release(context->progress_scenes[i]);
+	}
+	bfree(context->progress_scenes);
+	context->progress_scenes = NULL;
+	context->progress_scene_count = 0;
+	for (size_t i = 0; i < context->progress_item_count; i++)
+		obs_sceneitem_release(context->progress_items[i]);
+	bfree(context->progress_items);
+	context->progress_items = NULL;
+	context->progress_item_count = 0;
+	obs_weak_source_release(context->progress_weak);
+	context->progress_weak = NULL;
+}
+
+// finds the scene items showing the progress source, the scenes are watched so this only runs again when they change
+static void replay_progress_bind(struct replay_source *context)
+{
+	replay_progress_unbind(context);
+	context->progress_crop = -1;
+	if (!context->progress_source_name || !*context->progress_source_name)
+		return;
+	obs_source_t *s = replay_bind(context, &context->progress_binding, context->progress_source_name);
+	if (!s)
+		return;
+	context->progress_weak = obs_source_get_weak_source(s);
+	obs_enum_scenes(EnumScenesItems, context);
+	obs_source_release(s);
+	blog(LOG_DEBUG, "[replay_source: '%s'] progress source '%s' bound to %d scene items in %d scenes",
+	     obs_source_get_name(context->source), context->progress_source_name, (int)context->progress_item_count,
+	     (int)context->progress_scene_count);
+}
+
+// must be called with the video mutex locked
 static void replay_update_progress_crop(struct replay_source *context, uint64_t t)
 {
-	if (!context->progress_source_name)
+	if (os_atomic_load_bool(&context->progress_dirty) && os_atomic_exchange_bool(&context->progress_dirty, false))
+		replay_progress_bind(context);
+	if (!context->progress_item_count)
 		return;
-	obs_source_t *s = obs_get_source_by_name(context->progress_source_name);
+	obs_source_t *s = obs_weak_source_get_source(context->progress_weak);
 	if (!s)
 		return;
 	const uint32_t width = obs_source_get_base_width(s);
-	if (width) {
-		struct siu siu;
-		siu.source = s;
-		if (t && context->current_replay.last_frame_timestamp && context->current_replay.duration) {
-			siu.crop_width = (uint32_t)((context->current_replay.last_frame_timestamp - t) * width /
-						    context->current_replay.duration);
-		} else {
-			siu.crop_width = width;
-		}
-		obs_enum_scenes(EnumScenesItems, &siu);
-	}
 	obs_source_release(s);
+	if (!width)
+		return;
+	const struct replay *replay = context->current_replay;
+	uint32_t crop_width = width;
+	if (t && replay->last_frame_timestamp && replay->duration)
+		crop_width = (uint32_t)((replay->last_frame_timestamp - t) * width / replay->duration);
+	if ((int64_t)crop_width == context->progress_crop)
+		return;
+	context->progress_crop = crop_width;
+	for (size_t i = 0; i < context->progress_item_count; i++) {
+		struct obs_sceneitem_crop crop;
+		obs_sceneitem_get_crop(context->progress_items[i], &crop);
+		crop.left = 0;
+		crop.right = crop_width;
+		obs_sceneitem_set_crop(context->progress_items[i], &crop);
+	}
 }
 
 static const char *replay_source_get_name(void *unused)
@@ -320,7 +747,7 @@ static void EnumFilter(obs_source_t *source, obs_source_t *filter, void *data)
 	UNUSED_PARAMETER(source);
 	struct replay_source *c = data;
 	const char *filterName = obs_source_get_name(filter);
-	const char *sourceName = obs_source_get_name(c->source);
+	const char *sourceName = c->filter_name;
 	const char *id = obs_source_get_unversioned_id(filter);
 	if ((strcmp(REPLAY_FILTER_ASYNC_ID, id) == 0 || strcmp(REPLAY_FILTER_ID, id) == 0) && strcmp(filterName, sourceName) == 0)
 		c->source_filter = filter;
@@ -330,7 +757,7 @@ static void EnumAudioFilter(obs_source_t *source, obs_source_t *filter, void *da
 	UNUSED_PARAMETER(source);
 	struct replay_source *c = data;
 	const char *filterName = obs_source_get_name(filter);
-	const char *sourceName = obs_source_get_name(c->source);
+	const char *sourceName = c->filter_name;
 	const char *id = obs_source_get_unversioned_id(filter);
 	if (strcmp(REPLAY_FILTER_AUDIO_ID, id) == 0 && strcmp(filterName, sourceName) == 0)
 		c->source_audio_filter = filter;
@@ -340,7 +767,7 @@ static void EnumAudioVideoFilter(obs_source_t *source, obs_source_t *filter, voi
 	UNUSED_PARAMETER(source);
 	struct replay_source *c = data;
 	const char *filterName = obs_source_get_name(filter);
-	const char *sourceName = obs_source_get_name(c->source);
+	const char *sourceName = c->filter_name;
 	const char *id = obs_source_get_unversioned_id(filter);
 	if ((strcmp(REPLAY_FILTER_AUDIO_ID, id) == 0 || strcmp(REPLAY_FILTER_ASYNC_ID, id) == 0 ||
 	     strcmp(REPLAY_FILTER_ID, id) == 0) &&
@@ -361,23 +788,23 @@ static inline void obs_source_signal(struct obs_source *source, const char *sign
 
 static void replay_reverse(struct replay_source *c, uint64_t os_timestamp)
 {
+	struct replay *replay = replay_snapshot(c, &c->current_replay);
 	c->backward = !c->backward;
 	if (c->end) {
 		c->end = false;
-		if (c->backward && c->current_replay.video_frame_count) {
-			c->video_frame_position = c->current_replay.video_frame_count - 1;
+		if (c->backward && replay->video_frame_count) {
+			c->video_frame_position = replay->video_frame_count - 1;
 		} else {
 			c->video_frame_position = 0;
 		}
 	}
-	const int64_t duration =
-		(int64_t)(((int64_t)c->current_replay.last_frame_timestamp - (int64_t)c->current_replay.first_frame_timestamp) *
-			  100.0 / c->speed_percent);
+	const int64_t duration = replay_output_offset(c, replay, replay->last_frame_timestamp - replay->first_frame_timestamp);
 	int64_t play_duration = os_timestamp - c->start_timestamp;
 	if (play_duration > duration) {
 		play_duration = duration;
 	}
 	c->start_timestamp = os_timestamp - duration + play_duration;
+	replay_release(replay);
 }
 
 static void replay_reverse_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
@@ -410,6 +837,7 @@ static void replay_forward_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *ho
 
 	if (!pressed)
 		return;
+	struct replay *replay = replay_snapshot(c, &c->current_replay);
 	const int64_t time = obs_get_video_frame_time();
 	if (c->pause_timestamp) {
 		c->start_timestamp += time - c->pause_timestamp;
@@ -427,15 +855,15 @@ static void replay_forward_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *ho
 	} else if (c->backward) {
 		c->backward = false;
 
-		const int64_t duration = (int64_t)(((int64_t)c->current_replay.last_frame_timestamp -
-						    (int64_t)c->current_replay.first_frame_timestamp) *
-						   100.0 / c->speed_percent);
+		const int64_t duration =
+			replay_output_offset(c, replay, replay->last_frame_timestamp - replay->first_frame_timestamp);
 		int64_t play_duration = time - c->start_timestamp;
 		if (play_duration > duration) {
 			play_duration = duration;
 		}
 		c->start_timestamp = time - duration + play_duration;
 	}
+	replay_release(replay);
 }
 
 static void replay_backward_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
@@ -447,6 +875,7 @@ static void replay_backward_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *h
 
 	if (!pressed)
 		return;
+	struct replay *replay = replay_snapshot(c, &c->current_replay);
 	const int64_t time = obs_get_video_frame_time();
 	if (c->pause_timestamp) {
 		c->start_timestamp += time - c->pause_timestamp;
@@ -458,40 +887,182 @@ static void replay_backward_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *h
 	}
 	if (c->end || c->video_frame_position == 0) {
 		c->end = false;
-		if (c->current_replay.video_frame_count)
-			c->video_frame_position = c->current_replay.video_frame_count - 1;
+		if (replay->video_frame_count)
+			c->video_frame_position = replay->video_frame_count - 1;
 		c->start_timestamp = obs_get_video_frame_time();
 		c->backward = true;
 	} else if (!c->backward) {
 		c->backward = true;
 
-		const int64_t duration = (int64_t)(((int64_t)c->current_replay.last_frame_timestamp -
-						    (int64_t)c->current_replay.first_frame_timestamp) *
-						   100.0 / c->speed_percent);
+		const int64_t duration =
+			replay_output_offset(c, replay, replay->last_frame_timestamp - replay->first_frame_timestamp);
 		int64_t play_duration = time - c->start_timestamp;
 		if (play_duration > duration) {
 			play_duration = duration;
 		}
 		c->start_timestamp = time - duration + play_duration;
 	}
+	replay_release(replay);
 }
 
+struct replay_spill_job {
+	bool write;
+	uint64_t id;
+	/* a reference to the replay to write */
+	struct replay *replay;
+};
+
+struct replay_thumbnail_job {
+	uint64_t id;
+	/* a reference to the replay to make the thumbnails of */
+	struct replay *replay;
+};
+
+struct replay_spill_header {
+	uint64_t first_frame_timestamp;
+	uint64_t last_frame_timestamp;
+	uint64_t duration;
+	int64_t trim_front;
+	int64_t trim_end;
+	struct audio_convert_info oai;
+	uint64_t video_frame_count;
+	uint64_t audio_frame_count;
+	uint64_t time_map_count;
+	uint64_t angle_count;
+};
+
+static inline bool replay_spill_enabled(const struct replay_source *c)
+{
+	return c->spill_thread_active && c->spill_max > 0 && c->spill_directory && *c->spill_directory;
+}
+
+static void replay_spill_queue(struct replay_source *c, const struct replay_spill_job *job, bool urgent)
+{
+	pthread_mutex_lock(&c->spill_mutex);
+	if (urgent)
+		circlebuf_push_front(&c->spill_jobs, job, sizeof(*job));
+	else
+		circlebuf_push_back(&c->spill_jobs, job, sizeof(*job));
+	pthread_mutex_unlock(&c->spill_mutex);
+	os_sem_post(c->spill_sem);
+}
+
+// queues reading back the replay at position when it is only on disk, called with the replay mutex held
+static void replay_page_in(struct replay_source *c, int position, bool urgent)
+{
+	if (position < 0 || position >= replay_list_count(c))
+		return;
+	struct replay_library_entry *entry = replay_library_at(&c->replays, (size_t)position);
+	if (entry->replay || entry->paging_in || !entry->spill_path)
+		return;
+	entry->paging_in = true;
+	const struct replay_spill_job job = {false, entry->id, NULL};
+	replay_spill_queue(c, &job, urgent);
+}
+
+// removes the replay at position and its spill file, called with the replay mutex held
+static struct replay *replay_list_remove(struct replay_source *c, size_t position)
+{
+	struct replay_library_entry *entry = replay_library_at(&c->replays, position);
+	if (entry && entry->spill_path)
+		os_unlink(entry->spill_path);
+	return replay_library_remove(&c->replays, position);
+}
+
+static bool replay_spill_write_replay(FILE *file, const struct replay *replay)
+{
+	const struct replay_spill_header header = {
+		replay->first_frame_timestamp, replay->last_frame_timestamp, replay->duration,
+		replay->trim_front,	       replay->trim_end,	     replay->oai,
+		replay->video_frame_count,     replay->audio_frame_count,    replay->time_map.count,
+		replay->angle_count,
+	};
+	if (!replay_spill_write(file, &header, sizeof(header)) ||
+	    !replay_spill_write(file, replay->time_map.source, replay->time_map.count * sizeof(int64_t)) ||
+	    !replay_spill_write(file, replay->time_map.output, replay->time_map.count * sizeof(int64_t)) ||
+	    !replay_spill_write(file, replay->time_map.speed, replay->time_map.count * sizeof(double)) ||
+	    !replay_spill_write_video(file, replay->video_frames, replay->video_frame_count) ||
+	    !replay_spill_write_audio(file, replay->audio_frames, replay->audio_frame_count))
+		return false;
+	for (size_t i = 1; i < replay->angle_count; i++) {
+		if (!replay_spill_write_replay(file, replay->angles[i]))
+			return false;
+	}
+	return true;
+}
+
+static struct replay *replay_spill_read_replay(FILE *file)
+{
+	struct replay_spill_header header;
+	if (!replay_spill_read(file, &header, sizeof(header)))
+		return NULL;
+	struct replay *replay = replay_create();
+	replay->first_frame_timestamp = header.first_frame_timestamp;
+	replay->last_frame_timestamp = header.last_frame_timestamp;
+	replay->duration = header.duration;
+	replay->trim_front = header.trim_front;
+	replay->trim_end = header.trim_end;
+	replay->oai = header.oai;
+	bool ok = true;
+	if (header.time_map_count) {
+		replay->time_map.count = (size_t)header.time_map_count;
+		replay->time_map.source = bmalloc(replay->time_map.count * sizeof(int64_t));
+		replay->time_map.output = bmalloc(replay->time_map.count * sizeof(int64_t));
+		replay->time_map.speed = bmalloc(replay->time_map.count * sizeof(double));
+		ok = replay_spill_read(file, replay->time_map.source, replay->time_map.count * sizeof(int64_t)) &&
+		     replay_spill_read(file, replay->time_map.output, replay->time_map.count * sizeof(int64_t)) &&
+		     replay_spill_read(file, replay->time_map.speed, replay->time_map.count * sizeof(double));
+	}
+	if (ok && header.video_frame_count) {
+		replay->video_frames = bzalloc((size_t)header.video_frame_count * sizeof(struct obs_source_frame *));
+		replay->video_frame_count = replay_spill_read_video(file, replay->video_frames, header.video_frame_count);
+		ok = replay->video_frame_count == header.video_frame_count;
+	}
+	if (ok && header.audio_frame_count) {
+		replay->audio_frames = bzalloc((size_t)header.audio_frame_count * sizeof(struct obs_audio_data));
+		replay->audio_frame_count = replay_spill_read_audio(file, replay->audio_frames, header.audio_frame_count);
+		ok = replay->audio_frame_count == header.audio_frame_count;
+	}
+	if (ok && header.angle_count > 1) {
+		replay->angles = bzalloc((size_t)header.angle_count * sizeof(struct replay *));
+		replay->angle_count = 1;
+		while (ok && replay->angle_count < header.angle_count) {
+			struct replay *angle = replay_spill_read_replay(file);
+			ok = angle != NULL;
+			if (ok)
+				replay->angles[replay->angle_count++] = angle;
+		}
+	}
+	if (!ok) {
+		replay_release(replay);
+		return NULL;
+	}
+	replay_index_timestamps(replay);
+	return replay;
+}
+
+// plays the replay at replay_position from its start, without lock the replay and video mutex are held by the caller
 static void replay_update_position(struct replay_source *context, bool lock)
 {
-	if (lock)
+	if (lock) {
+		pthread_mutex_lock(&context->replay_mutex);
 		pthread_mutex_lock(&context->video_mutex);
+	}
 	pthread_mutex_lock(&context->audio_mutex);
-	const int replay_count = (int)(context->replays.size / sizeof context->current_replay);
+	const int replay_count = replay_list_count(context);
 	if (replay_count == 0) {
-		context->current_replay.video_frame_count = 0;
-		context->current_replay.video_frames = NULL;
-		context->current_replay.audio_frame_count = 0;
-		context->current_replay.audio_frames = NULL;
+		struct replay *empty = replay_create();
+		replay_publish(context, &context->current_replay, empty);
+		replay_release(empty);
 		context->replay_position = 0;
+		context->replay_id = 0;
+		context->page_in_id = 0;
 		obs_source_output_video(context->source, NULL);
 		pthread_mutex_unlock(&context->audio_mutex);
-		if (lock)
+		if (lock) {
 			pthread_mutex_unlock(&context->video_mutex);
+			pthread_mutex_unlock(&context->replay_mutex);
+		}
 		blog(LOG_INFO, "[replay_source: '%s'] No replay active", obs_source_get_name(context->source));
 		return;
 	}
@@ -500,21 +1071,43 @@ static void replay_update_position(struct replay_source *context, bool lock)
 	} else if (context->replay_position < 0) {
 		context->replay_position = 0;
 	}
-	memcpy(&context->current_replay,
-	       circlebuf_data(&context->replays, context->replay_position * sizeof context->current_replay),
-	       sizeof context->current_replay);
+	struct replay_library_entry *entry = replay_library_at(&context->replays, (size_t)context->replay_position);
+	if (!entry->replay) {
+		// keep playing the current replay at its position until the selected one is read back
+		const int selected = context->replay_position;
+		context->page_in_id = entry->id;
+		replay_page_in(context, selected, true);
+		const size_t playing = replay_library_position(&context->replays, context->replay_id);
+		if (playing < replay_library_count(&context->replays))
+			context->replay_position = (int)playing;
+		pthread_mutex_unlock(&context->audio_mutex);
+		if (lock) {
+			pthread_mutex_unlock(&context->video_mutex);
+			pthread_mutex_unlock(&context->replay_mutex);
+		}
+		blog(LOG_INFO, "[replay_source: '%s'] reading replay %i/%i back from disk", obs_source_get_name(context->source),
+		     selected + 1, replay_count);
+		return;
+	}
+	context->page_in_id = 0;
+	context->replay_id = entry->id;
+	entry->last_used = os_gettime_ns();
+	replay_publish(context, &context->current_replay, replay_angle(entry->replay, context->angle));
 	context->video_frame_position = 0;
 	context->audio_frame_position = 0;
+	context->audio_sample_offset = 0;
 	context->start_timestamp = obs_get_video_frame_time();
 	context->backward = context->backward_start;
-	if (!context->backward && context->current_replay.trim_front != 0) {
-		context->start_timestamp -= (uint64_t)(context->current_replay.trim_front * 100.0 / context->speed_percent);
-	} else if (context->backward && context->current_replay.trim_end != 0) {
-		context->start_timestamp -= (uint64_t)(context->current_replay.trim_end * 100.0 / context->speed_percent);
+	if (!context->backward && context->current_replay->trim_front != 0) {
+		context->start_timestamp -=
+			(uint64_t)replay_output_offset(context, context->current_replay, context->current_replay->trim_front);
+	} else if (context->backward && context->current_replay->trim_end != 0) {
+		context->start_timestamp -=
+			(uint64_t)replay_output_offset_back(context, context->current_replay, context->current_replay->trim_end);
 	}
 	context->pause_timestamp = 0;
-	if (context->backward && context->current_replay.video_frame_count) {
-		context->video_frame_position = context->current_replay.video_frame_count - 1;
+	if (context->backward && context->current_replay->video_frame_count) {
+		context->video_frame_position = context->current_replay->video_frame_count - 1;
 	}
 	if (context->active || context->visibility_action == VISIBILITY_ACTION_CONTINUE) {
 		if (!context->play && !context->stepped) {
@@ -530,96 +1123,426 @@ static void replay_update_position(struct replay_source *context, bool lock)
 	}
 
 	pthread_mutex_unlock(&context->audio_mutex);
-	if (lock)
-		pthread_mutex_unlock(&context->video_mutex);
 
+	// read ahead the replays next to it
+	replay_page_in(context, context->replay_position + 1, false);
+	replay_page_in(context, context->replay_position - 1, false);
+	if (lock) {
+		pthread_mutex_unlock(&context->video_mutex);
+		pthread_mutex_unlock(&context->replay_mutex);
+	}
 	replay_update_text(context);
 }
 
-static void replay_free_replay(struct replay *replay, struct replay_source *context)
+// least recently used replay in memory that can be written out, -1 when there is none
+static int replay_spill_victim(struct replay_source *c)
 {
-	if (replay == &context->saving_replay) {
-		context->free_after_save = false;
-	} else if (replay->video_frames == context->saving_replay.video_frames && context->saving_status != SAVING_STATUS_NONE) {
-		context->free_after_save = true;
-		return;
-	}
-	for (uint64_t i = 0; i < replay->video_frame_count; i++) {
-		struct obs_source_frame *frame = replay->video_frames[i];
-		if (frame && os_atomic_dec_long(&frame->refs) <= 0) {
-			obs_source_frame_destroy(frame);
-			replay->video_frames[i] = NULL;
+	int victim = -1;
+	uint64_t oldest = UINT64_MAX;
+	const int count = replay_list_count(c);
+	for (int i = 0; i < count; i++) {
+		const struct replay_library_entry *entry = replay_library_at(&c->replays, (size_t)i);
+		if (i != c->replay_position && entry->id != c->page_in_id && entry->replay && !entry->spilling &&
+		    entry->last_used < oldest) {
+			oldest = entry->last_used;
+			victim = i;
 		}
 	}
-	replay->video_frame_count = 0;
-	if (replay->video_frames) {
-		bfree(replay->video_frames);
-		replay->video_frames = NULL;
-	}
+	return victim;
+}
 
-	for (uint64_t i = 0; i < replay->audio_frame_count; i++) {
-		free_audio_packet(&replay->audio_frames[i]);
+// keeps replay_max replays in memory and spill_max more on disk, the oldest on disk are removed
+static void replay_spill_replays(struct replay_source *c)
+{
+	pthread_mutex_lock(&c->replay_mutex);
+	int resident = 0;
+	int spilled = 0;
+	const int count = replay_list_count(c);
+	for (int i = 0; i < count; i++) {
+		const struct replay_library_entry *entry = replay_library_at(&c->replays, (size_t)i);
+		if (entry->replay && !entry->spilling)
+			resident++;
+		else
+			spilled++;
 	}
-	replay->audio_frame_count = 0;
-	if (replay->audio_frames) {
-		bfree(replay->audio_frames);
-		replay->audio_frames = NULL;
+	while (resident > c->replay_max) {
+		const int victim = replay_spill_victim(c);
+		if (victim < 0)
+			break;
+		struct replay_library_entry *entry = replay_library_at(&c->replays, (size_t)victim);
+		entry->spilling = true;
+		replay_addref(entry->replay);
+		const struct replay_spill_job job = {true, entry->id, entry->replay};
+		replay_spill_queue(c, &job, false);
+		resident--;
+		spilled++;
+	}
+	// only replays that are on disk alone are removed, so there is nothing to release
+	for (int i = 0; spilled > c->spill_max && i < replay_list_count(c);) {
+		const struct replay_library_entry *entry = replay_library_at(&c->replays, (size_t)i);
+		if (i == c->replay_position || entry->replay || entry->paging_in) {
+			i++;
+			continue;
+		}
+		replay_list_remove(c, (size_t)i);
+		if (i < c->replay_position)
+			c->replay_position--;
+		spilled--;
 	}
+	pthread_mutex_unlock(&c->replay_mutex);
 }
+
 static void replay_purge_replays(struct replay_source *context)
 {
-	if ((int)(context->replays.size / sizeof context->current_replay) > context->replay_max) {
+	if (replay_spill_enabled(context)) {
+		replay_spill_replays(context);
+		return;
+	}
+	if (replay_list_count(context) > context->replay_max) {
 		pthread_mutex_lock(&context->replay_mutex);
-		const int replays_to_delete = (int)(context->replays.size / sizeof context->current_replay - context->replay_max);
+		const int replays_to_delete = replay_list_count(context) - context->replay_max;
 		if (replays_to_delete > context->replay_position) {
 			context->replay_position = replays_to_delete;
-			replay_update_position(context, true);
+			pthread_mutex_lock(&context->video_mutex);
+			replay_update_position(context, false);
+			pthread_mutex_unlock(&context->video_mutex);
 		}
-		while ((int)(context->replays.size / sizeof context->current_replay) > context->replay_max) {
-			struct replay old_replay;
-			circlebuf_pop_front(&context->replays, &old_replay, sizeof context->current_replay);
-			replay_free_replay(&old_replay, context);
+		while (replay_list_count(context) > context->replay_max) {
+			replay_release(replay_list_remove(context, 0));
 			context->replay_position--;
 		}
 		if (context->replay_max > 1)
 			blog(LOG_INFO, "[replay_source: '%s'] switched to replay %i/%i", obs_source_get_name(context->source),
-			     context->replay_position + 1, (int)(context->replays.size / sizeof context->current_replay));
+			     context->replay_position + 1, replay_list_count(context));
 		pthread_mutex_unlock(&context->replay_mutex);
 	}
 }
+static void replay_spill_out(struct replay_source *c, struct replay_spill_job *job)
+{
+	pthread_mutex_lock(&c->replay_mutex);
+	struct replay_library_entry *entry = replay_library_find(&c->replays, job->id);
+	const bool listed = entry != NULL;
+	char *path = entry && entry->spill_path ? bstrdup(entry->spill_path) : NULL;
+	pthread_mutex_unlock(&c->replay_mutex);
+	if (!listed) {
+		replay_release(job->replay);
+		return;
+	}
+
+	// a replay read back earlier is still on disk and only needs to be dropped
+	const bool wrote = path == NULL;
+	bool written = !wrote;
+	if (wrote) {
+		const uint64_t start = os_gettime_ns();
+		struct dstr file_path = {0};
+		pthread_mutex_lock(&c->spill_mutex);
+		dstr_copy(&file_path, c->spill_directory);
+		pthread_mutex_unlock(&c->spill_mutex);
+		dstr_replace(&file_path, "\\", "/");
+		os_mkdirs(file_path.array);
+		if (dstr_end(&file_path) != '/')
+			dstr_cat_ch(&file_path, '/');
+		dstr_catf(&file_path, "replay-%" PRIx64 "-%" PRIx64 ".spill", (uint64_t)(uintptr_t)c, job->id);
+		path = file_path.array;
+		FILE *file = os_fopen(path, "wb");
+		if (file) {
+			setvbuf(file, NULL, _IOFBF, 1 << 20);
+			written = replay_spill_write_replay(file, job->replay);
+			const int64_t size = os_ftelli64(file);
+			if (fclose(file) != 0)
+				written = false;
+			if (written) {
+				c->spill_writes++;
+				c->spill_write_bytes += (uint64_t)size;
+				c->spill_write_ns += os_gettime_ns() - start;
+			}
+		}
+		if (!written) {
+			blog(LOG_WARNING, "[replay_source: '%s'] could not write replay to '%s'", obs_source_get_name(c->source),
+			     path);
+			os_unlink(path);
+		}
+	}
+
+	bool drop = false;
+	pthread_mutex_lock(&c->replay_mutex);
+	entry = replay_library_find(&c->replays, job->id);
+	if (entry) {
+		entry->spilling = false;
+		if (written && !entry->spill_path)
+			entry->spill_path = bstrdup(path);
+		// the replay could have been selected or trimmed in the meantime
+		if (written && entry->replay == job->replay &&
+		    entry != replay_library_at(&c->replays, (size_t)c->replay_position)) {
+			entry->duration = job->replay->duration;
+			entry->trim_front = job->replay->trim_front;
+			entry->trim_end = job->replay->trim_end;
+			entry->replay = NULL;
+			drop = true;
+		}
+	} else if (written && wrote) {
+		os_unlink(path);
+	}
+	pthread_mutex_unlock(&c->replay_mutex);
+	if (drop)
+		replay_release(job->replay);
+	replay_release(job->replay);
+	bfree(path);
+}
+
+static void replay_spill_in(struct replay_source *c, uint64_t id)
+{
+	pthread_mutex_lock(&c->replay_mutex);
+	struct replay_library_entry *entry = replay_library_find(&c->replays, id);
+	char *path = entry && !entry->replay && entry->spill_path ? bstrdup(entry->spill_path) : NULL;
+	if (entry && !path)
+		entry->paging_in = false;
+	pthread_mutex_unlock(&c->replay_mutex);
+	if (!path)
+		return;
+
+	const uint64_t start = os_gettime_ns();
+	struct replay *replay = NULL;
+	FILE *file = os_fopen(path, "rb");
+	if (file) {
+		setvbuf(file, NULL, _IOFBF, 1 << 20);
+		replay = replay_spill_read_replay(file);
+		fclose(file);
+	}
+	if (replay) {
+		c->spill_reads++;
+		c->spill_read_ns += os_gettime_ns() - start;
+	} else {
+		blog(LOG_WARNING, "[replay_source: '%s'] could not read replay back from '%s'", obs_source_get_name(c->source),
+		     path);
+	}
+	bfree(path);
+
+	struct replay *lost = NULL;
+	pthread_mutex_lock(&c->replay_mutex);
+	entry = replay_library_find(&c->replays, id);
+	if (entry) {
+		entry->paging_in = false;
+		if (replay && !entry->replay) {
+			// trims changed after the file was written are kept in the entry
+			for (size_t i = 0; i < (replay->angle_count ? replay->angle_count : 1); i++) {
+				struct replay *angle = i ? replay->angles[i] : replay;
+				angle->trim_front = entry->trim_front;
+				angle->trim_end = entry->trim_end;
+			}
+			entry->replay = replay;
+			entry->last_used = os_gettime_ns();
+			replay = NULL;
+		} else if (!replay && !entry->replay) {
+			// the file is unusable, drop the replay from the list
+			const int count = replay_list_count(c);
+			for (int i = 0; i < count; i++) {
+				if (replay_library_at(&c->replays, (size_t)i) == entry) {
+					lost = replay_list_remove(c, (size_t)i);
+					if (i < c->replay_position)
+						c->replay_position--;
+					break;
+				}
+			}
+		}
+	}
+	pthread_mutex_unlock(&c->replay_mutex);
+	replay_release(replay);
+	replay_release(lost);
+
+	// the tick publishes the replay when it was selected and spills another one
+	os_atomic_set_bool(&c->spill_in_done, true);
+}
+
+// plays the selected replay once it is read back and keeps the replays in memory to the maximum, runs on the tick
+static void replay_spill_in_done(struct replay_source *c)
+{
+	pthread_mutex_lock(&c->replay_mutex);
+	const struct replay_library_entry *entry = replay_library_find(&c->replays, c->page_in_id);
+	if (!entry) {
+		// it could not be read back and was removed
+		c->page_in_id = 0;
+	} else if (entry->replay) {
+		c->replay_position = (int)replay_library_position(&c->replays, c->page_in_id);
+		pthread_mutex_lock(&c->video_mutex);
+		replay_update_position(c, false);
+		pthread_mutex_unlock(&c->video_mutex);
+	}
+	pthread_mutex_unlock(&c->replay_mutex);
+	replay_purge_replays(c);
+}
+
+static void *replay_spill_thread(void *data)
+{
+	struct replay_source *context = data;
+	os_set_thread_name("replay_source: spill");
+	while (os_sem_wait(context->spill_sem) == 0) {
+		if (context->spill_stop)
+			break;
+		struct replay_spill_job job;
+		bool found = false;
+		pthread_mutex_lock(&context->spill_mutex);
+		if (context->spill_jobs.size) {
+			circlebuf_pop_front(&context->spill_jobs, &job, sizeof(job));
+			found = true;
+		}
+		pthread_mutex_unlock(&context->spill_mutex);
+		if (!found)
+			continue;
+		if (job.write)
+			replay_spill_out(context, &job);
+		else
+			replay_spill_in(context, job.id);
+	}
+	return NULL;
+}
+
+// queues making the thumbnails of the entry, called with the replay mutex locked
+static void replay_thumbnails_queue(struct replay_source *c, struct replay_library_entry *entry)
+{
+	if (!c->thumbnail_thread_active || c->thumbnail_count <= 0 || !entry->replay || !entry->replay->video_frame_count)
+		return;
+	replay_addref(entry->replay);
+	const struct replay_thumbnail_job job = {entry->id, entry->replay};
+	pthread_mutex_lock(&c->thumbnail_mutex);
+	circlebuf_push_back(&c->thumbnail_jobs, &job, sizeof(job));
+	pthread_mutex_unlock(&c->thumbnail_mutex);
+	os_sem_post(c->thumbnail_sem);
+}
+
+static void replay_thumbnails_make(struct replay_source *c, struct replay_thumbnail_job *job)
+{
+	const struct replay *replay = job->replay;
+	const uint64_t start = os_gettime_ns();
+	uint32_t count = (uint32_t)c->thumbnail_count;
+	if (count > SETTING_THUMBNAILS_MAX)
+		count = SETTING_THUMBNAILS_MAX;
+	// evenly spread over the part that plays, each from the middle of its section
+	const uint64_t begin = replay->first_frame_timestamp + (replay->trim_front > 0 ? (uint64_t)replay->trim_front : 0);
+	uint64_t end = replay->last_frame_timestamp - (replay->trim_end > 0 ? (uint64_t)replay->trim_end : 0);
+	if (end < begin)
+		end = begin;
+	struct obs_source_frame *frames[SETTING_THUMBNAILS_MAX];
+	for (uint32_t i = 0; i < count; i++) {
+		const uint64_t ts = begin + (end - begin) * (2 * i + 1) / (2 * count);
+		uint64_t index = replay_lower_bound(replay->video_timestamps, replay->video_frame_count, ts);
+		if (index >= replay->video_frame_count)
+			index = replay->video_frame_count - 1;
+		frames[i] = replay->video_frames[index];
+	}
+	struct replay_thumbnails *thumbnails =
+		count ? replay_thumbnails_create(&c->thumbnail_scaler, frames, count, REPLAY_THUMBNAIL_WIDTH) : NULL;
+	replay_release(job->replay);
+	if (!thumbnails)
+		return;
+
+	const uint64_t ns = os_gettime_ns() - start;
+	c->thumbnail_strips++;
+	c->thumbnail_ns += ns;
+	if (ns > c->thumbnail_max_ns)
+		c->thumbnail_max_ns = ns;
+	blog(LOG_INFO, "[replay_source: '%s'] %" PRIu32 " thumbnails made in %.2f ms", obs_source_get_name(c->source), count,
+	     (double)ns / 1000000.0);
+
+	// the jobs run in order, so a later job for the same replay after a trim replaces these
+	pthread_mutex_lock(&c->replay_mutex);
+	struct replay_library_entry *entry = replay_library_find(&c->replays, job->id);
+	if (entry) {
+		thumbnails->serial = ++c->thumbnail_serial;
+		struct replay_thumbnails *old = entry->thumbnails;
+		entry->thumbnails = thumbnails;
+		thumbnails = old;
+	}
+	pthread_mutex_unlock(&c->replay_mutex);
+	replay_thumbnails_release(thumbnails);
+}
+
+static void *replay_thumbnail_thread(void *data)
+{
+	struct replay_source *context = data;
+	os_set_thread_name("replay_source: thumbnails");
+	while (os_sem_wait(context->thumbnail_sem) == 0) {
+		if (context->thumbnail_stop)
+			break;
+		struct replay_thumbnail_job job;
+		bool found = false;
+		pthread_mutex_lock(&context->thumbnail_mutex);
+		if (context->thumbnail_jobs.size) {
+			circlebuf_pop_front(&context->thumbnail_jobs, &job, sizeof(job));
+			found = true;
+		}
+		pthread_mutex_unlock(&context->thumbnail_mutex);
+		if (found)
+			replay_thumbnails_make(context, &job);
+	}
+	return NULL;
+}
+
 static void replay_retrieve(struct replay_source *context);
 
-void replay_trigger_threshold(void *data)
+// called from the audio thread, only posts the trigger to the trigger thread
+void replay_trigger_threshold(void *data, uint64_t timestamp)
 {
 	struct replay_source *context = data;
-	const uint64_t os_time = obs_get_video_frame_time();
-	uint64_t duration = context->current_replay.duration;
-	if (context->speed_percent < 100.f)
-		duration = (uint64_t)(duration * 100.0 / context->speed_percent);
-	if (context->threshold_timestamp && context->threshold_timestamp + context->retrieve_delay + duration > os_time)
+	// runs on the audio thread, a reference to the replay could end up being the last one and free it here
+	uint64_t duration = replay_atomic_load_u64(&context->current_duration);
+	const uint64_t output_duration =
+		(uint64_t)((double)replay_atomic_load_u64(&context->current_output_duration) * 100.0 / context->speed_percent);
+	if (output_duration > duration)
+		duration = output_duration;
+	const uint64_t threshold_timestamp = replay_atomic_load_u64(&context->threshold_timestamp);
+	if (threshold_timestamp && threshold_timestamp + context->retrieve_delay + duration > timestamp)
 		return;
 
-	context->threshold_timestamp = os_time;
-	blog(LOG_INFO, "[replay_source: '%s'] audio triggered", obs_source_get_name(context->source));
-	if (context->retrieve_delay > 0) {
-		context->retrieve_timestamp = obs_get_video_frame_time() + context->retrieve_delay;
-	} else {
-		replay_retrieve(context);
+	replay_atomic_set_u64(&context->threshold_timestamp, timestamp);
+	replay_atomic_set_u64(&context->trigger_timestamp, timestamp);
+	os_sem_post(context->trigger_sem);
+}
+
+static void *replay_trigger_thread(void *data)
+{
+	struct replay_source *context = data;
+	os_set_thread_name("replay_source: trigger");
+	while (os_sem_wait(context->trigger_sem) == 0) {
+		if (context->trigger_stop)
+			break;
+		const uint64_t timestamp = replay_atomic_load_u64(&context->trigger_timestamp);
+		blog(LOG_INFO, "[replay_source: '%s'] audio triggered", obs_source_get_name(context->source));
+		if (context->retrieve_delay > 0) {
+			replay_atomic_set_u64(&context->retrieve_timestamp, timestamp + context->retrieve_delay);
+		} else {
+			replay_retrieve(context);
+		}
 	}
+	return NULL;
 }
 
 static void replay_source_defaults(obs_data_t *settings)
 {
 	obs_data_set_default_int(settings, SETTING_DURATION, 5000);
 	obs_data_set_default_int(settings, SETTING_REPLAYS, 1);
+	obs_data_set_default_int(settings, SETTING_SPILL_REPLAYS, 0);
+	char *spill_directory = obs_module_config_path("spill");
+	obs_data_set_default_string(settings, SETTING_SPILL_DIRECTORY, spill_directory);
+	bfree(spill_directory);
+	obs_data_set_default_int(settings, SETTING_THUMBNAILS, 8);
 	obs_data_set_default_int(settings, SETTING_SPEED, 100);
 	obs_data_set_default_int(settings, SETTING_VISIBILITY_ACTION, VISIBILITY_ACTION_CONTINUE);
 	obs_data_set_default_int(settings, SETTING_START_DELAY, 0);
 	obs_data_set_default_int(settings, SETTING_FRAME_STEP_COUNT, 5);
 	obs_data_set_default_int(settings, SETTING_END_ACTION, END_ACTION_LOOP);
 	obs_data_set_default_bool(settings, SETTING_BACKWARD, false);
+	obs_data_set_default_bool(settings, SETTING_PRESERVE_PITCH, false);
+	obs_data_set_default_string(settings, SETTING_SPEED_RAMP, "");
+	obs_data_set_default_int(settings, SETTING_INTERPOLATION, INTERP_MODE_NONE);
+	obs_data_set_default_bool(settings, SETTING_FRAME_PACING, true);
+	obs_data_set_default_bool(settings, SETTING_LIVE, false);
+	obs_data_set_default_int(settings, SETTING_LIVE_DELAY, 2000);
+	obs_data_set_default_double(settings, SETTING_LIVE_CATCH_UP, 200.0);
 	obs_data_set_default_string(settings, SETTING_FILE_FORMAT, "%CCYY-%MM-%DD %hh.%mm.%ss");
 	obs_data_set_default_bool(settings, SETTING_LOSSLESS, false);
+	replay_trigger_defaults(settings);
+	replay_arm_defaults(settings);
 }
 
 static void replay_source_show(void *data)
@@ -692,7 +1615,7 @@ void replay_stop(void *data)
 void replay_next(void *data)
 {
 	struct replay_source *context = data;
-	const int replay_count = (int)(context->replays.size / sizeof context->current_replay);
+	const int replay_count = replay_list_count(context);
 	if (replay_count == 0)
 		return;
 
@@ -716,7 +1639,7 @@ void replay_previous(void *data)
 	}
 	replay_update_position(context, true);
 	blog(LOG_INFO, "[replay_source: '%s'] previous hotkey switched to replay %i/%i", obs_source_get_name(context->source),
-	     context->replay_position + 1, (int)(context->replays.size / sizeof context->current_replay));
+	     context->replay_position + 1, replay_list_count(context));
 }
 
 static void replay_play_pause(void *data, bool pause)
@@ -745,8 +1668,10 @@ static void replay_play_pause(void *data, bool pause)
 		if (c->end || (c->video_frame_position == 0 && c->backward)) {
 			c->end = false;
 			if (c->backward) {
-				if (c->current_replay.video_frame_count)
-					c->video_frame_position = c->current_replay.video_frame_count - 1;
+				struct replay *replay = replay_snapshot(c, &c->current_replay);
+				if (replay->video_frame_count)
+					c->video_frame_position = replay->video_frame_count - 1;
+				replay_release(replay);
 			} else {
 				c->video_frame_position = 0;
 			}
@@ -810,87 +1735,53 @@ static inline size_t convert_time_to_frames(size_t sample_rate, uint64_t t)
 	return (size_t)(t * (uint64_t)sample_rate / 1000000000ULL);
 }
 
-bool audio_input_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint64_t *out_ts, uint32_t mixers,
-			  struct audio_output_data *mixes)
+static void replay_mix_audio(struct replay *replay, uint64_t duration_start, uint64_t duration_end, size_t channels,
+			     size_t sample_rate, struct audio_output_data *mixes)
 {
-	UNUSED_PARAMETER(mixers);
-	struct replay_source *context = param;
-
-	*out_ts = start_ts_in;
-
-	if (!context->audio_t)
-		return true;
-
-	if (!context->start_save_timestamp || start_ts_in < context->start_save_timestamp)
-		return true;
-
-	uint64_t end_timestamp = context->start_save_timestamp + context->saving_replay.last_frame_timestamp -
-				 context->saving_replay.first_frame_timestamp;
-	if (start_ts_in > end_timestamp)
-		return true;
-
-	size_t channels = audio_output_get_channels(context->audio_t);
-	size_t sample_rate = audio_output_get_sample_rate(context->audio_t);
-
-	pthread_mutex_lock(&context->audio_mutex);
-
 	uint64_t i = 0;
-	uint64_t duration_start = start_ts_in - context->start_save_timestamp;
-	uint64_t duration_end = end_ts_in - context->start_save_timestamp;
-	while (i < context->saving_replay.audio_frame_count &&
-	       context->saving_replay.audio_frames[i].timestamp < context->saving_replay.first_frame_timestamp) {
+	while (i < replay->audio_frame_count && replay->audio_frames[i].timestamp < replay->first_frame_timestamp) {
 		i++;
 	}
-	if (i == context->saving_replay.audio_frame_count) {
-		pthread_mutex_unlock(&context->audio_mutex);
-		return true;
-	}
+	if (i == replay->audio_frame_count)
+		return;
 
-	while (i < context->saving_replay.audio_frame_count &&
-	       context->saving_replay.audio_frames[i].timestamp - context->saving_replay.first_frame_timestamp < duration_start) {
+	while (i < replay->audio_frame_count &&
+	       replay->audio_frames[i].timestamp - replay->first_frame_timestamp < duration_start) {
 		i++;
 	}
-	if (i == context->saving_replay.audio_frame_count) {
-		pthread_mutex_unlock(&context->audio_mutex);
-		return true;
-	}
+	if (i == replay->audio_frame_count)
+		return;
 	if (i)
 		i--;
 
-	while (i < context->saving_replay.audio_frame_count &&
-	       duration_end >= context->saving_replay.audio_frames[i].timestamp - context->saving_replay.first_frame_timestamp) {
+	while (i < replay->audio_frame_count &&
+	       duration_end >= replay->audio_frames[i].timestamp - replay->first_frame_timestamp) {
 		size_t total_floats = AUDIO_OUTPUT_FRAMES;
 		size_t start_point = 0;
 		size_t start_point2 = 0;
-		if (context->saving_replay.audio_frames[i].timestamp - context->saving_replay.first_frame_timestamp >
-		    duration_start) {
-			start_point = convert_time_to_frames(sample_rate, context->saving_replay.audio_frames[i].timestamp -
-										  context->saving_replay.first_frame_timestamp -
-										  duration_start);
-			if (start_point >= AUDIO_OUTPUT_FRAMES) {
-				pthread_mutex_unlock(&context->audio_mutex);
-				return true;
-			}
+		if (replay->audio_frames[i].timestamp - replay->first_frame_timestamp > duration_start) {
+			start_point = convert_time_to_frames(sample_rate, replay->audio_frames[i].timestamp -
+										  replay->first_frame_timestamp - duration_start);
+			if (start_point >= AUDIO_OUTPUT_FRAMES)
+				return;
 
 			total_floats -= start_point;
-		} else if (context->saving_replay.audio_frames[i].timestamp - context->saving_replay.first_frame_timestamp <
-			   duration_start) {
-			start_point2 = convert_time_to_frames(sample_rate,
-							      duration_start - (context->saving_replay.audio_frames[i].timestamp -
-										context->saving_replay.first_frame_timestamp));
-			if (start_point2 >= context->saving_replay.audio_frames[i].frames) {
+		} else if (replay->audio_frames[i].timestamp - replay->first_frame_timestamp < duration_start) {
+			start_point2 = convert_time_to_frames(
+				sample_rate, duration_start - (replay->audio_frames[i].timestamp - replay->first_frame_timestamp));
+			if (start_point2 >= replay->audio_frames[i].frames) {
 				i++;
 				continue;
 			}
 		}
-		if (context->saving_replay.audio_frames[i].frames - start_point2 < total_floats) {
-			total_floats = context->saving_replay.audio_frames[i].frames - start_point2;
+		if (replay->audio_frames[i].frames - start_point2 < total_floats) {
+			total_floats = replay->audio_frames[i].frames - start_point2;
 		}
 
 		for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
 			for (size_t ch = 0; ch < channels; ch++) {
 				register float *mix = mixes[mix_idx].data[ch];
-				register float *aud = (float *)context->saving_replay.audio_frames[i].data[ch];
+				register float *aud = (float *)replay->audio_frames[i].data[ch];
 				register float *end;
 
 				if (!aud)
@@ -906,26 +1797,89 @@ bool audio_input_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in,
 		}
 		i++;
 	}
-	pthread_mutex_unlock(&context->audio_mutex);
+}
+
+// mixes one block of output audio starting at output time duration_start, following the speed ramp of the replay
+static void replay_mix_audio_mapped(struct replay *replay, uint64_t duration_start, size_t channels, size_t sample_rate,
+				    struct audio_output_data *mixes)
+{
+	const int64_t front = replay_time_map_output(&replay->time_map, replay->trim_front > 0 ? replay->trim_front : 0);
+	for (size_t i = 0; i < AUDIO_OUTPUT_FRAMES; i++) {
+		const int64_t output = front + (int64_t)duration_start + (int64_t)audio_frames_to_ns(sample_rate, i);
+		const int64_t offset = replay_time_map_source(&replay->time_map, output);
+		if (offset < 0)
+			continue;
+		const uint64_t source = replay->first_frame_timestamp + (uint64_t)offset;
+		uint64_t packet = replay_lower_bound(replay->audio_timestamps, replay->audio_frame_count, source + 1);
+		if (!packet)
+			continue;
+		const struct obs_audio_data *audio = &replay->audio_frames[packet - 1];
+		const size_t index = convert_time_to_frames(replay->oai.samples_per_sec, source - audio->timestamp);
+		if (index >= audio->frames)
+			continue;
+		for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
+			for (size_t ch = 0; ch < channels; ch++) {
+				if (audio->data[ch])
+					mixes[mix_idx].data[ch][i] += ((const float *)audio->data[ch])[index];
+			}
+		}
+	}
+}
+
+bool audio_input_callback(void *param, uint64_t start_ts_in, uint64_t end_ts_in, uint64_t *out_ts, uint32_t mixers,
+			  struct audio_output_data *mixes)
+{
+	UNUSED_PARAMETER(mixers);
+	struct replay_source *context = param;
+
+	*out_ts = start_ts_in;
+
+	if (!context->audio_t)
+		return true;
+
+	if (!context->start_save_timestamp || start_ts_in < context->start_save_timestamp)
+		return true;
+
+	struct replay *replay = replay_snapshot(context, &context->saving_replay);
+	if (!replay)
+		return true;
+
+	uint64_t end_timestamp =
+		context->start_save_timestamp +
+		(uint64_t)replay_time_map_output(&replay->time_map,
+						 (int64_t)(replay->last_frame_timestamp - replay->first_frame_timestamp));
+	if (start_ts_in <= end_timestamp) {
+		size_t channels = audio_output_get_channels(context->audio_t);
+		size_t sample_rate = audio_output_get_sample_rate(context->audio_t);
+
+		if (replay->time_map.count)
+			replay_mix_audio_mapped(replay, start_ts_in - context->start_save_timestamp, channels, sample_rate, mixes);
+		else
+			replay_mix_audio(replay, start_ts_in - context->start_save_timestamp,
+					 end_ts_in - context->start_save_timestamp, channels, sample_rate, mixes);
+	}
+	replay_release(replay);
 
 	return true;
 }
 
 void replay_save(struct replay_source *context)
 {
-	if (context->current_replay.video_frame_count == 0) {
-		context->saving_status = SAVING_STATUS_NONE;
-		return;
-	}
 	if (context->saving_status != SAVING_STATUS_NONE && context->saving_status != SAVING_STATUS_STARTING)
 		return;
 
 	pthread_mutex_lock(&context->video_mutex);
+	replay_publish(context, &context->saving_replay, context->current_replay);
+	pthread_mutex_unlock(&context->video_mutex);
 
-	memcpy(&context->saving_replay, &context->current_replay, sizeof context->current_replay);
+	if (context->saving_replay->video_frame_count == 0) {
+		context->saving_status = SAVING_STATUS_NONE;
+		replay_publish(context, &context->saving_replay, NULL);
+		return;
+	}
 
-	const uint32_t width = context->saving_replay.video_frames[0]->width;
-	const uint32_t height = context->saving_replay.video_frames[0]->height;
+	const uint32_t width = context->saving_replay->video_frames[0]->width;
+	const uint32_t height = context->saving_replay->video_frames[0]->height;
 	if (context->known_width != width || context->known_height != height) {
 		video_t *t = obs_get_video();
 		const struct video_output_info *ovi = video_output_get_info(t);
@@ -945,10 +1899,7 @@ void replay_save(struct replay_source *context)
 		const int r = video_output_open(&context->video_output, &vi);
 		if (r != VIDEO_OUTPUT_SUCCESS) {
 			context->saving_status = SAVING_STATUS_NONE;
-			pthread_mutex_unlock(&context->video_mutex);
-			if (context->free_after_save) {
-				replay_free_replay(&context->saving_replay, context);
-			}
+			replay_publish(context, &context->saving_replay, NULL);
 			return;
 		}
 
@@ -961,11 +1912,11 @@ void replay_save(struct replay_source *context)
 		}
 
 		struct video_scale_info ssi;
-		ssi.format = context->saving_replay.video_frames[0]->format;
+		ssi.format = context->saving_replay->video_frames[0]->format;
 		ssi.colorspace = ovi->colorspace;
 		ssi.range = ovi->range;
-		ssi.width = context->saving_replay.video_frames[0]->width;
-		ssi.height = context->saving_replay.video_frames[0]->height;
+		ssi.width = context->saving_replay->video_frames[0]->width;
+		ssi.height = context->saving_replay->video_frames[0]->height;
 		struct video_scale_info dsi;
 		dsi.format = vi.format;
 		dsi.colorspace = ovi->colorspace;
@@ -977,18 +1928,15 @@ void replay_save(struct replay_source *context)
 	if (!context->audio_t) {
 		struct audio_output_info oi;
 		oi.name = "ReplayAudio";
-		oi.speakers = context->saving_replay.oai.speakers;
-		oi.samples_per_sec = context->saving_replay.oai.samples_per_sec;
-		oi.format = context->saving_replay.oai.format;
+		oi.speakers = context->saving_replay->oai.speakers;
+		oi.samples_per_sec = context->saving_replay->oai.samples_per_sec;
+		oi.format = context->saving_replay->oai.format;
 		oi.input_param = context;
 		oi.input_callback = audio_input_callback;
 		const int r = audio_output_open(&context->audio_t, &oi);
 		if (r != AUDIO_OUTPUT_SUCCESS) {
 			context->saving_status = SAVING_STATUS_NONE;
-			pthread_mutex_unlock(&context->video_mutex);
-			if (context->free_after_save) {
-				replay_free_replay(&context->saving_replay, context);
-			}
+			replay_publish(context, &context->saving_replay, NULL);
 			return;
 		}
 	}
@@ -1000,15 +1948,21 @@ void replay_save(struct replay_source *context)
 		}
 	}
 
-	char *filename = os_generate_formatted_filename(context->lossless ? "avi" : "flv", true, context->file_format);
 	struct dstr path = {NULL, 0, 0};
-	dstr_copy(&path, context->directory);
-	dstr_replace(&path, "\\", "/");
-	if (dstr_end(&path) != '/')
-		dstr_cat_ch(&path, '/');
-	dstr_cat(&path, filename);
-	blog(LOG_INFO, "[replay_source: '%s'] start saving '%s'", obs_source_get_name(context->source), filename);
-	bfree(filename);
+	if (context->save_path) {
+		dstr_copy(&path, context->save_path);
+		bfree(context->save_path);
+		context->save_path = NULL;
+	} else {
+		char *filename = os_generate_formatted_filename(context->lossless ? "avi" : "flv", true, context->file_format);
+		dstr_copy(&path, context->directory);
+		dstr_replace(&path, "\\", "/");
+		if (dstr_end(&path) != '/')
+			dstr_cat_ch(&path, '/');
+		dstr_cat(&path, filename);
+		bfree(filename);
+	}
+	blog(LOG_INFO, "[replay_source: '%s'] start saving '%s'", obs_source_get_name(context->source), path.array);
 	obs_data_t *settings = obs_data_create();
 	obs_data_set_string(settings, "path", path.array);
 	obs_data_set_string(settings, "url", path.array);
@@ -1020,16 +1974,15 @@ void replay_save(struct replay_source *context)
 	context->video_save_position = 0;
 	context->start_save_timestamp = obs_get_video_frame_time();
 
-	struct obs_source_frame *frame = context->saving_replay.video_frames[0];
-	if (context->saving_replay.trim_front) {
-		while (frame->timestamp < context->saving_replay.first_frame_timestamp + context->saving_replay.trim_front) {
+	struct obs_source_frame *frame = context->saving_replay->video_frames[0];
+	if (context->saving_replay->trim_front) {
+		while (frame->timestamp < context->saving_replay->first_frame_timestamp + context->saving_replay->trim_front) {
 			context->video_save_position++;
-			if (context->video_save_position >= context->saving_replay.video_frame_count) {
+			if (context->video_save_position >= context->saving_replay->video_frame_count) {
 				context->saving_status = SAVING_STATUS_STOPPING;
-				pthread_mutex_unlock(&context->video_mutex);
 				return;
 			}
-			frame = context->saving_replay.video_frames[context->video_save_position];
+			frame = context->saving_replay->video_frames[context->video_save_position];
 		}
 	}
 	struct video_frame output_frame;
@@ -1038,7 +1991,6 @@ void replay_save(struct replay_source *context)
 				   frame->linesize);
 		video_output_unlock_frame(context->video_output);
 	}
-	pthread_mutex_unlock(&context->video_mutex);
 	if (!obs_output_start(context->fileOutput)) {
 		const char *error = obs_output_get_last_error(context->fileOutput);
 		if (error)
@@ -1048,9 +2000,7 @@ void replay_save(struct replay_source *context)
 			blog(LOG_WARNING, "[replay_source: '%s'] error output start", obs_source_get_name(context->source));
 
 		context->saving_status = SAVING_STATUS_NONE;
-		if (context->free_after_save) {
-			replay_free_replay(&context->saving_replay, context);
-		}
+		replay_publish(context, &context->saving_replay, NULL);
 		return;
 	}
 	context->saving_status = SAVING_STATUS_STARTING2;
@@ -1063,26 +2013,373 @@ static void *update_scene_thread(void *data)
 	return NULL;
 }
 
-static void replay_retrieve(struct replay_source *context)
+/* the part of the buffer a retrieve keeps, in ns back from the newest frame,
+ * a zero duration keeps everything before the end */
+struct replay_range {
+	uint64_t duration;
+	uint64_t end;
+};
+
+static void replay_add(struct replay_source *context, struct replay *new_replay, const struct replay_range *range);
+
+// the replay filter of the parent, the pointer stays valid while the caller holds the parent
+static obs_source_t *replay_bind_filter(struct replay_source *c, struct replay_binding *b, obs_source_t *parent, bool audio)
+{
+	if (!parent)
+		return NULL;
+	pthread_mutex_lock(&c->bindings_mutex);
+	const long generation = os_atomic_load_long(&replay_bindings_generation);
+	if (b->name && strcmp(b->name, c->filter_name) == 0) {
+		if (b->weak) {
+			obs_source_t *filter = obs_weak_source_get_source(b->weak);
+			const bool attached = filter && obs_filter_get_parent(filter) == parent;
+			obs_source_release(filter);
+			if (attached) {
+				pthread_mutex_unlock(&c->bindings_mutex);
+				return filter;
+			}
+		} else if (b->generation == generation) {
+			pthread_mutex_unlock(&c->bindings_mutex);
+			return NULL;
+		}
+	}
+	replay_unbind(b);
+	b->name = bstrdup(c->filter_name);
+	b->generation = generation;
+	obs_source_t **slot = audio ? &c->source_audio_filter : &c->source_filter;
+	*slot = NULL;
+	obs_source_enum_filters(parent, audio ? EnumAudioVideoFilter : EnumFilter, c);
+	if (*slot)
+		b->weak = obs_source_get_weak_source(*slot);
+	pthread_mutex_unlock(&c->bindings_mutex);
+	return *slot;
+}
+
+struct replay_angle_build {
+	obs_source_t *source;
+	struct replay_circlebuf video_frames;
+	struct replay *replay;
+	const struct replay *audio;
+	uint64_t start;
+	uint64_t end;
+	const struct replay_speed_ramp *ramp;
+	pthread_t thread;
+	bool thread_active;
+};
+
+struct replay_angle_find {
+	const char *name;
+	obs_source_t *filter;
+};
+
+static void EnumAngleFilter(obs_source_t *source, obs_source_t *filter, void *data)
+{
+	UNUSED_PARAMETER(source);
+	struct replay_angle_find *find = data;
+	const char *id = obs_source_get_unversioned_id(filter);
+	if ((strcmp(REPLAY_FILTER_ASYNC_ID, id) == 0 || strcmp(REPLAY_FILTER_ID, id) == 0) &&
+	    strcmp(obs_source_get_name(filter), find->name) == 0)
+		find->filter = filter;
+}
+
+// the video replay filter this replay source added to an angle source
+static obs_source_t *replay_angle_filter(struct replay_source *context, obs_source_t *s)
+{
+	struct replay_angle_find find = {context->filter_name, NULL};
+	obs_source_enum_filters(s, EnumAngleFilter, &find);
+	return find.filter;
+}
+
+void update_filter_settings(obs_source_t *filter, obs_data_t *settings);
+
+// the filters are owned by another replay source, they are only read and never added, changed or removed
+static inline bool replay_filter_shared(const struct replay_source *context)
+{
+	return strcmp(context->filter_name, obs_source_get_name(context->source)) != 0;
+}
+
+static void replay_connect_angle(struct replay_source *context, struct replay_binding *binding, const char *name,
+				 obs_data_t *settings)
+{
+	if (replay_filter_shared(context))
+		return;
+	obs_source_t *s = replay_bind(context, binding, name);
+	if (!s)
+		return;
+	obs_source_t *filter = replay_angle_filter(context, s);
+	if (filter) {
+		update_filter_settings(filter, settings);
+	} else {
+		const bool async = (obs_source_get_output_flags(s) & OBS_SOURCE_ASYNC) == OBS_SOURCE_ASYNC;
+		filter = obs_source_create_private(async ? REPLAY_FILTER_ASYNC_ID : REPLAY_FILTER_ID,
+						   obs_source_get_name(context->source), settings);
+		if (filter) {
+			obs_source_filter_add(s, filter);
+			obs_source_release(filter);
+			blog(LOG_INFO, "[replay_source: '%s'] created angle filter for '%s'", obs_source_get_name(context->source),
+			     name);
+		}
+	}
+	obs_source_release(s);
+}
+
+static void replay_disconnect_angle(struct replay_source *context, struct replay_binding *binding, const char *name)
+{
+	if (replay_filter_shared(context))
+		return;
+	obs_source_t *s = replay_bind(context, binding, name);
+	if (!s)
+		return;
+	obs_source_t *filter = replay_angle_filter(context, s);
+	if (filter)
+		obs_source_filter_remove(s, filter);
+	obs_source_release(s);
+}
+
+static bool replay_has_angle(char **names, size_t count, const char *name)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (strcmp(names[i], name) == 0)
+			return true;
+	}
+	return false;
+}
+
+// connects the replay filters of the angle sources and disconnects the ones no longer listed
+static void replay_update_angles(struct replay_source *context, obs_data_t *settings)
+{
+	obs_data_array_t *array = obs_data_get_array(settings, SETTING_ANGLE_SOURCES);
+	const size_t count = array ? obs_data_array_count(array) : 0;
+	char **names = count ? bzalloc(count * sizeof(char *)) : NULL;
+	struct replay_filter_cursor *cursors = count ? bzalloc(count * sizeof(struct replay_filter_cursor)) : NULL;
+	struct replay_binding *bindings = count ? bzalloc(count * sizeof(struct replay_binding)) : NULL;
+	size_t name_count = 0;
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *item = obs_data_array_item(array, i);
+		const char *name = obs_data_get_string(item, "value");
+		if (name && *name && strcmp(name, context->source_name) != 0 && !replay_has_angle(names, name_count, name)) {
+			// angles that stay keep their read position and their binding
+			for (size_t j = 0; j < context->angle_name_count; j++) {
+				if (strcmp(context->angle_names[j], name) == 0) {
+					cursors[name_count] = context->angle_cursors[j];
+					if (!context->disabled) {
+						bindings[name_count] = context->angle_bindings[j];
+						memset(&context->angle_bindings[j], 0, sizeof(struct replay_binding));
+					}
+				}
+			}
+			names[name_count++] = bstrdup(name);
+		}
+		obs_data_release(item);
+	}
+	if (array)
+		obs_data_array_release(array);
+
+	for (size_t i = 0; i < context->angle_name_count; i++) {
+		if (context->disabled || !replay_has_angle(names, name_count, context->angle_names[i]))
+			replay_disconnect_angle(context, &context->angle_bindings[i], context->angle_names[i]);
+		replay_unbind(&context->angle_bindings[i]);
+		bfree(context->angle_names[i]);
+	}
+	bfree(context->angle_names);
+	bfree(context->angle_cursors);
+	bfree(context->angle_bindings);
+	context->angle_names = names;
+	context->angle_cursors = cursors;
+	context->angle_bindings = bindings;
+	context->angle_name_count = name_count;
+	if (!context->disabled) {
+		for (size_t i = 0; i < name_count; i++)
+			replay_connect_angle(context, &bindings[i], names[i], settings);
+	}
+}
+
+// builds one angle from its snapshot with only the frames of the common time range
+static void *replay_build_angle(void *data)
+{
+	struct replay_angle_build *build = data;
+	struct replay *replay = build->replay;
+	const size_t count = build->video_frames.size / sizeof(struct obs_source_frame *);
+	replay->video_frames = bzalloc(count * sizeof(struct obs_source_frame *));
+	while (build->video_frames.size) {
+		struct obs_source_frame *frame;
+		circlebuf_pop_front(&build->video_frames, &frame, sizeof(struct obs_source_frame *));
+		if (frame->timestamp < build->start || frame->timestamp > build->end) {
+			if (os_atomic_dec_long(&frame->refs) <= 0)
+				obs_source_frame_destroy(frame);
+			continue;
+		}
+		replay->video_frames[replay->video_frame_count++] = frame;
+	}
+	circlebuf_free(&build->video_frames);
+
+	// every angle plays the same audio so switching keeps the audio position
+	if (build->audio && build->audio->audio_frame_count) {
+		const struct replay *audio = build->audio;
+		replay->oai = audio->oai;
+		replay->audio_frames = bzalloc((size_t)audio->audio_frame_count * sizeof(struct obs_audio_data));
+		replay->audio_frame_count = audio->audio_frame_count;
+		for (uint64_t i = 0; i < audio->audio_frame_count; i++) {
+			replay->audio_frames[i] = audio->audio_frames[i];
+			replay_audio_packet_addref(&replay->audio_frames[i]);
+		}
+	}
+	replay->first_frame_timestamp = build->start;
+	replay->last_frame_timestamp = build->end;
+	replay->duration = build->end - build->start;
+	replay_index_timestamps(replay);
+	replay_time_map_build(&replay->time_map, build->ramp, replay->duration);
+	return NULL;
+}
+
+// retrieves the source and its angle sources over their common time range, the angles are built in parallel
+static void replay_retrieve_angles(struct replay_source *context, const struct replay_range *range)
+{
+	const uint64_t begin = os_gettime_ns();
+	const size_t count = context->angle_name_count + 1;
+	struct replay_angle_build *builds = bzalloc(count * sizeof(struct replay_angle_build));
+
+	// take every buffer at the same moment, only references are taken so shared buffers stay intact
+	uint64_t start = 0;
+	uint64_t end = UINT64_MAX;
+	size_t angles = 0;
+	for (size_t i = 0; i < count; i++) {
+		struct replay_angle_build *build = &builds[i];
+		build->source = i ? replay_bind(context, &context->angle_bindings[i - 1], context->angle_names[i - 1])
+				  : replay_bind(context, &context->source_binding, context->source_name);
+		obs_source_t *filter = build->source ? replay_angle_filter(context, build->source) : NULL;
+		struct replay_filter *vf = filter ? obs_obj_get_data(filter) : NULL;
+		if (!vf)
+			continue;
+		replay_filter_read_video(vf, i ? &context->angle_cursors[i - 1] : &context->cursor, &build->video_frames);
+		if (!build->video_frames.size)
+			continue;
+		struct obs_source_frame *frame;
+		circlebuf_peek_front(&build->video_frames, &frame, sizeof(struct obs_source_frame *));
+		if (frame->timestamp > start)
+			start = frame->timestamp;
+		circlebuf_peek_back(&build->video_frames, &frame, sizeof(struct obs_source_frame *));
+		if (frame->timestamp < end)
+			end = frame->timestamp;
+		angles++;
+	}
+	if (angles && end < start) {
+		blog(LOG_WARNING, "[replay_source: '%s'] angles do not overlap, only the first angle is kept",
+		     obs_source_get_name(context->source));
+		for (size_t i = 0; i < count; i++) {
+			if (!builds[i].video_frames.size)
+				continue;
+			struct obs_source_frame *frame;
+			circlebuf_peek_front(&builds[i].video_frames, &frame, sizeof(struct obs_source_frame *));
+			start = frame->timestamp;
+			circlebuf_peek_back(&builds[i].video_frames, &frame, sizeof(struct obs_source_frame *));
+			end = frame->timestamp;
+			break;
+		}
+	}
+
+	struct replay *new_replay = NULL;
+	if (angles) {
+		new_replay = replay_create();
+		obs_source_t *as = replay_bind(context, &context->source_audio_binding, context->source_audio_name);
+		context->source_audio_filter = NULL;
+		if (as)
+			obs_source_enum_filters(as, EnumAudioVideoFilter, context);
+		obs_source_t *main_filter = builds[0].source ? replay_angle_filter(context, builds[0].source) : NULL;
+		struct replay_filter *af = context->source_audio_filter ? obs_obj_get_data(context->source_audio_filter)
+					   : main_filter                ? obs_obj_get_data(main_filter)
+									: NULL;
+		new_replay->oai.speakers = SPEAKERS_STEREO;
+		new_replay->oai.samples_per_sec = 48000;
+		new_replay->oai.format = AUDIO_FORMAT_FLOAT_PLANAR;
+		if (af) {
+			struct replay_circlebuf audio_frames;
+			circlebuf_init(&audio_frames);
+			replay_filter_read_audio(af, &context->cursor, &audio_frames, &new_replay->oai);
+			new_replay->audio_frames = bzalloc(audio_frames.size);
+			while (audio_frames.size) {
+				struct obs_audio_data audio;
+				circlebuf_pop_front(&audio_frames, &audio, sizeof(struct obs_audio_data));
+				const uint64_t audio_duration = audio_frames_to_ns(new_replay->oai.samples_per_sec, audio.frames);
+				if (audio.timestamp + audio_duration < start || audio.timestamp > end) {
+					free_audio_packet(&audio);
+					continue;
+				}
+				new_replay->audio_frames[new_replay->audio_frame_count++] = audio;
+			}
+			circlebuf_free(&audio_frames);
+		}
+		if (as)
+			obs_source_release(as);
+	}
+
+	size_t index = 0;
+	struct replay **replays = angles ? bzalloc(angles * sizeof(struct replay *)) : NULL;
+	for (size_t i = 0; i < count; i++) {
+		struct replay_angle_build *build = &builds[i];
+		if (!build->video_frames.size)
+			continue;
+		build->replay = index ? replay_create() : new_replay;
+		build->audio = index ? new_replay : NULL;
+		build->start = start;
+		build->end = end;
+		build->ramp = &context->speed_ramp;
+		replays[index++] = build->replay;
+		build->thread_active = pthread_create(&build->thread, NULL, replay_build_angle, build) == 0;
+		if (!build->thread_active)
+			replay_build_angle(build);
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (builds[i].thread_active)
+			pthread_join(builds[i].thread, NULL);
+		circlebuf_free(&builds[i].video_frames);
+		if (builds[i].source)
+			obs_source_release(builds[i].source);
+	}
+	bfree(builds);
+	if (!new_replay)
+		return;
+
+	new_replay->angles = replays;
+	new_replay->angle_count = angles;
+	replays[0] = NULL;
+	blog(LOG_INFO, "[replay_source: '%s'] retrieved %d angles in %.2f ms", obs_source_get_name(context->source), (int)angles,
+	     (double)(os_gettime_ns() - begin) / 1000000.0);
+	replay_add(context, new_replay, range);
+}
+
+static void replay_retrieve_range_locked(struct replay_source *context, const struct replay_range *range)
 {
-	obs_source_t *s = obs_get_source_by_name(context->source_name);
-	context->source_filter = NULL;
-	if (s)
-		obs_source_enum_filters(s, EnumFilter, context);
-
-	obs_source_t *as = obs_get_source_by_name(context->source_audio_name);
-	context->source_audio_filter = NULL;
-	if (as)
-		obs_source_enum_filters(as, EnumAudioVideoFilter, context);
+	if (context->angle_name_count) {
+		replay_retrieve_angles(context, range);
+		return;
+	}
+	obs_source_t *s = replay_bind(context, &context->source_binding, context->source_name);
+	context->source_filter = replay_bind_filter(context, &context->filter_binding, s, false);
+	obs_source_t *as = replay_bind(context, &context->source_audio_binding, context->source_audio_name);
+	context->source_audio_filter = replay_bind_filter(context, &context->audio_filter_binding, as, true);
 
 	struct replay_filter *vf = context->source_filter ? obs_obj_get_data(context->source_filter) : NULL;
 	struct replay_filter *af = context->source_audio_filter ? obs_obj_get_data(context->source_audio_filter) : vf;
-	if (vf && vf->video_frames.size == 0)
+
+	// the filter buffers are shared, only what is new since the previous retrieve is taken
+	struct replay_circlebuf video_frames;
+	struct replay_circlebuf audio_frames;
+	struct audio_convert_info oai;
+	circlebuf_init(&video_frames);
+	circlebuf_init(&audio_frames);
+	if (vf)
+		replay_filter_read_video(vf, &context->cursor, &video_frames);
+	if (af)
+		replay_filter_read_audio(af, &context->cursor, &audio_frames, &oai);
+	if (!video_frames.size)
 		vf = NULL;
-	if (af && af->audio_frames.size == 0)
+	if (!audio_frames.size)
 		af = NULL;
 
 	if (!vf && !af) {
+		circlebuf_free(&video_frames);
+		circlebuf_free(&audio_frames);
 		if (s)
 			obs_source_release(s);
 		if (as)
@@ -1090,102 +2387,130 @@ static void replay_retrieve(struct replay_source *context)
 		return;
 	}
 
-	struct replay new_replay;
-	new_replay.last_frame_timestamp = 0;
-	new_replay.first_frame_timestamp = 0;
-	new_replay.trim_end = 0;
-	new_replay.trim_front = 0;
+	struct replay *new_replay = replay_create();
 	if (vf) {
 		struct obs_source_frame *frame;
-		pthread_mutex_lock(&vf->mutex);
-		if (vf->video_frames.size) {
-			circlebuf_peek_front(&vf->video_frames, &frame, sizeof(struct obs_source_frame *));
-			new_replay.first_frame_timestamp = frame->timestamp;
-			new_replay.last_frame_timestamp = frame->timestamp;
-		}
-		new_replay.video_frame_count = vf->video_frames.size / sizeof(struct obs_source_frame *);
-		new_replay.video_frames = bzalloc((size_t)new_replay.video_frame_count * sizeof(struct obs_source_frame *));
-		for (uint64_t i = 0; i < new_replay.video_frame_count; i++) {
-			circlebuf_pop_front(&vf->video_frames, &frame, sizeof(struct obs_source_frame *));
-			new_replay.last_frame_timestamp = frame->timestamp;
-			*(new_replay.video_frames + i) = frame;
-		}
-		pthread_mutex_unlock(&vf->mutex);
-	} else {
-		new_replay.video_frames = NULL;
-		new_replay.video_frame_count = 0;
+		if (video_frames.size) {
+			circlebuf_peek_front(&video_frames, &frame, sizeof(struct obs_source_frame *));
+			new_replay->first_frame_timestamp = frame->timestamp;
+			new_replay->last_frame_timestamp = frame->timestamp;
+		}
+		new_replay->video_frame_count = video_frames.size / sizeof(struct obs_source_frame *);
+		new_replay->video_frames = bzalloc((size_t)new_replay->video_frame_count * sizeof(struct obs_source_frame *));
+		for (uint64_t i = 0; i < new_replay->video_frame_count; i++) {
+			circlebuf_pop_front(&video_frames, &frame, sizeof(struct obs_source_frame *));
+			new_replay->last_frame_timestamp = frame->timestamp;
+			*(new_replay->video_frames + i) = frame;
+		}
 	}
+	circlebuf_free(&video_frames);
 	if (af) {
-		pthread_mutex_lock(&af->mutex);
 		struct obs_audio_data audio;
-		if (!vf && af->audio_frames.size) {
-			circlebuf_peek_front(&af->audio_frames, &audio, sizeof(struct obs_audio_data));
-			new_replay.first_frame_timestamp = audio.timestamp;
-			new_replay.last_frame_timestamp = audio.timestamp;
-		}
-		new_replay.oai = af->oai;
-		new_replay.audio_frame_count = af->audio_frames.size / sizeof(struct obs_audio_data);
-		new_replay.audio_frames = bzalloc((size_t)new_replay.audio_frame_count * sizeof(struct obs_audio_data));
-		for (uint64_t i = 0; i < new_replay.audio_frame_count; i++) {
-			circlebuf_pop_front(&af->audio_frames, &audio, sizeof(struct obs_audio_data));
+		new_replay->oai = oai;
+		if (!vf && audio_frames.size) {
+			circlebuf_peek_front(&audio_frames, &audio, sizeof(struct obs_audio_data));
+			new_replay->first_frame_timestamp = audio.timestamp;
+			new_replay->last_frame_timestamp = audio.timestamp;
+		}
+		new_replay->audio_frame_count = audio_frames.size / sizeof(struct obs_audio_data);
+		new_replay->audio_frames = bzalloc((size_t)new_replay->audio_frame_count * sizeof(struct obs_audio_data));
+		for (uint64_t i = 0; i < new_replay->audio_frame_count; i++) {
+			circlebuf_pop_front(&audio_frames, &audio, sizeof(struct obs_audio_data));
 			if (!vf) {
-				new_replay.last_frame_timestamp = audio.timestamp;
+				new_replay->last_frame_timestamp = audio.timestamp;
 			}
-			memcpy(&new_replay.audio_frames[i], &audio, sizeof(struct obs_audio_data));
+			memcpy(&new_replay->audio_frames[i], &audio, sizeof(struct obs_audio_data));
 			for (size_t j = 0; j < MAX_AV_PLANES; j++) {
 				if (!audio.data[j])
 					break;
 
-				new_replay.audio_frames[i].data[j] = audio.data[j];
+				new_replay->audio_frames[i].data[j] = audio.data[j];
 			}
 		}
-		pthread_mutex_unlock(&af->mutex);
 	} else {
-		new_replay.audio_frames = NULL;
-		new_replay.audio_frame_count = 0;
-		new_replay.oai.speakers = SPEAKERS_STEREO;
-		new_replay.oai.samples_per_sec = 48000;
-		new_replay.oai.format = AUDIO_FORMAT_FLOAT_PLANAR;
+		new_replay->oai.speakers = SPEAKERS_STEREO;
+		new_replay->oai.samples_per_sec = 48000;
+		new_replay->oai.format = AUDIO_FORMAT_FLOAT_PLANAR;
 	}
+	circlebuf_free(&audio_frames);
 	if (s)
 		obs_source_release(s);
 	if (as)
 		obs_source_release(as);
-	new_replay.duration = new_replay.last_frame_timestamp - new_replay.first_frame_timestamp;
+	new_replay->duration = new_replay->last_frame_timestamp - new_replay->first_frame_timestamp;
+	replay_index_timestamps(new_replay);
+	replay_time_map_build(&new_replay->time_map, &context->speed_ramp, new_replay->duration);
+	replay_add(context, new_replay, range);
+}
+
+// retrieves one at a time, taken before any other lock of the source
+static void replay_retrieve_range(struct replay_source *context, const struct replay_range *range)
+{
+	pthread_mutex_lock(&context->retrieve_mutex);
+	replay_retrieve_range_locked(context, range);
+	pthread_mutex_unlock(&context->retrieve_mutex);
+}
+
+static void replay_retrieve(struct replay_source *context)
+{
+	replay_retrieve_range(context, NULL);
+}
 
+// applies the start delay and the range to a retrieved replay and appends it to the list
+static void replay_add(struct replay_source *context, struct replay *new_replay, const struct replay_range *range)
+{
 	if (context->start_delay > 0) {
 		if (context->backward_start) {
 			if (context->speed_percent == 100.0f) {
-				new_replay.trim_end = context->start_delay * -1;
+				new_replay->trim_end = context->start_delay * -1;
 			} else {
-				new_replay.trim_end = (int64_t)(context->start_delay * context->speed_percent / -100.0);
+				new_replay->trim_end = (int64_t)(context->start_delay * context->speed_percent / -100.0);
 			}
-			new_replay.trim_front = 0;
+			new_replay->trim_front = 0;
 		} else {
 			if (context->speed_percent == 100.0f) {
-				new_replay.trim_front = context->start_delay * -1;
+				new_replay->trim_front = context->start_delay * -1;
 			} else {
-				new_replay.trim_front = (int64_t)(context->start_delay * context->speed_percent / -100.0);
+				new_replay->trim_front = (int64_t)(context->start_delay * context->speed_percent / -100.0);
 			}
-			new_replay.trim_end = 0;
+			new_replay->trim_end = 0;
+		}
+	} else if (context->start_delay < 0 && context->start_delay * -1 < (int64_t)new_replay->duration) {
+		new_replay->trim_front = context->start_delay * -1;
+	}
+	if (range && (range->duration || range->end)) {
+		const uint64_t end = range->end < new_replay->duration ? range->end : new_replay->duration;
+		if (new_replay->trim_end < (int64_t)end)
+			new_replay->trim_end = (int64_t)end;
+		if (range->duration && range->duration < new_replay->duration - end) {
+			const int64_t front = (int64_t)(new_replay->duration - end - range->duration);
+			if (new_replay->trim_front < front)
+				new_replay->trim_front = front;
 		}
-	} else if (context->start_delay < 0 && context->start_delay * -1 < (int64_t)new_replay.duration) {
-		new_replay.trim_front = context->start_delay * -1;
+	}
+
+	for (size_t i = 1; i < new_replay->angle_count; i++) {
+		new_replay->angles[i]->trim_front = new_replay->trim_front;
+		new_replay->angles[i]->trim_end = new_replay->trim_end;
 	}
 
 	pthread_mutex_lock(&context->replay_mutex);
-	circlebuf_push_back(&context->replays, &new_replay, sizeof new_replay);
+	struct replay_library_entry *entry =
+		replay_library_add(&context->replays, new_replay, context->source_name, os_gettime_ns());
+	entry->trim_front = new_replay->trim_front;
+	entry->trim_end = new_replay->trim_end;
+	replay_thumbnails_queue(context, entry);
 	pthread_mutex_unlock(&context->replay_mutex);
 
 	blog(LOG_INFO, "[replay_source: '%s'] replay added of %.2f seconds", obs_source_get_name(context->source),
-	     (double)new_replay.duration / (double)1000000000.0);
+	     (double)new_replay->duration / (double)1000000000.0);
 
-	if (context->replays.size == sizeof new_replay) {
+	if (replay_list_count(context) == 1) {
 		replay_update_position(context, true);
 	}
 	replay_purge_replays(context);
 	if (context->load_switch_scene_name) {
-		s = obs_get_source_by_name(context->load_switch_scene_name);
+		obs_source_t *s = replay_bind(context, &context->load_switch_scene_binding, context->load_switch_scene_name);
 		if (s) {
 			pthread_t thread;
 			pthread_create(&thread, NULL, update_scene_thread, s);
@@ -1196,38 +2521,28 @@ static void replay_retrieve(struct replay_source *context)
 }
 
 // Finds closest frame in the current replay given a desired timestamp.
-uint64_t find_closest_frame(void *data, uint64_t ts, bool le)
+// index of the video frame of the replay at ts, the one before ts when le is set and the one after it otherwise
+static uint64_t replay_closest_frame(const struct replay *replay, uint64_t ts, bool le)
 {
-	struct replay_source *c = data;
-	int64_t count = c->current_replay.video_frame_count;
-	struct obs_source_frame **frames = c->current_replay.video_frames;
-	if (ts < c->current_replay.first_frame_timestamp) {
+	const uint64_t count = replay->video_frame_count;
+	if (!count)
 		return 0;
-	} else if (ts > c->current_replay.last_frame_timestamp) {
+	const uint64_t *timestamps = replay->video_timestamps;
+	if (ts <= timestamps[0])
+		return 0;
+	if (ts >= timestamps[count - 1])
 		return count - 1;
-	}
 
-	int64_t i = 0, mid = 0, j = count;
-	while (i < j) {
-		mid = (i + j) / 2;
-		if (frames[mid]->timestamp == ts) {
-			return mid;
-		} else if (frames[mid]->timestamp > ts) {
-			if (mid > 0 && frames[mid - 1]->timestamp < ts) {
-				return le ? mid - 1 : mid;
-			}
-			j = mid;
-		} else if (frames[mid]->timestamp < ts) {
-			if (mid < count - 1 && frames[mid + 1]->timestamp > ts) {
-				return le ? mid : mid + 1;
-			}
-			i = mid + 1;
-		}
-	}
-	if (i == mid + 1) {
-		return le ? mid : mid + 1;
-	}
-	return le ? mid - 1 : mid;
+	const uint64_t i = replay_lower_bound(timestamps, count, ts);
+	if (timestamps[i] == ts)
+		return i;
+	return le ? i - 1 : i;
+}
+
+uint64_t find_closest_frame(void *data, uint64_t ts, bool le)
+{
+	struct replay_source *c = data;
+	return replay_closest_frame(c->current_replay, ts, le);
 }
 
 static void replay_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
@@ -1240,7 +2555,7 @@ static void replay_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bo
 		return;
 	blog(LOG_INFO, "[replay_source: '%s'] Load replay pressed", obs_source_get_name(context->source));
 	if (context->retrieve_delay > 0) {
-		context->retrieve_timestamp = obs_get_video_frame_time() + context->retrieve_delay;
+		replay_atomic_set_u64(&context->retrieve_timestamp, obs_get_video_frame_time() + context->retrieve_delay);
 	} else {
 		replay_retrieve(context);
 	}
@@ -1255,8 +2570,11 @@ static void replay_save_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotke
 	if (!pressed)
 		return;
 	blog(LOG_INFO, "[replay_source: '%s'] Save replay pressed", obs_source_get_name(context->source));
-	if (context->saving_status == SAVING_STATUS_NONE)
+	if (context->saving_status == SAVING_STATUS_NONE) {
+		bfree(context->save_path);
+		context->save_path = NULL;
 		context->saving_status = SAVING_STATUS_STARTING;
+	}
 }
 
 static void replay_disable_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
@@ -1347,7 +2665,7 @@ static void replay_next_scene_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t
 	if (current) {
 		const char *current_name = obs_source_get_name(current);
 		if (strcmp(current_name, c->next_scene_name) != 0) {
-			obs_source_t *s = obs_get_source_by_name(c->next_scene_name);
+			obs_source_t *s = replay_bind(c, &c->next_scene_binding, c->next_scene_name);
 			if (s) {
 				pthread_t thread;
 				pthread_create(&thread, NULL, update_scene_thread, s);
@@ -1356,7 +2674,7 @@ static void replay_next_scene_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t
 		}
 		obs_source_release(current);
 	} else {
-		obs_source_t *s = obs_get_source_by_name(c->next_scene_name);
+		obs_source_t *s = replay_bind(c, &c->next_scene_binding, c->next_scene_name);
 		if (s) {
 			pthread_t thread;
 			pthread_create(&thread, NULL, update_scene_thread, s);
@@ -1372,57 +2690,54 @@ static struct obs_source_frame *replay_restart_at_begin(struct replay_source *c,
 	c->start_timestamp = os_timestamp;
 	c->pause_timestamp = c->play ? 0 : os_timestamp;
 	c->audio_frame_position = 0;
-	const int64_t duration =
-		(int64_t)(((int64_t)c->current_replay.last_frame_timestamp - (int64_t)c->current_replay.first_frame_timestamp) *
-			  100.0 / c->speed_percent);
+	c->audio_sample_offset = 0;
+	struct replay *replay = c->current_replay;
+	const int64_t duration = replay_output_offset(c, replay, replay->last_frame_timestamp - replay->first_frame_timestamp);
 	if (c->backward) {
 		c->start_timestamp -= duration;
 	}
-	struct obs_source_frame *frame = c->current_replay.video_frames[c->video_frame_position];
-	if (c->current_replay.trim_front != 0) {
-		c->start_timestamp -= (uint64_t)(c->current_replay.trim_front * 100.0 / c->speed_percent);
-		if (c->current_replay.trim_front < 0) {
-			uint64_t t = frame->timestamp;
-			frame->timestamp = os_timestamp;
-			c->previous_frame_timestamp = frame->timestamp;
-			obs_source_output_video(c->source, frame);
-			frame->timestamp = t;
+	struct obs_source_frame *frame = c->current_replay->video_frames[c->video_frame_position];
+	if (c->current_replay->trim_front != 0) {
+		c->start_timestamp -= (uint64_t)replay_output_offset(c, c->current_replay, c->current_replay->trim_front);
+		if (c->current_replay->trim_front < 0) {
+			struct obs_source_frame out = *frame;
+			out.timestamp = os_timestamp;
+			c->previous_frame_timestamp = out.timestamp;
+			obs_source_output_video(c->source, &out);
 			return NULL;
 		}
-		uint64_t desired_ts = c->current_replay.first_frame_timestamp + c->current_replay.trim_front;
+		uint64_t desired_ts = c->current_replay->first_frame_timestamp + c->current_replay->trim_front;
 		c->video_frame_position = find_closest_frame(c, desired_ts, false);
-		frame = c->current_replay.video_frames[c->video_frame_position];
+		frame = c->current_replay->video_frames[c->video_frame_position];
 	}
 	return frame;
 }
 
 static struct obs_source_frame *replay_restart_at_end(struct replay_source *c, const uint64_t os_timestamp)
 {
-	c->video_frame_position = c->current_replay.video_frame_count - 1;
-	struct obs_source_frame *frame = c->current_replay.video_frames[c->video_frame_position];
-	const int64_t duration =
-		(int64_t)(((int64_t)c->current_replay.last_frame_timestamp - (int64_t)c->current_replay.first_frame_timestamp) *
-			  100.0 / c->speed_percent);
+	c->video_frame_position = c->current_replay->video_frame_count - 1;
+	struct obs_source_frame *frame = c->current_replay->video_frames[c->video_frame_position];
+	struct replay *replay = c->current_replay;
+	const int64_t duration = replay_output_offset(c, replay, replay->last_frame_timestamp - replay->first_frame_timestamp);
 	c->start_timestamp = os_timestamp;
 	if (!c->backward) {
 		c->start_timestamp -= duration;
 	}
 	c->pause_timestamp = c->play ? 0 : os_timestamp;
 	c->restart = false;
-	if (c->current_replay.trim_end != 0) {
-		c->start_timestamp -= (uint64_t)(c->current_replay.trim_end * 100.0 / c->speed_percent);
-
-		if (c->current_replay.trim_end < 0) {
-			uint64_t t = frame->timestamp;
-			frame->timestamp = os_timestamp;
-			c->previous_frame_timestamp = frame->timestamp;
-			obs_source_output_video(c->source, frame);
-			frame->timestamp = t;
+	if (c->current_replay->trim_end != 0) {
+		c->start_timestamp -= (uint64_t)replay_output_offset_back(c, c->current_replay, c->current_replay->trim_end);
+
+		if (c->current_replay->trim_end < 0) {
+			struct obs_source_frame out = *frame;
+			out.timestamp = os_timestamp;
+			c->previous_frame_timestamp = out.timestamp;
+			obs_source_output_video(c->source, &out);
 			return NULL;
 		}
-		uint64_t desired_ts = c->current_replay.last_frame_timestamp - c->current_replay.trim_end;
+		uint64_t desired_ts = c->current_replay->last_frame_timestamp - c->current_replay->trim_end;
 		c->video_frame_position = find_closest_frame(c, desired_ts, true);
-		frame = c->current_replay.video_frames[c->video_frame_position];
+		frame = c->current_replay->video_frames[c->video_frame_position];
 	}
 
 	return frame;
@@ -1430,10 +2745,9 @@ static struct obs_source_frame *replay_restart_at_end(struct replay_source *c, c
 
 void replay_source_end_action(struct replay_source *context);
 
-void replay_step_frames(void *data, bool pressed, bool forward, uint64_t num_frames)
+static void replay_step_frames_locked(struct replay_source *c, bool forward, uint64_t num_frames)
 {
-	struct replay_source *c = data;
-	if (!c->current_replay.video_frame_count || !pressed)
+	if (!c->current_replay->video_frame_count)
 		return;
 	uint64_t os_timestamp = obs_get_video_frame_time();
 	uint64_t next_pos = c->video_frame_position;
@@ -1444,9 +2758,9 @@ void replay_step_frames(void *data, bool pressed, bool forward, uint64_t num_fra
 		obs_source_signal(c->source, "media_pause");
 	}
 	if (forward) {
-		if (next_pos + num_frames >= c->current_replay.video_frame_count ||
-		    c->current_replay.video_frames[next_pos + num_frames]->timestamp >
-			    c->current_replay.last_frame_timestamp - c->current_replay.trim_end) {
+		if (next_pos + num_frames >= c->current_replay->video_frame_count ||
+		    c->current_replay->video_timestamps[next_pos + num_frames] >
+			    c->current_replay->last_frame_timestamp - c->current_replay->trim_end) {
 			bool bs = c->backward_start;
 			bool b = c->backward;
 			c->backward_start = false;
@@ -1464,8 +2778,8 @@ void replay_step_frames(void *data, bool pressed, bool forward, uint64_t num_fra
 
 	} else {
 		if (c->video_frame_position < num_frames ||
-		    c->current_replay.video_frames[c->video_frame_position - num_frames]->timestamp <
-			    c->current_replay.first_frame_timestamp + c->current_replay.trim_front) {
+		    c->current_replay->video_timestamps[c->video_frame_position - num_frames] <
+			    c->current_replay->first_frame_timestamp + c->current_replay->trim_front) {
 			bool bs = c->backward_start;
 			bool b = c->backward;
 			c->backward_start = true;
@@ -1481,9 +2795,11 @@ void replay_step_frames(void *data, bool pressed, bool forward, uint64_t num_fra
 			next_pos -= num_frames;
 		}
 	}
-	int64_t next_time = c->current_replay.video_frames[next_pos]->timestamp;
-	int64_t prev_time = c->current_replay.video_frames[c->video_frame_position]->timestamp;
-	int64_t time_diff = (int64_t)((next_time - prev_time) * 100 / c->speed_percent);
+	int64_t next_time = c->current_replay->video_timestamps[next_pos];
+	int64_t prev_time = c->current_replay->video_timestamps[c->video_frame_position];
+	const int64_t first = (int64_t)c->current_replay->first_frame_timestamp;
+	int64_t time_diff = replay_output_offset(c, c->current_replay, next_time - first) -
+			    replay_output_offset(c, c->current_replay, prev_time - first);
 	if (c->backward) {
 		time_diff *= -1;
 	}
@@ -1491,6 +2807,19 @@ void replay_step_frames(void *data, bool pressed, bool forward, uint64_t num_fra
 	c->video_frame_position = next_pos;
 }
 
+void replay_step_frames(void *data, bool pressed, bool forward, uint64_t num_frames)
+{
+	struct replay_source *c = data;
+	if (!pressed)
+		return;
+	// stepping past the end can switch replays
+	pthread_mutex_lock(&c->replay_mutex);
+	pthread_mutex_lock(&c->video_mutex);
+	replay_step_frames_locked(c, forward, num_frames);
+	pthread_mutex_unlock(&c->video_mutex);
+	pthread_mutex_unlock(&c->replay_mutex);
+}
+
 static void replay_next_n_frames_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
 {
 	UNUSED_PARAMETER(id);
@@ -1551,7 +2880,7 @@ static void replay_first_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotk
 	context->replay_position = 0;
 	replay_update_position(context, true);
 	blog(LOG_INFO, "[replay_source: '%s'] first hotkey switched to replay %i/%i", obs_source_get_name(context->source),
-	     context->replay_position + 1, (int)(context->replays.size / sizeof context->current_replay));
+	     context->replay_position + 1, replay_list_count(context));
 }
 
 static void replay_last_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
@@ -1560,7 +2889,7 @@ static void replay_last_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotke
 	UNUSED_PARAMETER(hotkey);
 
 	struct replay_source *context = data;
-	const int replay_count = (int)(context->replays.size / sizeof context->current_replay);
+	const int replay_count = replay_list_count(context);
 	if (!pressed || replay_count == 0)
 		return;
 
@@ -1578,27 +2907,18 @@ static void replay_remove_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hot
 	struct replay_source *context = data;
 	if (!pressed)
 		return;
-	const int replay_count = (int)(context->replays.size / sizeof context->current_replay);
+	const int replay_count = replay_list_count(context);
 
 	if (context->replay_position >= replay_count)
 		return;
 
 	pthread_mutex_lock(&context->replay_mutex);
-	struct replay removed_replay;
-	for (int i = 0; i < replay_count; i++) {
-		if (i == context->replay_position) {
-			circlebuf_pop_front(&context->replays, &removed_replay, sizeof removed_replay);
-		} else {
-			struct replay replay;
-			circlebuf_pop_front(&context->replays, &replay, sizeof replay);
-			circlebuf_push_back(&context->replays, &replay, sizeof replay);
-		}
-	}
+	struct replay *removed_replay = replay_list_remove(context, (size_t)context->replay_position);
 	blog(LOG_INFO, "[replay_source: '%s'] remove hotkey removed %i/%i", obs_source_get_name(context->source),
 	     context->replay_position + 1, replay_count);
 	pthread_mutex_unlock(&context->replay_mutex);
 	replay_update_position(context, true);
-	replay_free_replay(&removed_replay, context);
+	replay_release(removed_replay);
 }
 
 static void replay_clear_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
@@ -1607,29 +2927,29 @@ static void replay_clear_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotk
 	UNUSED_PARAMETER(hotkey);
 
 	struct replay_source *context = data;
-	if (!pressed || context->replays.size == 0)
+	if (!pressed || !replay_list_count(context))
 		return;
 
+	struct replay *empty = replay_create();
 	pthread_mutex_lock(&context->video_mutex);
 	pthread_mutex_lock(&context->audio_mutex);
-	context->current_replay.video_frame_count = 0;
-	context->current_replay.audio_frame_count = 0;
+	replay_publish(context, &context->current_replay, empty);
 	context->replay_position = 0;
 	context->end = true;
 	context->play = false;
 	obs_source_media_ended(context->source);
 	pthread_mutex_unlock(&context->audio_mutex);
 	pthread_mutex_unlock(&context->video_mutex);
+	replay_release(empty);
 	obs_source_output_video(context->source, NULL);
 	pthread_mutex_lock(&context->replay_mutex);
-	while (context->replays.size) {
-		struct replay replay;
-		circlebuf_pop_front(&context->replays, &replay, sizeof replay);
-		replay_free_replay(&replay, context);
-	}
+	while (replay_list_count(context))
+		replay_release(replay_list_remove(context, replay_library_count(&context->replays) - 1));
 	pthread_mutex_unlock(&context->replay_mutex);
 	replay_update_text(context);
+	pthread_mutex_lock(&context->video_mutex);
 	replay_update_progress_crop(context, 0);
+	pthread_mutex_unlock(&context->video_mutex);
 	blog(LOG_INFO, "[replay_source: '%s'] clear hotkey", obs_source_get_name(context->source));
 
 	obs_source_media_ended(context->source);
@@ -1644,16 +2964,21 @@ void update_speed(struct replay_source *context, float new_speed)
 	if (new_speed == context->speed_percent)
 		return;
 	//info("update speed from %.2f to %.2f", context->speed_percent, new_speed);
-	if (context->current_replay.video_frame_count) {
-		struct obs_source_frame *peek_frame = context->current_replay.video_frames[context->video_frame_position];
-		uint64_t duration = peek_frame->timestamp - context->current_replay.first_frame_timestamp;
+	struct replay *replay = replay_snapshot(context, &context->current_replay);
+	if (replay->video_frame_count && context->video_frame_position < replay->video_frame_count) {
+		const uint64_t frame_timestamp = replay->video_timestamps[context->video_frame_position];
+		// output time at 100% to the frame, following the speed ramp
+		const int64_t total = (int64_t)(replay->last_frame_timestamp - replay->first_frame_timestamp);
+		int64_t duration =
+			replay_time_map_output(&replay->time_map, (int64_t)(frame_timestamp - replay->first_frame_timestamp));
 		if (context->backward) {
-			duration = context->current_replay.last_frame_timestamp - peek_frame->timestamp;
+			duration = replay_time_map_output(&replay->time_map, total) - duration;
 		}
 		const uint64_t old_duration = (uint64_t)(duration * 100.0 / context->speed_percent);
 		const uint64_t new_duration = (uint64_t)(duration * 100.0 / new_speed);
 		context->start_timestamp += old_duration - new_duration;
 	}
+	replay_release(replay);
 	context->speed_percent = new_speed;
 	replay_update_text(context);
 }
@@ -1815,6 +3140,82 @@ static void replay_backward_or_faster_hotkey(void *data, obs_hotkey_id id, obs_h
 	replay_normal_or_faster_hotkey(data, id, hotkey, pressed);
 }
 
+// a copy of the replay with other trims sharing its frames and packets, the angles are copied with the same trims
+static struct replay *replay_retrim(const struct replay *replay, int64_t trim_front, int64_t trim_end)
+{
+	struct replay *copy = replay_create();
+	copy->oai = replay->oai;
+	copy->first_frame_timestamp = replay->first_frame_timestamp;
+	copy->last_frame_timestamp = replay->last_frame_timestamp;
+	copy->duration = replay->duration;
+	copy->trim_front = trim_front;
+	copy->trim_end = trim_end;
+	copy->video_frame_count = replay->video_frame_count;
+	if (replay->video_frame_count) {
+		copy->video_frames =
+			bmemdup(replay->video_frames, (size_t)replay->video_frame_count * sizeof(struct obs_source_frame *));
+		for (uint64_t i = 0; i < replay->video_frame_count; i++)
+			os_atomic_inc_long(&copy->video_frames[i]->refs);
+		copy->video_timestamps = bmemdup(replay->video_timestamps, (size_t)replay->video_frame_count * sizeof(uint64_t));
+	}
+	copy->audio_frame_count = replay->audio_frame_count;
+	if (replay->audio_frame_count) {
+		copy->audio_frames =
+			bmemdup(replay->audio_frames, (size_t)replay->audio_frame_count * sizeof(struct obs_audio_data));
+		for (uint64_t i = 0; i < replay->audio_frame_count; i++)
+			replay_audio_packet_addref(&copy->audio_frames[i]);
+		copy->audio_timestamps = bmemdup(replay->audio_timestamps, (size_t)replay->audio_frame_count * sizeof(uint64_t));
+	}
+	replay_time_map_slice(&copy->time_map, &replay->time_map, 0);
+	if (replay->angle_count) {
+		copy->angles = bzalloc(replay->angle_count * sizeof(struct replay *));
+		copy->angles[0] = copy;
+		for (size_t i = 1; i < replay->angle_count; i++)
+			copy->angles[i] = replay_retrim(replay->angles[i], trim_front, trim_end);
+		copy->angle_count = replay->angle_count;
+	}
+	return copy;
+}
+
+/* published replays are never modified, new trims of the playing replay are
+ * published as a copy of its entry with every angle, the copy shares the
+ * frames and packets so only the arrays are duplicated */
+static void replay_set_trims(struct replay_source *c, const struct replay *replay, int64_t trim_front, int64_t trim_end)
+{
+	pthread_mutex_lock(&c->replay_mutex);
+	pthread_mutex_lock(&c->video_mutex);
+	pthread_mutex_lock(&c->audio_mutex);
+	struct replay_library_entry *entry = replay_library_find(&c->replays, c->replay_id);
+	struct replay *base = entry ? entry->replay : NULL;
+	// the playing replay changed since the trims were computed
+	if (!base || c->current_replay != replay) {
+		pthread_mutex_unlock(&c->audio_mutex);
+		pthread_mutex_unlock(&c->video_mutex);
+		pthread_mutex_unlock(&c->replay_mutex);
+		return;
+	}
+	size_t angle = 0;
+	while (angle < base->angle_count && base->angles[angle] != replay)
+		angle++;
+	if (replay != base && angle >= base->angle_count) {
+		pthread_mutex_unlock(&c->audio_mutex);
+		pthread_mutex_unlock(&c->video_mutex);
+		pthread_mutex_unlock(&c->replay_mutex);
+		return;
+	}
+	struct replay *copy = replay_retrim(base, trim_front, trim_end);
+	replay_publish(c, &c->current_replay, replay == base ? copy : copy->angles[angle]);
+	pthread_mutex_unlock(&c->audio_mutex);
+	pthread_mutex_unlock(&c->video_mutex);
+
+	entry->replay = copy;
+	entry->trim_front = trim_front;
+	entry->trim_end = trim_end;
+	replay_thumbnails_queue(c, entry);
+	pthread_mutex_unlock(&c->replay_mutex);
+	replay_release(base);
+}
+
 static void replay_trim_front_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
 {
 	UNUSED_PARAMETER(id);
@@ -1827,19 +3228,19 @@ static void replay_trim_front_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t
 
 	const uint64_t timestamp = c->pause_timestamp == 0 ? obs_get_video_frame_time() : c->pause_timestamp;
 	int64_t duration = timestamp - c->start_timestamp;
-	if (c->speed_percent != 100.0f) {
-		duration = (int64_t)(duration * c->speed_percent / 100.0);
-	}
+	struct replay *replay = replay_snapshot(c, &c->current_replay);
+	if (!replay)
+		return;
 	if (c->backward) {
-		duration = (c->current_replay.last_frame_timestamp - c->current_replay.first_frame_timestamp) - duration;
+		duration = (int64_t)(replay->last_frame_timestamp - replay->first_frame_timestamp) -
+			   replay_source_offset_back(c, replay, duration);
+	} else {
+		duration = replay_source_offset(c, replay, duration);
 	}
-	if (duration + c->current_replay.first_frame_timestamp <
-	    c->current_replay.last_frame_timestamp - c->current_replay.trim_end) {
-		c->current_replay.trim_front = duration;
-		struct replay *r = circlebuf_data(&c->replays, c->replay_position * sizeof c->current_replay);
-		if (r)
-			r->trim_front = duration;
+	if (duration + replay->first_frame_timestamp < replay->last_frame_timestamp - replay->trim_end) {
+		replay_set_trims(c, replay, duration, replay->trim_end);
 	}
+	replay_release(replay);
 }
 
 static void replay_trim_end_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
@@ -1855,19 +3256,19 @@ static void replay_trim_end_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *h
 	const uint64_t timestamp = c->pause_timestamp == 0 ? obs_get_video_frame_time() : c->pause_timestamp;
 	if (timestamp > c->start_timestamp) {
 		int64_t duration = timestamp - c->start_timestamp;
-		if (c->speed_percent != 100.0f) {
-			duration = (int64_t)(duration * c->speed_percent / 100.0);
-		}
-		if (!c->backward) {
-			duration = (c->current_replay.last_frame_timestamp - c->current_replay.first_frame_timestamp) - duration;
+		struct replay *replay = replay_snapshot(c, &c->current_replay);
+		if (!replay)
+			return;
+		if (c->backward) {
+			duration = replay_source_offset_back(c, replay, duration);
+		} else {
+			duration = (int64_t)(replay->last_frame_timestamp - replay->first_frame_timestamp) -
+				   replay_source_offset(c, replay, duration);
 		}
-		if (c->current_replay.first_frame_timestamp + c->current_replay.trim_front <
-		    c->current_replay.last_frame_timestamp - duration) {
-			c->current_replay.trim_end = duration;
-			struct replay *r = circlebuf_data(&c->replays, c->replay_position * sizeof c->current_replay);
-			if (r)
-				r->trim_end = duration;
+		if (replay->first_frame_timestamp + replay->trim_front < replay->last_frame_timestamp - duration) {
+			replay_set_trims(c, replay, replay->trim_front, duration);
 		}
+		replay_release(replay);
 	}
 }
 
@@ -1881,22 +3282,320 @@ static void replay_trim_reset_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t
 	if (!pressed)
 		return;
 
-	c->current_replay.trim_end = 0;
-
+	struct replay *replay = replay_snapshot(c, &c->current_replay);
+	if (!replay)
+		return;
+	int64_t trim_front = 0;
 	if (c->start_delay > 0) {
 		if (c->speed_percent == 100.0f) {
-			c->current_replay.trim_front = c->start_delay * -1;
+			trim_front = c->start_delay * -1;
+		} else {
+			trim_front = (int64_t)(c->start_delay * c->speed_percent / -100.0);
+		}
+	}
+	replay_set_trims(c, replay, trim_front, 0);
+	replay_release(replay);
+}
+
+// a copy of the replay between start_ts and end_ts sharing the kept frames and packets, the positions of the first kept
+// frame and packet are returned in video_begin and audio_begin
+static struct replay *replay_trim_copy(const struct replay *replay, uint64_t start_ts, uint64_t end_ts, uint64_t *video_begin,
+				       uint64_t *audio_begin)
+{
+	struct replay *trimmed = replay_create();
+	trimmed->oai = replay->oai;
+
+	*video_begin = 0;
+	if (replay->video_frame_count) {
+		*video_begin = replay_closest_frame(replay, start_ts, false);
+		uint64_t video_end = replay_closest_frame(replay, end_ts, true) + 1;
+		if (video_end <= *video_begin)
+			video_end = *video_begin + 1;
+		trimmed->video_frame_count = video_end - *video_begin;
+		trimmed->video_frames = bzalloc((size_t)trimmed->video_frame_count * sizeof(struct obs_source_frame *));
+		for (uint64_t i = 0; i < trimmed->video_frame_count; i++) {
+			struct obs_source_frame *frame = replay->video_frames[*video_begin + i];
+			os_atomic_inc_long(&frame->refs);
+			trimmed->video_frames[i] = frame;
+		}
+		trimmed->first_frame_timestamp = trimmed->video_frames[0]->timestamp;
+		trimmed->last_frame_timestamp = trimmed->video_frames[trimmed->video_frame_count - 1]->timestamp;
+	} else {
+		trimmed->first_frame_timestamp = start_ts;
+		trimmed->last_frame_timestamp = end_ts;
+	}
+
+	*audio_begin = 0;
+	if (replay->audio_frame_count)
+		trimmed->audio_frames = bzalloc((size_t)replay->audio_frame_count * sizeof(struct obs_audio_data));
+	for (uint64_t i = 0; i < replay->audio_frame_count; i++) {
+		struct obs_audio_data *audio = &replay->audio_frames[i];
+		const uint64_t audio_duration = audio_frames_to_ns(replay->oai.samples_per_sec, audio->frames);
+		if (audio->timestamp + audio_duration < trimmed->first_frame_timestamp ||
+		    audio->timestamp > trimmed->last_frame_timestamp) {
+			if (trimmed->audio_frame_count == 0)
+				(*audio_begin)++;
+			continue;
+		}
+		trimmed->audio_frames[trimmed->audio_frame_count++] = *audio;
+		replay_audio_packet_addref(audio);
+	}
+	if (!trimmed->audio_frame_count) {
+		bfree(trimmed->audio_frames);
+		trimmed->audio_frames = NULL;
+	} else if (trimmed->audio_frame_count < replay->audio_frame_count) {
+		trimmed->audio_frames =
+			brealloc(trimmed->audio_frames, (size_t)trimmed->audio_frame_count * sizeof(struct obs_audio_data));
+	}
+	trimmed->duration = trimmed->last_frame_timestamp - trimmed->first_frame_timestamp;
+	replay_index_timestamps(trimmed);
+	replay_time_map_slice(&trimmed->time_map, &replay->time_map,
+			      (int64_t)(trimmed->first_frame_timestamp - replay->first_frame_timestamp));
+	return trimmed;
+}
+
+static void replay_commit_trim(struct replay_source *c)
+{
+	// the selected entry is looked up first, the replay mutex can not be taken under the video mutex
+	pthread_mutex_lock(&c->replay_mutex);
+	const struct replay_library_entry *selected = replay_library_at(&c->replays, (size_t)c->replay_position);
+	const uint64_t id = selected ? selected->id : 0;
+	struct replay *base = selected ? selected->replay : NULL;
+	replay_addref(base);
+	pthread_mutex_unlock(&c->replay_mutex);
+	if (!base)
+		return;
+
+	pthread_mutex_lock(&c->video_mutex);
+	pthread_mutex_lock(&c->audio_mutex);
+	struct replay *replay = c->current_replay;
+	// the playing replay is the entry itself or one of its angles, all angles are trimmed together
+	size_t current_angle = 0;
+	while (current_angle < base->angle_count && base->angles[current_angle] != replay)
+		current_angle++;
+	if (replay != base && current_angle >= base->angle_count) {
+		pthread_mutex_unlock(&c->audio_mutex);
+		pthread_mutex_unlock(&c->video_mutex);
+		replay_release(base);
+		return;
+	}
+	const int64_t trim_front = replay->trim_front > 0 ? replay->trim_front : 0;
+	const int64_t trim_end = replay->trim_end > 0 ? replay->trim_end : 0;
+	if ((!trim_front && !trim_end) || (!replay->video_frame_count && !replay->audio_frame_count)) {
+		pthread_mutex_unlock(&c->audio_mutex);
+		pthread_mutex_unlock(&c->video_mutex);
+		replay_release(base);
+		return;
+	}
+
+	// published replays are never modified, build trimmed copies sharing the kept frames
+	const uint64_t start_ts = replay->first_frame_timestamp + trim_front;
+	const uint64_t end_ts = replay->last_frame_timestamp - trim_end;
+	uint64_t video_begin = 0;
+	uint64_t audio_begin = 0;
+	struct replay *trimmed_base = NULL;
+	struct replay *trimmed = NULL;
+	const size_t angle_count = base->angle_count ? base->angle_count : 1;
+	for (size_t i = 0; i < angle_count; i++) {
+		const struct replay *from = i ? base->angles[i] : base;
+		uint64_t from_video_begin;
+		uint64_t from_audio_begin;
+		struct replay *copy = replay_trim_copy(from, start_ts, end_ts, &from_video_begin, &from_audio_begin);
+		// the kept negative trims are those of the playing angle
+		copy->trim_front = replay->trim_front > 0 ? 0 : replay->trim_front;
+		copy->trim_end = replay->trim_end > 0 ? 0 : replay->trim_end;
+		if (!i) {
+			trimmed_base = copy;
+			if (base->angle_count) {
+				trimmed_base->angles = bzalloc(base->angle_count * sizeof(struct replay *));
+				trimmed_base->angles[0] = trimmed_base;
+				trimmed_base->angle_count = base->angle_count;
+			}
 		} else {
-			c->current_replay.trim_front = (int64_t)(c->start_delay * c->speed_percent / -100.0);
+			trimmed_base->angles[i] = copy;
+		}
+		if (i == current_angle) {
+			trimmed = copy;
+			video_begin = from_video_begin;
+			audio_begin = from_audio_begin;
+		}
+	}
+
+	replay_addref(replay);
+	replay_publish(c, &c->current_replay, trimmed);
+
+	c->video_frame_position = c->video_frame_position > video_begin ? c->video_frame_position - video_begin : 0;
+	if (trimmed->video_frame_count && c->video_frame_position >= trimmed->video_frame_count)
+		c->video_frame_position = trimmed->video_frame_count - 1;
+	c->audio_frame_position = c->audio_frame_position > audio_begin ? c->audio_frame_position - audio_begin : 0;
+	if (c->audio_frame_position >= trimmed->audio_frame_count)
+		c->audio_frame_position = 0;
+	c->audio_sample_offset = 0;
+
+	const int64_t removed = c->backward ? (int64_t)(replay->last_frame_timestamp - trimmed->last_frame_timestamp)
+					    : (int64_t)(trimmed->first_frame_timestamp - replay->first_frame_timestamp);
+	c->start_timestamp += (uint64_t)(c->backward ? replay_output_offset_back(c, replay, removed)
+						     : replay_output_offset(c, replay, removed));
+
+	pthread_mutex_unlock(&c->audio_mutex);
+	pthread_mutex_unlock(&c->video_mutex);
+
+	blog(LOG_INFO,
+	     "[replay_source: '%s'] trim committed on %d angles, released %" PRIu64 " video frames and %" PRIu64
+	     " audio packets of the playing angle",
+	     obs_source_get_name(c->source), (int)angle_count, replay->video_frame_count - trimmed->video_frame_count,
+	     replay->audio_frame_count - trimmed->audio_frame_count);
+
+	// the id has a new generation when the slot was reused, the entry is only replaced when it still lists the replay
+	pthread_mutex_lock(&c->replay_mutex);
+	struct replay_library_entry *entry = replay_library_find(&c->replays, id);
+	if (entry && entry->replay == base) {
+		entry->replay = trimmed_base;
+		entry->trim_front = trimmed_base->trim_front;
+		entry->trim_end = trimmed_base->trim_end;
+		// a spilled copy still has the trimmed frames
+		if (entry->spill_path) {
+			os_unlink(entry->spill_path);
+			bfree(entry->spill_path);
+			entry->spill_path = NULL;
 		}
+		replay_thumbnails_queue(c, entry);
+		replay_release(base);
 	} else {
-		c->current_replay.trim_front = 0;
+		replay_release(trimmed_base);
+	}
+	pthread_mutex_unlock(&c->replay_mutex);
+	replay_release(replay);
+	replay_release(base);
+	replay_update_text(c);
+}
+
+static void replay_trim_commit_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
+{
+	UNUSED_PARAMETER(id);
+	UNUSED_PARAMETER(hotkey);
+
+	if (!pressed)
+		return;
+
+	replay_commit_trim(data);
+}
+
+// switches to another angle of the current replay at the same source time, the audio keeps playing
+static void replay_switch_angle(struct replay_source *c, int angle)
+{
+	pthread_mutex_lock(&c->replay_mutex);
+	if (c->replay_position >= replay_list_count(c)) {
+		pthread_mutex_unlock(&c->replay_mutex);
+		return;
+	}
+	struct replay *entry = replay_at(c, c->replay_position);
+	if (!entry) {
+		pthread_mutex_unlock(&c->replay_mutex);
+		return;
+	}
+	if (angle < 0 || (size_t)angle >= entry->angle_count)
+		angle = 0;
+	struct replay *target = replay_angle(entry, angle);
+	replay_addref(target);
+	pthread_mutex_unlock(&c->replay_mutex);
+
+	pthread_mutex_lock(&c->video_mutex);
+	pthread_mutex_lock(&c->audio_mutex);
+	struct replay *replay = c->current_replay;
+	// the angles of an entry are trimmed together, so the target already has the trims
+	if (target != replay && target->video_frame_count) {
+		uint64_t position = 0;
+		if (c->video_frame_position < replay->video_frame_count) {
+			const uint64_t ts = replay->video_timestamps[c->video_frame_position];
+			position = replay_lower_bound(target->video_timestamps, target->video_frame_count, ts);
+		}
+		if (position >= target->video_frame_count)
+			position = target->video_frame_count - 1;
+		replay_publish(c, &c->current_replay, target);
+		c->video_frame_position = position;
 	}
-	struct replay *r = circlebuf_data(&c->replays, c->replay_position * sizeof c->current_replay);
-	if (r) {
-		r->trim_end = c->current_replay.trim_end;
-		r->trim_front = c->current_replay.trim_front;
+	pthread_mutex_unlock(&c->audio_mutex);
+	pthread_mutex_unlock(&c->video_mutex);
+	replay_release(target);
+
+	c->angle = angle;
+	blog(LOG_INFO, "[replay_source: '%s'] switched to angle %d", obs_source_get_name(c->source), angle + 1);
+}
+
+static void replay_next_angle_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
+{
+	UNUSED_PARAMETER(id);
+	UNUSED_PARAMETER(hotkey);
+
+	struct replay_source *c = data;
+	if (!pressed)
+		return;
+
+	pthread_mutex_lock(&c->replay_mutex);
+	const size_t count = c->replay_position < replay_list_count(c) && replay_at(c, c->replay_position)
+				     ? replay_at(c, c->replay_position)->angle_count
+				     : 0;
+	pthread_mutex_unlock(&c->replay_mutex);
+	if (count > 1)
+		replay_switch_angle(c, (int)(((size_t)c->angle + 1) % count));
+}
+
+static const struct {
+	const char *name;
+	obs_hotkey_func func;
+} replay_actions[] = {
+	{"Load", replay_hotkey},
+	{"Next", replay_next_hotkey},
+	{"Previous", replay_previous_hotkey},
+	{"First", replay_first_hotkey},
+	{"Last", replay_last_hotkey},
+	{"Remove", replay_remove_hotkey},
+	{"Clear", replay_clear_hotkey},
+	{"Save", replay_save_hotkey},
+	{"Restart", replay_restart_hotkey},
+	{"Pause", replay_pause_hotkey},
+	{"Faster", replay_faster_hotkey},
+	{"Slower", replay_slower_hotkey},
+	{"Faster5Percent", replay_faster_by_5_hotkey},
+	{"Slower5Percent", replay_slower_by_5_hotkey},
+	{"NormalOrFaster", replay_normal_or_faster_hotkey},
+	{"NormalOrSlower", replay_normal_or_slower_hotkey},
+	{"NormalSpeed", replay_normal_speed_hotkey},
+	{"HalfSpeed", replay_half_speed_hotkey},
+	{"DoubleSpeed", replay_double_speed_hotkey},
+	{"TrimFront", replay_trim_front_hotkey},
+	{"TrimEnd", replay_trim_end_hotkey},
+	{"TrimReset", replay_trim_reset_hotkey},
+	{"TrimCommit", replay_trim_commit_hotkey},
+	{"Reverse", replay_reverse_hotkey},
+	{"Backward", replay_backward_hotkey},
+	{"Forward", replay_forward_hotkey},
+	{"ForwardOrFaster", replay_forward_or_faster_hotkey},
+	{"BackwardOrFaster", replay_backward_or_faster_hotkey},
+	{"DisableNextScene", replay_disable_next_scene_hotkey},
+	{"EnableNextScene", replay_enable_next_scene_hotkey},
+	{"Disable", replay_disable_hotkey},
+	{"Enable", replay_enable_hotkey},
+	{"SetNextSceneToCurrent", replay_next_scene_current_hotkey},
+	{"SwitchToNextScene", replay_next_scene_hotkey},
+	{"NextFrame", replay_next_frame_hotkey},
+	{"PrevFrame", replay_prev_frame_hotkey},
+	{"NextNFrames", replay_next_n_frames_hotkey},
+	{"PrevNFrames", replay_prev_n_frames_hotkey},
+	{"NextAngle", replay_next_angle_hotkey},
+};
+
+// runs the hotkey of an action by its name, as used by execute_action and the control api
+static bool replay_execute_action(struct replay_source *context, const char *name)
+{
+	for (size_t i = 0; i < sizeof(replay_actions) / sizeof(replay_actions[0]); i++) {
+		if (strcmp(replay_actions[i].name, name) == 0) {
+			replay_actions[i].func(context, 0, NULL, true);
+			return true;
+		}
 	}
+	return false;
 }
 
 void update_filter_settings(obs_source_t *filter, obs_data_t *settings)
@@ -1919,6 +3618,47 @@ void update_filter_settings(obs_source_t *filter, obs_data_t *settings)
 				    obs_data_get_double(settings, SETTING_AUDIO_THRESHOLD));
 		changed = true;
 	}
+	if (obs_data_get_int(filter_settings, SETTING_TRIGGER_MODE) != obs_data_get_int(settings, SETTING_TRIGGER_MODE)) {
+		obs_data_set_int(filter_settings, SETTING_TRIGGER_MODE, obs_data_get_int(settings, SETTING_TRIGGER_MODE));
+		changed = true;
+	}
+	if (obs_data_get_int(filter_settings, SETTING_TRIGGER_WINDOW) != obs_data_get_int(settings, SETTING_TRIGGER_WINDOW)) {
+		obs_data_set_int(filter_settings, SETTING_TRIGGER_WINDOW, obs_data_get_int(settings, SETTING_TRIGGER_WINDOW));
+		changed = true;
+	}
+	if (obs_data_get_double(filter_settings, SETTING_TRIGGER_HYSTERESIS) !=
+	    obs_data_get_double(settings, SETTING_TRIGGER_HYSTERESIS)) {
+		obs_data_set_double(filter_settings, SETTING_TRIGGER_HYSTERESIS,
+				    obs_data_get_double(settings, SETTING_TRIGGER_HYSTERESIS));
+		changed = true;
+	}
+	if (obs_data_get_int(filter_settings, SETTING_TRIGGER_MIN_DURATION) !=
+	    obs_data_get_int(settings, SETTING_TRIGGER_MIN_DURATION)) {
+		obs_data_set_int(filter_settings, SETTING_TRIGGER_MIN_DURATION,
+				 obs_data_get_int(settings, SETTING_TRIGGER_MIN_DURATION));
+		changed = true;
+	}
+	if (obs_data_get_int(filter_settings, SETTING_CAPTURE_POLICY) != obs_data_get_int(settings, SETTING_CAPTURE_POLICY)) {
+		obs_data_set_int(filter_settings, SETTING_CAPTURE_POLICY, obs_data_get_int(settings, SETTING_CAPTURE_POLICY));
+		changed = true;
+	}
+	if (strcmp(obs_data_get_string(filter_settings, SETTING_CAPTURE_SCENE),
+		   obs_data_get_string(settings, SETTING_CAPTURE_SCENE)) != 0) {
+		obs_data_set_string(filter_settings, SETTING_CAPTURE_SCENE, obs_data_get_string(settings, SETTING_CAPTURE_SCENE));
+		changed = true;
+	}
+	if (strcmp(obs_data_get_string(filter_settings, SETTING_CAPTURE_SCHEDULE),
+		   obs_data_get_string(settings, SETTING_CAPTURE_SCHEDULE)) != 0) {
+		obs_data_set_string(filter_settings, SETTING_CAPTURE_SCHEDULE,
+				    obs_data_get_string(settings, SETTING_CAPTURE_SCHEDULE));
+		changed = true;
+	}
+	if (obs_data_get_int(filter_settings, SETTING_CAPTURE_DISARM_DELAY) !=
+	    obs_data_get_int(settings, SETTING_CAPTURE_DISARM_DELAY)) {
+		obs_data_set_int(filter_settings, SETTING_CAPTURE_DISARM_DELAY,
+				 obs_data_get_int(settings, SETTING_CAPTURE_DISARM_DELAY));
+		changed = true;
+	}
 	obs_data_release(filter_settings);
 	if (changed)
 		obs_source_update(filter, NULL);
@@ -1927,90 +3667,31 @@ void update_filter_settings(obs_source_t *filter, obs_data_t *settings)
 static void replay_source_update(void *data, obs_data_t *settings)
 {
 	struct replay_source *context = data;
+	const uint64_t update_start = os_gettime_ns();
 	const char *execute_action = obs_data_get_string(settings, SETTING_EXECUTE_ACTION);
-	if (execute_action && strlen(execute_action)) {
-		if (strcmp(execute_action, "Load") == 0) {
-			replay_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Next") == 0) {
-			replay_next_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Previous") == 0) {
-			replay_previous_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "First") == 0) {
-			replay_first_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Last") == 0) {
-			replay_last_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Remove") == 0) {
-			replay_remove_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Clear") == 0) {
-			replay_clear_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Save") == 0) {
-			replay_save_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Restart") == 0) {
-			replay_restart_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Pause") == 0) {
-			replay_pause_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Faster") == 0) {
-			replay_faster_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Slower") == 0) {
-			replay_slower_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Faster5Percent") == 0) {
-			replay_faster_by_5_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Slower5Percent") == 0) {
-			replay_slower_by_5_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "NormalOrFaster") == 0) {
-			replay_normal_or_faster_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "NormalOrSlower") == 0) {
-			replay_normal_or_slower_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "NormalSpeed") == 0) {
-			replay_normal_speed_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "HalfSpeed") == 0) {
-			replay_half_speed_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "DoubleSpeed") == 0) {
-			replay_double_speed_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "TrimFront") == 0) {
-			replay_trim_front_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "TrimEnd") == 0) {
-			replay_trim_end_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "TrimReset") == 0) {
-			replay_trim_reset_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Reverse") == 0) {
-			replay_reverse_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Backward") == 0) {
-			replay_backward_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "Forward") == 0) {
-			replay_forward_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "ForwardOrFaster") == 0) {
-			replay_forward_or_faster_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "BackwardOrFaster") == 0) {
-			replay_backward_or_faster_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "DisableNextScene") == 0) {
-			context->next_scene_disabled = true;
-		} else if (strcmp(execute_action, "EnableNextScene") == 0) {
-			context->next_scene_disabled = false;
-		} else if (strcmp(execute_action, "Disable") == 0) {
+	const bool action = execute_action && *execute_action;
+	if (action) {
+		// disabling through settings is applied by the rest of this update
+		if (strcmp(execute_action, "Disable") == 0)
 			context->disabled = true;
-		} else if (strcmp(execute_action, "Enable") == 0) {
+		else if (strcmp(execute_action, "Enable") == 0)
 			context->disabled = false;
-		} else if (strcmp(execute_action, "SetNextSceneToCurrent") == 0) {
-			replay_next_scene_current_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "SwitchToNextScene") == 0) {
-			replay_next_scene_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "NextFrame") == 0) {
-			replay_next_frame_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "PrevFrame") == 0) {
-			replay_prev_frame_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "NextNFrames") == 0) {
-			replay_next_n_frames_hotkey(context, 0, NULL, true);
-		} else if (strcmp(execute_action, "PrevNFrames") == 0) {
-			replay_prev_n_frames_hotkey(context, 0, NULL, true);
-		}
+		else
+			replay_execute_action(context, execute_action);
 
 		obs_data_erase(settings, SETTING_EXECUTE_ACTION);
 	}
+	// the filter bindings and cursors change under the retrieve mutex
+	pthread_mutex_lock(&context->retrieve_mutex);
+	const char *shared_filter = obs_data_get_string(settings, SETTING_SHARED_FILTER);
+	const char *filter_name = shared_filter && *shared_filter ? shared_filter : obs_source_get_name(context->source);
+	const bool filter_changed = !context->filter_name || strcmp(context->filter_name, filter_name) != 0;
 	const char *source_name = obs_data_get_string(settings, SETTING_SOURCE);
 	if (context->source_name) {
-		if (strcmp(context->source_name, source_name) != 0 || context->disabled) {
-			obs_source_t *s = obs_get_source_by_name(context->source_name);
+		if (strcmp(context->source_name, source_name) != 0 || context->disabled || filter_changed) {
+			obs_source_t *s = NULL;
+			if (!replay_filter_shared(context))
+				s = replay_bind(context, &context->source_binding, context->source_name);
 			if (s) {
 				do {
 					context->source_filter = NULL;
@@ -2031,8 +3712,10 @@ static void replay_source_update(void *data, obs_data_t *settings)
 	}
 	const char *source_audio_name = obs_data_get_string(settings, SETTING_SOURCE_AUDIO);
 	if (context->source_audio_name) {
-		if (strcmp(context->source_audio_name, source_audio_name) != 0 || context->disabled) {
-			obs_source_t *s = obs_get_source_by_name(context->source_audio_name);
+		if (strcmp(context->source_audio_name, source_audio_name) != 0 || context->disabled || filter_changed) {
+			obs_source_t *s = NULL;
+			if (!replay_filter_shared(context))
+				s = replay_bind(context, &context->source_audio_binding, context->source_audio_name);
 			if (s) {
 				do {
 					context->source_audio_filter = NULL;
@@ -2051,6 +3734,15 @@ static void replay_source_update(void *data, obs_data_t *settings)
 	} else {
 		context->source_audio_name = bstrdup(source_audio_name);
 	}
+	if (filter_changed) {
+		for (size_t i = 0; context->filter_name && i < context->angle_name_count; i++)
+			replay_disconnect_angle(context, &context->angle_bindings[i], context->angle_names[i]);
+		bfree(context->filter_name);
+		context->filter_name = bstrdup(filter_name);
+		memset(&context->cursor, 0, sizeof(context->cursor));
+		memset(context->angle_cursors, 0, context->angle_name_count * sizeof(struct replay_filter_cursor));
+	}
+	const bool shared = replay_filter_shared(context);
 	const char *next_scene_name = obs_data_get_string(settings, SETTING_NEXT_SCENE);
 	if (context->next_scene_name) {
 		if (strcmp(context->next_scene_name, next_scene_name) != 0) {
@@ -2078,12 +3770,34 @@ static void replay_source_update(void *data, obs_data_t *settings)
 	context->frame_step_count = obs_data_get_int(settings, SETTING_FRAME_STEP_COUNT);
 
 	context->replay_max = (int)obs_data_get_int(settings, SETTING_REPLAYS);
+	const char *spill_directory = obs_data_get_string(settings, SETTING_SPILL_DIRECTORY);
+	if (!context->spill_directory || strcmp(context->spill_directory, spill_directory) != 0) {
+		pthread_mutex_lock(&context->spill_mutex);
+		bfree(context->spill_directory);
+		context->spill_directory = bstrdup(spill_directory);
+		pthread_mutex_unlock(&context->spill_mutex);
+	}
+	context->spill_max = (int)obs_data_get_int(settings, SETTING_SPILL_REPLAYS);
 	replay_purge_replays(context);
+	context->thumbnail_count = (int)obs_data_get_int(settings, SETTING_THUMBNAILS);
 
 	context->speed_percent = (float)obs_data_get_double(settings, SETTING_SPEED);
 	if (context->speed_percent < SETTING_SPEED_MIN || context->speed_percent > SETTING_SPEED_MAX)
 		context->speed_percent = 100.0f;
 
+	context->preserve_pitch = obs_data_get_bool(settings, SETTING_PRESERVE_PITCH);
+	replay_speed_ramp_parse(&context->speed_ramp, obs_data_get_string(settings, SETTING_SPEED_RAMP));
+	replay_interp_set_mode(&context->interp, (int)obs_data_get_int(settings, SETTING_INTERPOLATION));
+	context->frame_pacing = obs_data_get_bool(settings, SETTING_FRAME_PACING);
+	const bool live = obs_data_get_bool(settings, SETTING_LIVE);
+	if (live && !context->live)
+		context->play = true;
+	context->live = live;
+	context->live_delay = (uint64_t)obs_data_get_int(settings, SETTING_LIVE_DELAY) * MSEC_TO_NSEC;
+	context->live_catch_up = obs_data_get_double(settings, SETTING_LIVE_CATCH_UP);
+	if (context->live_catch_up < SETTING_LIVE_CATCH_UP_MIN || context->live_catch_up > SETTING_LIVE_CATCH_UP_MAX)
+		context->live_catch_up = SETTING_LIVE_CATCH_UP_MIN;
+
 	context->backward_start = obs_data_get_bool(settings, SETTING_BACKWARD);
 	if (context->backward != context->backward_start) {
 		replay_reverse_hotkey(context, 0, NULL, true);
@@ -2093,12 +3807,12 @@ static void replay_source_update(void *data, obs_data_t *settings)
 
 		obs_source_t *s = NULL;
 		if (strcmp(context->source_name, obs_source_get_name(context->source)) != 0) {
-			s = obs_get_source_by_name(context->source_name);
+			s = replay_bind(context, &context->source_binding, context->source_name);
 		}
 		if (s) {
 			context->source_filter = NULL;
 			obs_source_enum_filters(s, EnumFilter, data);
-			if (!context->source_filter) {
+			if (!context->source_filter && !shared) {
 				if ((obs_source_get_output_flags(s) & OBS_SOURCE_ASYNC) == OBS_SOURCE_ASYNC) {
 					context->source_filter = obs_source_create_private(
 						REPLAY_FILTER_ASYNC_ID, obs_source_get_name(context->source), settings);
@@ -2113,15 +3827,17 @@ static void replay_source_update(void *data, obs_data_t *settings)
 				if (context->source_filter) {
 					obs_source_filter_add(s, context->source_filter);
 				}
-			} else if (obs_obj_get_data(context->source_filter)) {
+			} else if (!shared && obs_obj_get_data(context->source_filter)) {
 				update_filter_settings(context->source_filter, settings);
 				blog(LOG_INFO, "[replay_source: '%s'] updated filter for '%s'",
 				     obs_source_get_name(context->source), context->source_name);
 			}
-			if (obs_obj_get_data(context->source_filter)) {
+			if (!shared && obs_obj_get_data(context->source_filter)) {
 				((struct replay_filter *)obs_obj_get_data(context->source_filter))->threshold_data = data;
 				((struct replay_filter *)obs_obj_get_data(context->source_filter))->trigger_threshold =
 					context->sound_trigger ? replay_trigger_threshold : NULL;
+			}
+			if (obs_obj_get_data(context->source_filter)) {
 				context->filter_loaded = true;
 				blog(LOG_INFO, "[replay_source: '%s'] connected to '%s'", obs_source_get_name(context->source),
 				     context->source_name);
@@ -2131,12 +3847,12 @@ static void replay_source_update(void *data, obs_data_t *settings)
 		}
 		s = NULL;
 		if (strcmp(context->source_audio_name, obs_source_get_name(context->source)) != 0) {
-			s = obs_get_source_by_name(context->source_audio_name);
+			s = replay_bind(context, &context->source_audio_binding, context->source_audio_name);
 		}
 		if (s) {
 			context->source_audio_filter = NULL;
 			obs_source_enum_filters(s, EnumAudioVideoFilter, data);
-			if (!context->source_audio_filter) {
+			if (!context->source_audio_filter && !shared) {
 				if ((obs_source_get_output_flags(s) & OBS_SOURCE_AUDIO) != 0) {
 					context->source_audio_filter = obs_source_create_private(
 						REPLAY_FILTER_AUDIO_ID, obs_source_get_name(context->source), settings);
@@ -2146,15 +3862,17 @@ static void replay_source_update(void *data, obs_data_t *settings)
 				if (context->source_audio_filter) {
 					obs_source_filter_add(s, context->source_audio_filter);
 				}
-			} else if (obs_obj_get_data(context->source_audio_filter)) {
+			} else if (!shared && obs_obj_get_data(context->source_audio_filter)) {
 				update_filter_settings(context->source_audio_filter, settings);
 				blog(LOG_INFO, "[replay_source: '%s'] updated audio filter for '%s'",
 				     obs_source_get_name(context->source), context->source_audio_name);
 			}
-			if (obs_obj_get_data(context->source_audio_filter)) {
+			if (!shared && obs_obj_get_data(context->source_audio_filter)) {
 				((struct replay_filter *)obs_obj_get_data(context->source_audio_filter))->threshold_data = data;
 				((struct replay_filter *)obs_obj_get_data(context->source_audio_filter))->trigger_threshold =
 					context->sound_trigger ? replay_trigger_threshold : NULL;
+			}
+			if (obs_obj_get_data(context->source_audio_filter)) {
 				context->filter_loaded = true;
 				blog(LOG_INFO, "[replay_source: '%s'] connected to '%s'", obs_source_get_name(context->source),
 				     context->source_audio_name);
@@ -2163,6 +3881,9 @@ static void replay_source_update(void *data, obs_data_t *settings)
 			obs_source_release(s);
 		}
 	}
+	replay_update_angles(context, settings);
+	// filters may have been added or removed, bindings that found nothing look again
+	os_atomic_inc_long(&replay_bindings_generation);
 	const char *file_format = obs_data_get_string(settings, SETTING_FILE_FORMAT);
 	if (context->file_format) {
 		if (strcmp(context->file_format, file_format) != 0) {
@@ -2177,16 +3898,20 @@ static void replay_source_update(void *data, obs_data_t *settings)
 		if (strcmp(context->progress_source_name, progress_source) != 0) {
 			bfree(context->progress_source_name);
 			context->progress_source_name = bstrdup(progress_source);
+			os_atomic_set_bool(&context->progress_dirty, true);
 		}
 	} else {
 		context->progress_source_name = bstrdup(progress_source);
+		os_atomic_set_bool(&context->progress_dirty, true);
 	}
 
+	pthread_mutex_lock(&context->text_mutex);
 	const char *text_source = obs_data_get_string(settings, SETTING_TEXT_SOURCE);
 	if (context->text_source_name) {
 		if (strcmp(context->text_source_name, text_source) != 0) {
 			bfree(context->text_source_name);
 			context->text_source_name = bstrdup(text_source);
+			dstr_free(&context->text_last);
 		}
 	} else {
 		context->text_source_name = bstrdup(text_source);
@@ -2197,10 +3922,13 @@ static void replay_source_update(void *data, obs_data_t *settings)
 		if (strcmp(context->text_format, text) != 0) {
 			bfree(context->text_format);
 			context->text_format = bstrdup(text);
+			replay_text_compile(&context->text_template, context->text_format);
 		}
 	} else {
 		context->text_format = bstrdup(text);
+		replay_text_compile(&context->text_template, context->text_format);
 	}
+	pthread_mutex_unlock(&context->text_mutex);
 
 	context->lossless = obs_data_get_bool(settings, SETTING_LOSSLESS);
 	const char *directory = obs_data_get_string(settings, SETTING_DIRECTORY);
@@ -2212,7 +3940,117 @@ static void replay_source_update(void *data, obs_data_t *settings)
 	} else {
 		context->directory = bstrdup(directory);
 	}
+	pthread_mutex_unlock(&context->retrieve_mutex);
 	replay_update_text(context);
+	if (action) {
+		context->action_updates++;
+		context->action_update_ns += os_gettime_ns() - update_start;
+	}
+}
+
+static void *replay_stretch_thread(void *data);
+static void replay_control_register(struct replay_source *context);
+
+static void replay_sources_changed(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(cd);
+	struct replay_source *context = data;
+	context->bindings_dirty = true;
+	os_atomic_set_bool(&context->progress_dirty, true);
+	os_atomic_inc_long(&replay_bindings_generation);
+}
+
+struct replay_rename_filters {
+	const char *name;
+	obs_source_t **filters;
+	size_t count;
+	size_t capacity;
+};
+
+static void EnumRenameFilter(obs_source_t *source, obs_source_t *filter, void *data)
+{
+	UNUSED_PARAMETER(source);
+	struct replay_rename_filters *rename = data;
+	const char *id = obs_source_get_unversioned_id(filter);
+	if ((strcmp(REPLAY_FILTER_AUDIO_ID, id) == 0 || strcmp(REPLAY_FILTER_ASYNC_ID, id) == 0 ||
+	     strcmp(REPLAY_FILTER_ID, id) == 0) &&
+	    strcmp(obs_source_get_name(filter), rename->name) == 0) {
+		if (rename->count == rename->capacity) {
+			rename->capacity = rename->capacity ? rename->capacity * 2 : 4;
+			rename->filters = brealloc(rename->filters, rename->capacity * sizeof(obs_source_t *));
+		}
+		rename->filters[rename->count++] = obs_source_get_ref(filter);
+	}
+}
+
+static void replay_rename_collect(struct replay_rename_filters *rename, const char *source_name)
+{
+	obs_source_t *s = source_name && *source_name ? obs_get_source_by_name(source_name) : NULL;
+	if (!s)
+		return;
+	obs_source_enum_filters(s, EnumRenameFilter, rename);
+	obs_source_release(s);
+}
+
+static bool replay_rename_setting(obs_data_t *settings, const char *key, const char *prev_name, const char *new_name)
+{
+	if (strcmp(obs_data_get_string(settings, key), prev_name) != 0)
+		return false;
+	obs_data_set_string(settings, key, new_name);
+	return true;
+}
+
+// keeps the filters and the stored source names pointing at renamed sources
+static void replay_source_renamed(void *data, calldata_t *cd)
+{
+	struct replay_source *context = data;
+	obs_source_t *renamed = calldata_ptr(cd, "source");
+	const char *prev_name = calldata_string(cd, "prev_name");
+	const char *new_name = calldata_string(cd, "new_name");
+	os_atomic_inc_long(&replay_bindings_generation);
+	if (!renamed || !prev_name || !new_name || obs_source_get_type(renamed) == OBS_SOURCE_TYPE_FILTER)
+		return;
+
+	if (renamed == context->source && context->filter_name && strcmp(context->filter_name, prev_name) == 0) {
+		// rename the replay filters so they keep their buffers instead of being replaced on the next update
+		struct replay_rename_filters rename = {prev_name, NULL, 0, 0};
+		replay_rename_collect(&rename, context->source_name);
+		replay_rename_collect(&rename, context->source_audio_name);
+		for (size_t i = 0; i < context->angle_name_count; i++)
+			replay_rename_collect(&rename, context->angle_names[i]);
+		for (size_t i = 0; i < rename.count; i++) {
+			obs_source_set_name(rename.filters[i], new_name);
+			obs_source_release(rename.filters[i]);
+		}
+		bfree(rename.filters);
+		bfree(context->filter_name);
+		context->filter_name = bstrdup(new_name);
+	}
+
+	obs_data_t *settings = obs_source_get_settings(context->source);
+	bool changed = false;
+	changed |= replay_rename_setting(settings, SETTING_SOURCE, prev_name, new_name);
+	changed |= replay_rename_setting(settings, SETTING_SOURCE_AUDIO, prev_name, new_name);
+	changed |= replay_rename_setting(settings, SETTING_TEXT_SOURCE, prev_name, new_name);
+	changed |= replay_rename_setting(settings, SETTING_PROGRESS_SOURCE, prev_name, new_name);
+	changed |= replay_rename_setting(settings, SETTING_NEXT_SCENE, prev_name, new_name);
+	changed |= replay_rename_setting(settings, SETTING_LOAD_SWITCH_SCENE, prev_name, new_name);
+	changed |= replay_rename_setting(settings, SETTING_CAPTURE_SCENE, prev_name, new_name);
+	changed |= replay_rename_setting(settings, SETTING_SHARED_FILTER, prev_name, new_name);
+	obs_data_array_t *angles = obs_data_get_array(settings, SETTING_ANGLE_SOURCES);
+	const size_t count = obs_data_array_count(angles);
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *item = obs_data_array_item(angles, i);
+		changed |= replay_rename_setting(item, "value", prev_name, new_name);
+		obs_data_release(item);
+	}
+	obs_data_array_release(angles);
+	if (changed) {
+		blog(LOG_INFO, "[replay_source: '%s'] followed the rename of '%s' to '%s'", obs_source_get_name(context->source),
+		     prev_name, new_name);
+		obs_source_update(context->source, settings);
+	}
+	obs_data_release(settings);
 }
 
 static void *replay_source_create(obs_data_t *settings, obs_source_t *source)
@@ -2224,8 +4062,31 @@ static void *replay_source_create(obs_data_t *settings, obs_source_t *source)
 	pthread_mutex_init(&context->video_mutex, NULL);
 	pthread_mutex_init(&context->audio_mutex, NULL);
 	pthread_mutex_init(&context->replay_mutex, NULL);
-
-	circlebuf_init(&context->replays);
+	pthread_mutex_init(&context->retrieve_mutex, NULL);
+	pthread_mutex_init(&context->text_mutex, NULL);
+	pthread_mutex_init(&context->bindings_mutex, NULL);
+	struct replay *empty = replay_create();
+	replay_publish(context, &context->current_replay, empty);
+	replay_release(empty);
+	if (os_sem_init(&context->trigger_sem, 0) == 0)
+		context->trigger_thread_active =
+			pthread_create(&context->trigger_thread, NULL, replay_trigger_thread, context) == 0;
+	pthread_mutex_init(&context->spill_mutex, NULL);
+	circlebuf_init(&context->spill_jobs);
+	if (os_sem_init(&context->spill_sem, 0) == 0)
+		context->spill_thread_active = pthread_create(&context->spill_thread, NULL, replay_spill_thread, context) == 0;
+	pthread_mutex_init(&context->thumbnail_mutex, NULL);
+	circlebuf_init(&context->thumbnail_jobs);
+	if (os_sem_init(&context->thumbnail_sem, 0) == 0)
+		context->thumbnail_thread_active =
+			pthread_create(&context->thumbnail_thread, NULL, replay_thumbnail_thread, context) == 0;
+	replay_interp_init(&context->interp);
+	pthread_mutex_init(&context->stretch_mutex, NULL);
+	if (os_event_init(&context->stretch_event, OS_EVENT_TYPE_AUTO) == 0)
+		context->stretch_thread_active =
+			pthread_create(&context->stretch_thread, NULL, replay_stretch_thread, context) == 0;
+
+	replay_library_init(&context->replays);
 
 	context->replay_hotkey =
 		obs_hotkey_register_source(source, "ReplaySource.Replay", obs_module_text("LoadReplay"), replay_hotkey, context);
@@ -2293,6 +4154,9 @@ static void *replay_source_create(obs_data_t *settings, obs_source_t *source)
 	context->trim_reset_hotkey = obs_hotkey_register_source(source, "ReplaySource.TrimReset", obs_module_text("TrimReset"),
 								replay_trim_reset_hotkey, context);
 
+	context->trim_commit_hotkey = obs_hotkey_register_source(source, "ReplaySource.TrimCommit", obs_module_text("TrimCommit"),
+								 replay_trim_commit_hotkey, context);
+
 	context->reverse_hotkey = obs_hotkey_register_source(source, "ReplaySource.Reverse", obs_module_text("Reverse"),
 							     replay_reverse_hotkey, context);
 
@@ -2343,21 +4207,215 @@ static void *replay_source_create(obs_data_t *settings, obs_source_t *source)
 	context->next_n_frames_hotkey = obs_hotkey_register_source(
 		source, "ReplaySource.NextNFrames", obs_module_text("NextNFrames"), replay_next_n_frames_hotkey, context);
 
+	context->next_angle_hotkey = obs_hotkey_register_source(source, "ReplaySource.NextAngle", obs_module_text("NextAngle"),
+								replay_next_angle_hotkey, context);
+	replay_control_register(context);
+
+	context->bindings_dirty = true;
+	signal_handler_connect(obs_get_signal_handler(), "source_create", replay_sources_changed, context);
+	signal_handler_connect(obs_get_signal_handler(), "source_remove", replay_sources_changed, context);
+	signal_handler_connect(obs_get_signal_handler(), "source_rename", replay_source_renamed, context);
+
 	return context;
 }
 
+static void replay_live_reset(struct replay_source *context)
+{
+	struct obs_source_frame *frame = context->live_frame;
+	if (frame && os_atomic_dec_long(&frame->refs) <= 0)
+		obs_source_frame_destroy(frame);
+	context->live_frame = NULL;
+	context->live_position = 0;
+	context->live_tick = 0;
+	context->live_audio = 0;
+}
+
+struct replay_live_audio {
+	struct replay_source *context;
+	uint64_t os_timestamp;
+	uint64_t position;
+	double speed;
+};
+
+static void replay_live_output_audio(void *param, const struct obs_audio_data *audio, const struct audio_convert_info *oai)
+{
+	struct replay_live_audio *live = param;
+	struct obs_source_audio out = {0};
+	for (size_t i = 0; i < MAX_AV_PLANES; i++)
+		out.data[i] = audio->data[i];
+	out.frames = audio->frames;
+	out.speakers = oai->speakers;
+	out.format = oai->format;
+	out.samples_per_sec = (uint32_t)(oai->samples_per_sec * live->speed / 100.0);
+	const int64_t offset = (int64_t)(audio->timestamp - live->position);
+	out.timestamp = live->os_timestamp + (uint64_t)(int64_t)((double)offset * 100.0 / live->speed);
+	obs_source_output_audio(live->context->source, &out);
+	live->context->live_audio = audio->timestamp + 1;
+}
+
+// plays the capture ring of the filters the live delay behind capture, catching up after a pause
+static void replay_live_tick(struct replay_source *context, uint64_t os_timestamp)
+{
+	obs_source_t *s = replay_bind(context, &context->source_binding, context->source_name);
+	context->source_filter = replay_bind_filter(context, &context->filter_binding, s, false);
+	obs_source_t *as = replay_bind(context, &context->source_audio_binding, context->source_audio_name);
+	context->source_audio_filter = replay_bind_filter(context, &context->audio_filter_binding, as, true);
+	struct replay_filter *vf = context->source_filter ? obs_obj_get_data(context->source_filter) : NULL;
+	struct replay_filter *af = context->source_audio_filter ? obs_obj_get_data(context->source_audio_filter) : vf;
+
+	uint64_t first = 0;
+	uint64_t last = 0;
+	if (af && af != vf) {
+		if (!replay_filter_live_range(af, &first, &last))
+			af = NULL;
+	}
+	if (vf && !replay_filter_live_range(vf, &first, &last))
+		vf = NULL;
+	if (!vf && !af) {
+		if (s)
+			obs_source_release(s);
+		if (as)
+			obs_source_release(as);
+		return;
+	}
+
+	const uint64_t target = os_timestamp > context->live_delay ? os_timestamp - context->live_delay : 0;
+	if (!context->live_position)
+		context->live_position = target;
+	double speed = 100.0;
+	if (context->play) {
+		uint64_t elapsed = 0;
+		if (context->live_tick && os_timestamp > context->live_tick)
+			elapsed = os_timestamp - context->live_tick;
+		if (context->live_position < target)
+			speed = context->live_catch_up;
+		context->live_position += (uint64_t)((double)elapsed * speed / 100.0);
+		if (context->live_position >= target) {
+			context->live_position = target;
+			speed = 100.0;
+		}
+	}
+	context->live_tick = os_timestamp;
+	// the ring evicted what was paused on
+	if (context->live_position < first)
+		context->live_position = first;
+
+	if (vf) {
+		struct obs_source_frame *frame = replay_filter_live_frame(vf, context->live_position);
+		if (frame && frame != context->live_frame) {
+			struct obs_source_frame out = *frame;
+			out.timestamp = os_timestamp;
+			obs_source_output_video(context->source, &out);
+		}
+		struct obs_source_frame *previous = context->live_frame;
+		if (previous && os_atomic_dec_long(&previous->refs) <= 0)
+			obs_source_frame_destroy(previous);
+		context->live_frame = frame;
+	}
+	if (af && context->play) {
+		if (context->live_audio < first || context->live_audio > context->live_position + SEC_TO_NSEC)
+			context->live_audio = context->live_position;
+		struct replay_live_audio live = {context, os_timestamp, context->live_position, speed};
+		const uint64_t lookahead = (uint64_t)((double)obs_get_frame_interval_ns() * speed / 100.0);
+		replay_filter_live_audio(af, context->live_audio, context->live_position + lookahead, replay_live_output_audio,
+					 &live);
+	}
+
+	if (s)
+		obs_source_release(s);
+	if (as)
+		obs_source_release(as);
+}
+
 static void replay_source_destroy(void *data)
 {
 	struct replay_source *context = data;
 
-	pthread_mutex_lock(&context->video_mutex);
-	pthread_mutex_lock(&context->audio_mutex);
-	context->current_replay.video_frame_count = 0;
-	context->current_replay.video_frames = NULL;
-	context->current_replay.audio_frame_count = 0;
-	context->current_replay.audio_frames = NULL;
-	pthread_mutex_unlock(&context->video_mutex);
-	pthread_mutex_unlock(&context->audio_mutex);
+	signal_handler_disconnect(obs_get_signal_handler(), "source_create", replay_sources_changed, context);
+	signal_handler_disconnect(obs_get_signal_handler(), "source_remove", replay_sources_changed, context);
+	signal_handler_disconnect(obs_get_signal_handler(), "source_rename", replay_source_renamed, context);
+	if (context->tick_count)
+		blog(LOG_INFO,
+		     "[replay_source: '%s'] tick took %.3f us on average, %.3f us at most, %" PRIu64 " of %" PRIu64
+		     " ticks were idle",
+		     obs_source_get_name(context->source), (double)context->tick_ns / (double)context->tick_count / 1000.0,
+		     (double)context->tick_max_ns / 1000.0, context->tick_idle_count, context->tick_count);
+	if (context->control_calls || context->action_updates)
+		blog(LOG_INFO,
+		     "[replay_source: '%s'] control calls took %.3f us on average over %" PRIu64
+		     " calls, execute_action updates %.3f us over %" PRIu64 " updates",
+		     obs_source_get_name(context->source),
+		     context->control_calls ? (double)context->control_ns / (double)context->control_calls / 1000.0 : 0.0,
+		     context->control_calls,
+		     context->action_updates ? (double)context->action_update_ns / (double)context->action_updates / 1000.0 : 0.0,
+		     context->action_updates);
+	if (context->spill_writes || context->spill_reads)
+		blog(LOG_INFO,
+		     "[replay_source: '%s'] spilled %" PRIu64 " replays, %.1f MB at %.1f MB/s, read back %" PRIu64
+		     " replays in %.1f ms on average",
+		     obs_source_get_name(context->source), context->spill_writes,
+		     (double)context->spill_write_bytes / 1000000.0,
+		     context->spill_write_ns ? (double)context->spill_write_bytes * 1000.0 / (double)context->spill_write_ns : 0.0,
+		     context->spill_reads,
+		     context->spill_reads ? (double)context->spill_read_ns / (double)context->spill_reads / 1000000.0 : 0.0);
+
+	if (context->spill_thread_active) {
+		context->spill_stop = true;
+		os_sem_post(context->spill_sem);
+		pthread_join(context->spill_thread, NULL);
+	}
+	os_sem_destroy(context->spill_sem);
+	while (context->spill_jobs.size) {
+		struct replay_spill_job job;
+		circlebuf_pop_front(&context->spill_jobs, &job, sizeof(job));
+		replay_release(job.replay);
+	}
+	circlebuf_free(&context->spill_jobs);
+	pthread_mutex_destroy(&context->spill_mutex);
+	bfree(context->spill_directory);
+
+	if (context->thumbnail_strips)
+		blog(LOG_INFO,
+		     "[replay_source: '%s'] made %" PRIu64 " thumbnail strips in %.2f ms on average, %.2f ms at most",
+		     obs_source_get_name(context->source), context->thumbnail_strips,
+		     (double)context->thumbnail_ns / (double)context->thumbnail_strips / 1000000.0,
+		     (double)context->thumbnail_max_ns / 1000000.0);
+	if (context->thumbnail_thread_active) {
+		context->thumbnail_stop = true;
+		os_sem_post(context->thumbnail_sem);
+		pthread_join(context->thumbnail_thread, NULL);
+	}
+	os_sem_destroy(context->thumbnail_sem);
+	while (context->thumbnail_jobs.size) {
+		struct replay_thumbnail_job job;
+		circlebuf_pop_front(&context->thumbnail_jobs, &job, sizeof(job));
+		replay_release(job.replay);
+	}
+	circlebuf_free(&context->thumbnail_jobs);
+	pthread_mutex_destroy(&context->thumbnail_mutex);
+	replay_thumbnail_scaler_free(&context->thumbnail_scaler);
+
+	if (context->trigger_thread_active) {
+		context->trigger_stop = true;
+		os_sem_post(context->trigger_sem);
+		pthread_join(context->trigger_thread, NULL);
+	}
+	os_sem_destroy(context->trigger_sem);
+	if (context->stretch_thread_active) {
+		context->stretch_stop = true;
+		os_event_signal(context->stretch_event);
+		pthread_join(context->stretch_thread, NULL);
+	}
+	os_event_destroy(context->stretch_event);
+	pthread_mutex_destroy(&context->stretch_mutex);
+	replay_stretch_log_stats(&context->stretch, obs_source_get_name(context->source));
+	replay_stretch_free(&context->stretch);
+	replay_release(context->stretch_replay);
+	replay_release(context->next_replay);
+	replay_live_reset(context);
+	replay_interp_log_stats(&context->interp, obs_source_get_name(context->source));
+	replay_pacing_log_stats(&context->pacing, obs_source_get_name(context->source));
+	replay_interp_free(&context->interp);
 
 	if (context->source_name)
 		bfree(context->source_name);
@@ -2365,6 +4423,15 @@ static void replay_source_destroy(void *data)
 	if (context->source_audio_name)
 		bfree(context->source_audio_name);
 
+	for (size_t i = 0; i < context->angle_name_count; i++) {
+		replay_unbind(&context->angle_bindings[i]);
+		bfree(context->angle_names[i]);
+	}
+	bfree(context->angle_names);
+	bfree(context->angle_cursors);
+	bfree(context->angle_bindings);
+	bfree(context->filter_name);
+
 	if (context->next_scene_name)
 		bfree(context->next_scene_name);
 
@@ -2376,7 +4443,9 @@ static void replay_source_destroy(void *data)
 
 	if (context->file_format)
 		bfree(context->file_format);
+	bfree(context->save_path);
 
+	replay_progress_unbind(context);
 	if (context->progress_source_name)
 		bfree(context->progress_source_name);
 
@@ -2386,6 +4455,28 @@ static void replay_source_destroy(void *data)
 	if (context->text_format)
 		bfree(context->text_format);
 
+	if (context->text_updates)
+		blog(LOG_INFO,
+		     "[replay_source: '%s'] text source updated %" PRIu64 " times for %" PRIu64
+		     " rendered texts, %.1f updates per second, %.3f ms per update",
+		     obs_source_get_name(context->source), context->text_updates, context->text_renders,
+		     (double)context->text_updates * 1000000000.0 / (double)(os_gettime_ns() - context->text_first_update + 1),
+		     (double)context->text_update_ns / (double)context->text_updates / 1000000.0);
+	replay_text_free(&context->text_template);
+	dstr_free(&context->text_buffer);
+	dstr_free(&context->text_last);
+	obs_data_release(context->text_settings);
+	pthread_mutex_destroy(&context->text_mutex);
+	replay_unbind(&context->source_binding);
+	replay_unbind(&context->source_audio_binding);
+	replay_unbind(&context->filter_binding);
+	replay_unbind(&context->audio_filter_binding);
+	replay_unbind(&context->text_binding);
+	replay_unbind(&context->next_scene_binding);
+	replay_unbind(&context->load_switch_scene_binding);
+	replay_unbind(&context->progress_binding);
+	pthread_mutex_destroy(&context->bindings_mutex);
+
 	if (context->h264Recording) {
 		obs_encoder_release(context->h264Recording);
 		context->h264Recording = NULL;
@@ -2411,12 +4502,12 @@ static void replay_source_destroy(void *data)
 		context->audio_t = NULL;
 	}
 	pthread_mutex_lock(&context->replay_mutex);
-	while (context->replays.size) {
-		circlebuf_pop_front(&context->replays, &context->current_replay, sizeof context->current_replay);
-		replay_free_replay(&context->current_replay, context);
-	}
-	circlebuf_free(&context->replays);
+	while (replay_list_count(context))
+		replay_release(replay_list_remove(context, replay_library_count(&context->replays) - 1));
+	replay_library_free(&context->replays);
 	pthread_mutex_unlock(&context->replay_mutex);
+	replay_publish(context, &context->current_replay, NULL);
+	replay_publish(context, &context->saving_replay, NULL);
 
 	if (context->scaler) {
 		video_scaler_destroy(context->scaler);
@@ -2426,34 +4517,525 @@ static void replay_source_destroy(void *data)
 	pthread_mutex_destroy(&context->video_mutex);
 	pthread_mutex_destroy(&context->audio_mutex);
 	pthread_mutex_destroy(&context->replay_mutex);
+	pthread_mutex_destroy(&context->retrieve_mutex);
+	bfree(context->reverse_buffer);
 	bfree(context);
 }
 
-static void replay_output_frame(struct replay_source *context, struct obs_source_frame *frame)
+#define REVERSE_AUDIO_FRAMES AUDIO_OUTPUT_FRAMES
+#define REVERSE_FADE_FRAMES 256
+
+static void reverse_samples(float *dst, const float *src, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 v = _mm_loadu_ps(src + count - i - 4);
+		_mm_storeu_ps(dst + i, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)));
+	}
+	for (; i < count; i++)
+		dst[i] = src[count - 1 - i];
+}
+
+// dst = dst * w + from * (1 - w), with w rising linearly over count samples
+static void crossfade_samples(float *dst, const float *from, size_t count)
+{
+	const float step = 1.0f / (float)count;
+	const __m128 step4 = _mm_set1_ps(4.0f * step);
+	const __m128 one = _mm_set1_ps(1.0f);
+	__m128 w = _mm_set_ps(3.0f * step, 2.0f * step, step, 0.0f);
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 a = _mm_loadu_ps(dst + i);
+		const __m128 b = from ? _mm_loadu_ps(from + i) : _mm_setzero_ps();
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_mul_ps(a, w), _mm_mul_ps(b, _mm_sub_ps(one, w))));
+		w = _mm_add_ps(w, step4);
+	}
+	for (; i < count; i++) {
+		const float wi = (float)i * step;
+		dst[i] = dst[i] * wi + (from ? from[i] : 0.0f) * (1.0f - wi);
+	}
+}
+
+// copies frames of audio starting at source time start into planar dst with the given plane stride, silence where none was captured
+static void replay_gather_audio(struct replay *replay, uint64_t start, size_t frames, size_t planes, float *dst, size_t stride)
+{
+	const uint32_t sample_rate = replay->oai.samples_per_sec;
+	uint64_t packet = replay_lower_bound(replay->audio_timestamps, replay->audio_frame_count, start + 1);
+	size_t offset = 0;
+	if (packet) {
+		packet--;
+		offset = (size_t)((start - replay->audio_timestamps[packet]) * sample_rate / 1000000000ULL);
+	}
+	for (size_t ch = 0; ch < planes; ch++)
+		memset(dst + ch * stride, 0, frames * sizeof(float));
+	size_t filled = 0;
+	while (filled < frames && packet < replay->audio_frame_count) {
+		const struct obs_audio_data *audio = &replay->audio_frames[packet];
+		if (offset < audio->frames) {
+			size_t count = audio->frames - offset;
+			if (count > frames - filled)
+				count = frames - filled;
+			for (size_t ch = 0; ch < planes; ch++) {
+				if (audio->data[ch])
+					memcpy(dst + ch * stride + filled, (const float *)audio->data[ch] + offset,
+					       count * sizeof(float));
+			}
+			filled += count;
+		}
+		offset = 0;
+		packet++;
+	}
+}
+
+// renders the audio before source time end reversed into out, returns the number of frames
+static size_t replay_render_reverse(struct replay *replay, uint64_t end, uint64_t front, size_t frames, size_t planes,
+				    float *scratch, float **out)
+{
+	const uint32_t sample_rate = replay->oai.samples_per_sec;
+	if (end <= front || !sample_rate)
+		return 0;
+	const size_t available = (size_t)((end - front) * sample_rate / 1000000000ULL);
+	if (frames > available)
+		frames = available;
+	if (!frames)
+		return 0;
+	replay_gather_audio(replay, end - audio_frames_to_ns(sample_rate, frames), frames, planes, scratch, frames);
+	for (size_t ch = 0; ch < planes; ch++)
+		reverse_samples(out[ch], scratch + ch * frames, frames);
+	return frames;
+}
+
+static void replay_output_reverse_audio(struct replay_source *context, int64_t video_duration)
+{
+	struct replay *replay = context->current_replay;
+	if (!replay->audio_frame_count || replay->oai.format != AUDIO_FORMAT_FLOAT_PLANAR)
+		return;
+	size_t planes = get_audio_channels(replay->oai.speakers);
+	if (planes > MAX_AV_PLANES)
+		planes = MAX_AV_PLANES;
+	if (!context->reverse_buffer)
+		context->reverse_buffer =
+			bmalloc((MAX_AV_PLANES * 2 * REVERSE_AUDIO_FRAMES + MAX_AV_PLANES * REVERSE_FADE_FRAMES) * sizeof(float));
+	float *scratch = context->reverse_buffer;
+	float *out[MAX_AV_PLANES];
+	float *tail[MAX_AV_PLANES];
+	for (size_t ch = 0; ch < MAX_AV_PLANES; ch++) {
+		out[ch] = scratch + (MAX_AV_PLANES + ch) * REVERSE_AUDIO_FRAMES;
+		tail[ch] = scratch + 2 * MAX_AV_PLANES * REVERSE_AUDIO_FRAMES + ch * REVERSE_FADE_FRAMES;
+	}
+
+	const uint64_t front = replay->first_frame_timestamp + (replay->trim_front > 0 ? replay->trim_front : 0);
+	if (video_duration < 0)
+		video_duration = 0;
+	const int64_t expected = replay_source_offset_back(context, replay, video_duration);
+	bool fade = false;
+	bool crossfade = false;
+	if (context->reverse_replay != replay || context->reverse_offset > expected + 100 * (int64_t)MSEC_TO_NSEC ||
+	    context->reverse_offset < expected - 100 * (int64_t)MSEC_TO_NSEC) {
+		// restarted, seeked or switched replay, fade from where the previous block would have continued
+		if (context->reverse_replay == replay && context->reverse_offset < (int64_t)replay->duration)
+			crossfade = replay_render_reverse(replay, replay->last_frame_timestamp - context->reverse_offset, front,
+							  REVERSE_FADE_FRAMES, planes, scratch, tail) == REVERSE_FADE_FRAMES;
+		context->reverse_replay = replay;
+		context->reverse_offset = expected;
+		fade = true;
+	}
+
+	const uint64_t block_duration = audio_frames_to_ns(replay->oai.samples_per_sec, REVERSE_AUDIO_FRAMES);
+	while (replay_output_offset_back(context, replay, context->reverse_offset) < video_duration + (int64_t)block_duration &&
+	       context->reverse_offset < (int64_t)replay->duration) {
+		const size_t frames = replay_render_reverse(replay, replay->last_frame_timestamp - context->reverse_offset, front,
+							    REVERSE_AUDIO_FRAMES, planes, scratch, out);
+		if (!frames)
+			break;
+		if (fade && frames >= REVERSE_FADE_FRAMES) {
+			for (size_t ch = 0; ch < planes; ch++)
+				crossfade_samples(out[ch], crossfade ? tail[ch] : NULL, REVERSE_FADE_FRAMES);
+		}
+		fade = false;
+
+		context->audio.frames = (uint32_t)frames;
+		context->audio.timestamp =
+			context->start_timestamp + (uint64_t)replay_output_offset_back(context, replay, context->reverse_offset);
+		context->audio.samples_per_sec =
+			(uint32_t)(replay->oai.samples_per_sec *
+				   replay_speed_at(context, replay, (int64_t)replay->duration - context->reverse_offset) / 100.0);
+		for (size_t i = 0; i < MAX_AV_PLANES; i++)
+			context->audio.data[i] = i < planes ? (const uint8_t *)out[i] : NULL;
+		context->audio.speakers = replay->oai.speakers;
+		context->audio.format = replay->oai.format;
+		obs_source_output_audio(context->source, &context->audio);
+
+		context->reverse_offset += (int64_t)audio_frames_to_ns(replay->oai.samples_per_sec, frames);
+	}
+}
+
+#define STRETCH_LOOKAHEAD (50 * MSEC_TO_NSEC)
+#define STRETCH_CHUNK_FRAMES 1024
+
+static void *replay_stretch_thread(void *data)
+{
+	struct replay_source *context = data;
+	os_set_thread_name("replay_source: stretch");
+	float *buffer = NULL;
+	size_t buffer_hop = 0;
+	while (os_event_wait(context->stretch_event) == 0 && !context->stretch_stop) {
+		pthread_mutex_lock(&context->stretch_mutex);
+		struct replay *replay = context->stretch_replay;
+		struct replay_stretch *stretch = &context->stretch;
+		if (buffer_hop < stretch->hop) {
+			buffer_hop = stretch->hop;
+			buffer = brealloc(buffer, MAX_AV_PLANES * (STRETCH_CHUNK_FRAMES + buffer_hop) * sizeof(float));
+		}
+		float *out[MAX_AV_PLANES];
+		float *in[MAX_AV_PLANES];
+		for (size_t ch = 0; ch < MAX_AV_PLANES; ch++) {
+			in[ch] = buffer + ch * STRETCH_CHUNK_FRAMES;
+			out[ch] = buffer + MAX_AV_PLANES * STRETCH_CHUNK_FRAMES + ch * buffer_hop;
+		}
+		while (replay && stretch->channels && context->stretch_output < context->stretch_until && !context->stretch_stop) {
+			size_t needed = replay_stretch_needed(stretch);
+			if (needed) {
+				const uint64_t start =
+					context->stretch_source +
+					audio_frames_to_ns(stretch->sample_rate, stretch->consumed + stretch->input_size);
+				if (start >= context->stretch_end)
+					break;
+				if (needed > STRETCH_CHUNK_FRAMES)
+					needed = STRETCH_CHUNK_FRAMES;
+				replay_gather_audio(replay, start, needed, stretch->channels, buffer, STRETCH_CHUNK_FRAMES);
+				replay_stretch_push(stretch, in, needed);
+				continue;
+			}
+			const size_t frames = replay_stretch_process(stretch, out);
+			if (!frames)
+				break;
+			struct obs_source_audio audio = {0};
+			for (size_t ch = 0; ch < stretch->channels; ch++)
+				audio.data[ch] = (const uint8_t *)out[ch];
+			audio.frames = (uint32_t)frames;
+			audio.speakers = replay->oai.speakers;
+			audio.format = replay->oai.format;
+			audio.samples_per_sec = stretch->sample_rate;
+			audio.timestamp = context->stretch_output;
+			obs_source_output_audio(context->source, &audio);
+			context->stretch_output += audio_frames_to_ns(stretch->sample_rate, frames);
+		}
+		pthread_mutex_unlock(&context->stretch_mutex);
+	}
+	bfree(buffer);
+	return NULL;
+}
+
+// lets the stretch thread render forward audio at the current speed, returns false when the normal audio path should run
+static bool replay_stretch_audio(struct replay_source *context, uint64_t os_timestamp, int64_t video_duration)
+{
+	struct replay *replay = context->current_replay;
+	if (!context->preserve_pitch || !context->play || (context->speed_percent == 100.0f && !replay->time_map.count) ||
+	    !context->stretch_thread_active || replay->oai.format != AUDIO_FORMAT_FLOAT_PLANAR || !replay->oai.samples_per_sec) {
+		if (context->stretch_replay) {
+			pthread_mutex_lock(&context->stretch_mutex);
+			replay_release(context->stretch_replay);
+			context->stretch_replay = NULL;
+			pthread_mutex_unlock(&context->stretch_mutex);
+		}
+		return false;
+	}
+	if (video_duration < 0)
+		video_duration = 0;
+	const int64_t source = replay_source_offset(context, replay, video_duration);
+	const double speed = replay_speed_at(context, replay, source) / 100.0;
+	const uint64_t expected = replay->first_frame_timestamp + (uint64_t)source;
+
+	pthread_mutex_lock(&context->stretch_mutex);
+	struct replay_stretch *stretch = &context->stretch;
+	bool reset = context->stretch_replay != replay || context->stretch_output < os_timestamp;
+	if (!reset) {
+		// source time the already rendered audio reaches at os_timestamp
+		const int64_t rendered = (int64_t)context->stretch_source +
+					 (int64_t)(replay_stretch_position(stretch) * 1000000000.0 / (double)stretch->sample_rate) -
+					 (int64_t)((double)(context->stretch_output - os_timestamp) * context->stretch_speed);
+		const int64_t drift = rendered - (int64_t)expected;
+		reset = drift > 100 * (int64_t)MSEC_TO_NSEC || drift < -100 * (int64_t)MSEC_TO_NSEC;
+	}
+	if (reset) {
+		size_t channels = get_audio_channels(replay->oai.speakers);
+		if (channels > MAX_AV_PLANES)
+			channels = MAX_AV_PLANES;
+		if (stretch->channels != channels || stretch->sample_rate != replay->oai.samples_per_sec) {
+			const uint64_t frames_out = stretch->frames_out;
+			const uint64_t process_ns = stretch->process_ns;
+			replay_stretch_free(stretch);
+			replay_stretch_init(stretch, channels, replay->oai.samples_per_sec);
+			stretch->frames_out = frames_out;
+			stretch->process_ns = process_ns;
+		}
+		if (context->stretch_replay != replay) {
+			replay_addref(replay);
+			replay_release(context->stretch_replay);
+			context->stretch_replay = replay;
+		}
+		replay_stretch_reset(stretch);
+		context->stretch_source = expected;
+		context->stretch_output = os_timestamp;
+	}
+	context->stretch_speed = speed;
+	replay_stretch_set_speed(stretch, speed);
+	context->stretch_end = replay->last_frame_timestamp - (replay->trim_end > 0 ? replay->trim_end : 0);
+	context->stretch_until = os_timestamp + STRETCH_LOOKAHEAD;
+	pthread_mutex_unlock(&context->stretch_mutex);
+	os_event_signal(context->stretch_event);
+
+	// keep the packet position in step so normal playback resumes at the right place
+	pthread_mutex_lock(&context->audio_mutex);
+	context->audio_frame_position = replay_lower_bound(replay->audio_timestamps, replay->audio_frame_count, expected);
+	if (context->audio_frame_position >= replay->audio_frame_count)
+		context->audio_frame_position = 0;
+	context->audio_sample_offset = 0;
+	pthread_mutex_unlock(&context->audio_mutex);
+	return true;
+}
+
+// starts the audio frame at the sample a seek resolved to
+static void replay_skip_audio_samples(struct replay_source *context, struct obs_audio_data *audio)
+{
+	uint32_t offset = context->audio_sample_offset;
+	if (!offset)
+		return;
+	context->audio_sample_offset = 0;
+	if (offset >= audio->frames)
+		offset = audio->frames - 1;
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		if (audio->data[i])
+			audio->data[i] += offset * sizeof(float);
+	}
+	audio->frames -= offset;
+	audio->timestamp += audio_frames_to_ns(context->current_replay->oai.samples_per_sec, offset);
+}
+
+// first frame after the current position that is not due yet when playing forward
+static uint64_t replay_forward_due(struct replay_source *context, int64_t video_duration)
+{
+	const struct replay *replay = context->current_replay;
+	uint64_t i = context->video_frame_position;
+	uint64_t j = replay->video_frame_count;
+	while (i < j) {
+		const uint64_t mid = i + (j - i) / 2;
+		const int64_t source_duration = replay_output_offset(
+			context, replay, (int64_t)(replay->video_timestamps[mid] - replay->first_frame_timestamp));
+		if (source_duration <= video_duration)
+			i = mid + 1;
+		else
+			j = mid;
+	}
+	return i;
+}
+
+// first frame up to the current position that is due when playing backward
+static uint64_t replay_backward_due(struct replay_source *context, int64_t video_duration)
+{
+	const struct replay *replay = context->current_replay;
+	uint64_t i = 0;
+	uint64_t j = context->video_frame_position + 1;
+	while (i < j) {
+		const uint64_t mid = i + (j - i) / 2;
+		const int64_t source_duration = replay_output_offset_back(
+			context, replay, (int64_t)(replay->last_frame_timestamp - replay->video_timestamps[mid]));
+		if (source_duration <= video_duration)
+			j = mid;
+		else
+			i = mid + 1;
+	}
+	return i;
+}
+
+// outputs a frame at its scaled source time or, when paced, at the render tick it was planned for
+static void replay_output_frame(struct replay_source *context, struct obs_source_frame *frame, uint64_t tick_timestamp)
 {
 	uint64_t t = frame->timestamp;
-	if (t < context->current_replay.first_frame_timestamp || t > context->current_replay.last_frame_timestamp)
+	if (t < context->current_replay->first_frame_timestamp || t > context->current_replay->last_frame_timestamp)
 		return;
+	struct obs_source_frame out = *frame;
 	if (context->backward) {
-		frame->timestamp = context->current_replay.last_frame_timestamp - frame->timestamp;
+		out.timestamp = context->current_replay->last_frame_timestamp - t;
 	} else {
-		frame->timestamp -= context->current_replay.first_frame_timestamp;
+		out.timestamp -= context->current_replay->first_frame_timestamp;
 	}
-	if (context->speed_percent != 100.0f) {
-		frame->timestamp = (uint64_t)(frame->timestamp * 100.0 / context->speed_percent);
+	struct replay *replay = context->current_replay;
+	if (context->speed_percent != 100.0f || replay->time_map.count) {
+		out.timestamp = (uint64_t)(context->backward ? replay_output_offset_back(context, replay, (int64_t)out.timestamp)
+							     : replay_output_offset(context, replay, (int64_t)out.timestamp));
 	}
-	frame->timestamp += context->start_timestamp;
-	if (context->previous_frame_timestamp <= frame->timestamp) {
-		context->previous_frame_timestamp = frame->timestamp;
-		obs_source_output_video(context->source, frame);
+	out.timestamp += context->start_timestamp;
+	if (tick_timestamp)
+		out.timestamp = tick_timestamp;
+	if (context->previous_frame_timestamp <= out.timestamp) {
+		context->previous_frame_timestamp = out.timestamp;
+		obs_source_output_video(context->source, &out);
 	}
-	frame->timestamp = t;
 	replay_update_progress_crop(context, t);
 }
 
+// when a frame would be shown playing forward if the frames were evenly spaced, to measure pacing against
+static uint64_t replay_frame_nominal_time(struct replay_source *context, uint64_t index)
+{
+	const struct replay *replay = context->current_replay;
+	if (replay->video_frame_count < 2)
+		return context->start_timestamp;
+	const uint64_t duration = replay->last_frame_timestamp - replay->first_frame_timestamp;
+	const int64_t source = (int64_t)((double)duration * (double)index / (double)(replay->video_frame_count - 1));
+	return context->start_timestamp + (uint64_t)replay_output_offset(context, replay, source);
+}
+
+// the frame between the last due frame and the next one when interpolating slow motion
+static struct obs_source_frame *replay_interpolated_frame(struct replay_source *context, int64_t video_duration,
+							  struct obs_source_frame *frame)
+{
+	struct replay *replay = context->current_replay;
+	const uint64_t next = context->video_frame_position;
+	if (!next || next >= replay->video_frame_count || video_duration < 0)
+		return frame;
+	const uint64_t previous = next - 1;
+	const uint64_t from = replay->video_timestamps[previous];
+	const uint64_t to = replay->video_timestamps[next];
+	// one step per rendered frame while a pair is shown, from the average frame duration so every pair uses the same steps
+	const uint64_t interval = obs_get_frame_interval_ns();
+	const double frame_duration = (double)(replay->last_frame_timestamp - replay->first_frame_timestamp) /
+				      (double)(replay->video_frame_count - 1);
+	const double speed = replay_speed_at(context, replay, (int64_t)(from - replay->first_frame_timestamp));
+	uint32_t steps = interval ? (uint32_t)(frame_duration * 100.0 / speed / (double)interval + 0.5)
+				  : (uint32_t)(100.0 / speed + 0.5);
+	if (steps > REPLAY_INTERP_MAX_STEPS)
+		steps = REPLAY_INTERP_MAX_STEPS;
+	if (steps < 2)
+		return frame;
+	replay_interp_prefetch(&context->interp, replay->video_frames, replay->video_frame_count, previous, steps);
+
+	const uint64_t source = replay->first_frame_timestamp + (uint64_t)replay_source_offset(context, replay, video_duration);
+	if (to <= from || source <= from)
+		return replay->video_frames[previous];
+	uint32_t step = (uint32_t)((source - from) * steps / (to - from));
+	if (step >= steps)
+		step = steps - 1;
+	if (!step)
+		return replay->video_frames[previous];
+	struct obs_source_frame *synthesized =
+		replay_interp_get(&context->interp, replay->video_frames[previous], replay->video_frames[next], steps, step);
+	// repeat the previous frame when the synthesized one is late
+	return synthesized ? synthesized : replay->video_frames[previous];
+}
+
+// source offset from the first frame where forward playback ends
+static inline int64_t replay_end_offset(const struct replay *replay)
+{
+	const int64_t end = (int64_t)(replay->last_frame_timestamp - replay->first_frame_timestamp);
+	return replay->trim_end > 0 ? end - replay->trim_end : end;
+}
+
+// position a play all end action continues with when playing forward, -1 when it does not continue
+static int replay_next_position(struct replay_source *context)
+{
+	const int replay_count = replay_list_count(context);
+	if (replay_count <= 1 || context->backward || context->backward_start)
+		return -1;
+	if (context->end_action != END_ACTION_HIDE_ALL && context->end_action != END_ACTION_PAUSE_ALL &&
+	    context->end_action != END_ACTION_LOOP_ALL && context->end_action != END_ACTION_REVERSE_ALL)
+		return -1;
+	if (context->replay_position + 1 < replay_count)
+		return context->replay_position + 1;
+	return context->end_action == END_ACTION_LOOP_ALL ? 0 : -1;
+}
+
+// takes a reference to the next replay and resolves its first frame and audio sample, called with the replay mutex held
+static void replay_prepare_next(struct replay_source *context)
+{
+	const int position = replay_next_position(context);
+	struct replay *replay = NULL;
+	if (position >= 0 && position < replay_list_count(context)) {
+		if (replay_at(context, position))
+			replay = replay_angle(replay_at(context, position), context->angle);
+		else
+			replay_page_in(context, position, false);
+	}
+	if (replay == context->next_replay && position == context->next_position)
+		return;
+	replay_addref(replay);
+
+	replay_release(context->next_replay);
+	context->next_replay = replay;
+	context->next_position = position;
+	context->next_video_position = 0;
+	context->next_audio_position = 0;
+	context->next_audio_sample_offset = 0;
+	if (!replay)
+		return;
+
+	const uint64_t front = replay->first_frame_timestamp + (replay->trim_front > 0 ? (uint64_t)replay->trim_front : 0);
+	if (replay->video_frame_count) {
+		const uint64_t i = replay_lower_bound(replay->video_timestamps, replay->video_frame_count, front);
+		context->next_video_position = i < replay->video_frame_count ? i : replay->video_frame_count - 1;
+	}
+	if (replay->audio_frame_count) {
+		uint64_t packet = replay_lower_bound(replay->audio_timestamps, replay->audio_frame_count, front + 1);
+		packet = packet ? packet - 1 : 0;
+		const struct obs_audio_data *audio = &replay->audio_frames[packet];
+		if (front > audio->timestamp) {
+			const size_t offset = convert_time_to_frames(replay->oai.samples_per_sec, front - audio->timestamp);
+			if (offset < audio->frames)
+				context->next_audio_sample_offset = (uint32_t)offset;
+		}
+		context->next_audio_position = packet;
+	}
+}
+
+// switches to the prepared replay at position so it starts where the current replay ends, called with the replay mutex held
+static bool replay_switch_next(struct replay_source *context, int position)
+{
+	struct replay *next = context->next_replay;
+	if (!next)
+		return false;
+	context->next_replay = NULL;
+	// the replay could have been spilled since it was prepared
+	const bool valid = position == context->next_position && position >= 0 &&
+			   position < replay_list_count(context) && replay_at(context, position) != NULL &&
+			   replay_angle(replay_at(context, position), context->angle) == next;
+	if (!valid || context->backward || context->backward_start) {
+		replay_release(next);
+		return false;
+	}
+
+	struct replay *replay = context->current_replay;
+	uint64_t end_timestamp =
+		context->start_timestamp + (uint64_t)replay_output_offset(context, replay, replay_end_offset(replay));
+	const uint64_t now = obs_get_video_frame_time();
+	if (end_timestamp > now || now - end_timestamp > NEXT_REPLAY_MAX_LATE)
+		end_timestamp = now;
+
+	pthread_mutex_lock(&context->audio_mutex);
+	context->replay_position = position;
+	context->replay_id = replay_library_at(&context->replays, (size_t)position)->id;
+	replay_publish(context, &context->current_replay, next);
+	replay_release(next);
+	context->video_frame_position = context->next_video_position;
+	context->audio_frame_position = context->next_audio_position;
+	context->audio_sample_offset = context->next_audio_sample_offset;
+	context->start_timestamp = end_timestamp;
+	if (next->trim_front != 0)
+		context->start_timestamp -= (uint64_t)replay_output_offset(context, next, next->trim_front);
+	context->pause_timestamp = 0;
+	pthread_mutex_unlock(&context->audio_mutex);
+
+	replay_update_text(context);
+	return true;
+}
+
+// called with the replay and video mutex held
 void replay_source_end_action(struct replay_source *context)
 {
-	const int replay_count = (int)(context->replays.size / sizeof context->current_replay);
+	// the next replay is still being read back from disk
+	if (context->page_in_id)
+		return;
+	const int replay_count = replay_list_count(context);
 	if (replay_count == 0) {
 		context->play = false;
 		context->end = true;
@@ -2486,7 +5068,7 @@ void replay_source_end_action(struct replay_source *context)
 			if (context->replay_position + 1 >= replay_count) {
 				context->replay_position = 0;
 				finish = true;
-			} else {
+			} else if (!replay_switch_next(context, context->replay_position + 1)) {
 				context->replay_position++;
 				replay_update_position(context, false);
 			}
@@ -2496,7 +5078,8 @@ void replay_source_end_action(struct replay_source *context)
 				replay_reverse_hotkey(context, 0, NULL, true);
 				finish = false;
 			} else if (context->end_action == END_ACTION_LOOP_ALL) {
-				replay_update_position(context, false);
+				if (context->backward || !replay_switch_next(context, context->replay_position))
+					replay_update_position(context, false);
 				finish = false;
 			} else {
 				context->play = false;
@@ -2510,7 +5093,7 @@ void replay_source_end_action(struct replay_source *context)
 		if (current) {
 			const char *current_name = obs_source_get_name(current);
 			if (strcmp(current_name, context->next_scene_name) != 0) {
-				obs_source_t *s = obs_get_source_by_name(context->next_scene_name);
+				obs_source_t *s = replay_bind(context, &context->next_scene_binding, context->next_scene_name);
 				if (s) {
 					obs_source_release(s);
 					pthread_t thread;
@@ -2519,7 +5102,7 @@ void replay_source_end_action(struct replay_source *context)
 			}
 			obs_source_release(current);
 		} else {
-			obs_source_t *s = obs_get_source_by_name(context->next_scene_name);
+			obs_source_t *s = replay_bind(context, &context->next_scene_binding, context->next_scene_name);
 			if (s) {
 				obs_source_release(s);
 				pthread_t thread;
@@ -2529,33 +5112,35 @@ void replay_source_end_action(struct replay_source *context)
 	}
 }
 
-static void replay_source_tick(void *data, float seconds)
+static void replay_source_tick_work(struct replay_source *context, uint64_t os_timestamp)
 {
-	UNUSED_PARAMETER(seconds);
-	struct replay_source *context = data;
-
-	const uint64_t os_timestamp = obs_get_video_frame_time();
-
-	if (context->retrieve_timestamp && context->retrieve_timestamp < os_timestamp) {
-		context->retrieve_timestamp = 0;
+	const uint64_t retrieve_timestamp = replay_atomic_load_u64(&context->retrieve_timestamp);
+	// a retrieve posted again in the meantime stays pending
+	if (retrieve_timestamp && retrieve_timestamp < os_timestamp &&
+	    replay_atomic_compare_swap_u64(&context->retrieve_timestamp, retrieve_timestamp, 0))
 		replay_retrieve(context);
-	}
+	if (os_atomic_load_bool(&context->spill_in_done) && os_atomic_exchange_bool(&context->spill_in_done, false))
+		replay_spill_in_done(context);
 	if (!context->filter_loaded) {
+		context->idle = true;
+		if (!context->bindings_dirty)
+			return;
+		context->bindings_dirty = false;
 		if (context->source_name) {
-			obs_source_t *s = obs_get_source_by_name(context->source_name);
+			obs_source_t *s = replay_bind(context, &context->source_binding, context->source_name);
 			if (s) {
 				obs_data_t *settings = obs_source_get_settings(context->source);
-				replay_source_update(data, settings);
+				replay_source_update(context, settings);
 				obs_data_release(settings);
 				obs_source_release(s);
 				return;
 			}
 		}
 		if (context->source_audio_name) {
-			obs_source_t *s = obs_get_source_by_name(context->source_audio_name);
+			obs_source_t *s = replay_bind(context, &context->source_audio_binding, context->source_audio_name);
 			if (s) {
 				obs_data_t *settings = obs_source_get_settings(context->source);
-				replay_source_update(data, settings);
+				replay_source_update(context, settings);
 				obs_data_release(settings);
 				obs_source_release(s);
 				return;
@@ -2576,29 +5161,35 @@ static void replay_source_tick(void *data, float seconds)
 			blog(LOG_ERROR, "[replay_source: '%s'] error output not active: %s", obs_source_get_name(context->source),
 			     error);
 			context->saving_status = SAVING_STATUS_NONE;
-			if (context->free_after_save) {
-				replay_free_replay(&context->saving_replay, context);
-			}
-		} else if (context->video_save_position >= context->saving_replay.video_frame_count) {
+			replay_publish(context, &context->saving_replay, NULL);
+		} else if (context->video_save_position >= context->saving_replay->video_frame_count) {
 			context->saving_status = SAVING_STATUS_STOPPING;
 			obs_output_stop(context->fileOutput);
 		} else {
-			pthread_mutex_lock(&context->video_mutex);
-			struct obs_source_frame *frame = context->saving_replay.video_frames[context->video_save_position];
+			struct obs_source_frame *frame = context->saving_replay->video_frames[context->video_save_position];
 			while (frame->timestamp <
-			       context->saving_replay.first_frame_timestamp + context->saving_replay.trim_front) {
+			       context->saving_replay->first_frame_timestamp + context->saving_replay->trim_front) {
 				context->video_save_position++;
-				if (context->video_save_position >= context->saving_replay.video_frame_count) {
+				if (context->video_save_position >= context->saving_replay->video_frame_count) {
 					context->saving_status = SAVING_STATUS_STOPPING;
 					break;
 				}
-				frame = context->saving_replay.video_frames[context->video_save_position];
+				frame = context->saving_replay->video_frames[context->video_save_position];
 			}
 			uint64_t timestamp = frame->timestamp;
-			if (context->start_save_timestamp > context->saving_replay.first_frame_timestamp) {
-				timestamp += context->start_save_timestamp - context->saving_replay.first_frame_timestamp;
+			const struct replay_time_map *map = &context->saving_replay->time_map;
+			if (map->count) {
+				// frames are saved at the output time they played at
+				const int64_t offset = (int64_t)(frame->timestamp - context->saving_replay->first_frame_timestamp);
+				timestamp = context->start_save_timestamp +
+					    (uint64_t)(replay_time_map_output(map, offset) -
+						       replay_time_map_output(map, context->saving_replay->trim_front));
+			} else {
+				if (context->start_save_timestamp > context->saving_replay->first_frame_timestamp) {
+					timestamp += context->start_save_timestamp - context->saving_replay->first_frame_timestamp;
+				}
+				timestamp -= context->saving_replay->trim_front;
 			}
-			timestamp -= context->saving_replay.trim_front;
 
 			struct video_frame output_frame;
 			if (video_output_lock_frame(context->video_output, &output_frame, 1, timestamp)) {
@@ -2608,43 +5199,40 @@ static void replay_source_tick(void *data, float seconds)
 			}
 			if (timestamp <= os_timestamp) {
 				context->video_save_position++;
-				if (context->video_save_position >= context->saving_replay.video_frame_count) {
+				if (context->video_save_position >= context->saving_replay->video_frame_count) {
 					context->saving_status = SAVING_STATUS_STOPPING;
 					obs_output_stop(context->fileOutput);
 				} else {
-					frame = context->saving_replay.video_frames[context->video_save_position];
+					frame = context->saving_replay->video_frames[context->video_save_position];
 					if (frame->timestamp >=
-					    context->saving_replay.last_frame_timestamp - context->saving_replay.trim_end) {
+					    context->saving_replay->last_frame_timestamp - context->saving_replay->trim_end) {
 						context->saving_status = SAVING_STATUS_STOPPING;
 						obs_output_stop(context->fileOutput);
 					}
 				}
 			}
-			pthread_mutex_unlock(&context->video_mutex);
 		}
 	} else if (context->saving_status == SAVING_STATUS_STOPPING) {
 		if (!context->fileOutput || !obs_output_active(context->fileOutput)) {
 			context->saving_status = SAVING_STATUS_NONE;
-			if (context->free_after_save) {
-				replay_free_replay(&context->saving_replay, context);
-			}
+			replay_publish(context, &context->saving_replay, NULL);
 		} else {
 
 			if (os_timestamp - context->start_save_timestamp >
-			    context->saving_replay.last_frame_timestamp - context->saving_replay.first_frame_timestamp) {
+			    (uint64_t)replay_time_map_output(&context->saving_replay->time_map,
+							     (int64_t)(context->saving_replay->last_frame_timestamp -
+								       context->saving_replay->first_frame_timestamp))) {
 				obs_output_stop(context->fileOutput);
-				pthread_mutex_lock(&context->video_mutex);
-				if (context->video_save_position >= context->saving_replay.video_frame_count) {
-					context->video_save_position = context->saving_replay.video_frame_count - 1;
+				if (context->video_save_position >= context->saving_replay->video_frame_count) {
+					context->video_save_position = context->saving_replay->video_frame_count - 1;
 				}
-				struct obs_source_frame *frame = context->saving_replay.video_frames[context->video_save_position];
+				struct obs_source_frame *frame = context->saving_replay->video_frames[context->video_save_position];
 				struct video_frame output_frame;
 				if (video_output_lock_frame(context->video_output, &output_frame, 1, os_timestamp)) {
 					video_scaler_scale(context->scaler, output_frame.data, output_frame.linesize,
 							   (const uint8_t *const *)frame->data, frame->linesize);
 					video_output_unlock_frame(context->video_output);
 				}
-				pthread_mutex_unlock(&context->video_mutex);
 			}
 		}
 	} else if (context->fileOutput) {
@@ -2661,8 +5249,18 @@ static void replay_source_tick(void *data, float seconds)
 		blog(LOG_INFO, "[replay_source: '%s'] stopped saving", obs_source_get_name(context->source));
 	}
 
+	if (context->live) {
+		pthread_mutex_lock(&context->retrieve_mutex);
+		replay_live_tick(context, os_timestamp);
+		pthread_mutex_unlock(&context->retrieve_mutex);
+		return;
+	}
+	if (context->live_frame)
+		replay_live_reset(context);
+
+	pthread_mutex_lock(&context->replay_mutex);
 	pthread_mutex_lock(&context->video_mutex);
-	if (!context->current_replay.video_frame_count && !context->current_replay.audio_frame_count) {
+	if (!context->current_replay->video_frame_count && !context->current_replay->audio_frame_count) {
 		if (context->play) {
 			context->play = false;
 			obs_source_signal(context->source, "media_pause");
@@ -2676,16 +5274,16 @@ static void replay_source_tick(void *data, float seconds)
 		if (context->end && (context->end_action == END_ACTION_HIDE || context->end_action == END_ACTION_HIDE_ALL)) {
 			obs_source_output_video(context->source, NULL);
 		}
+		context->idle = true;
 		if (context->stepped) {
 			context->stepped = false;
-			struct obs_source_frame *frame = context->current_replay.video_frames[context->video_frame_position];
-			uint64_t t = frame->timestamp;
-			frame->timestamp = os_timestamp;
-			obs_source_output_video(context->source, frame);
-			frame->timestamp = t;
+			struct obs_source_frame out = *context->current_replay->video_frames[context->video_frame_position];
+			out.timestamp = os_timestamp;
+			obs_source_output_video(context->source, &out);
 			replay_update_text(context);
 		}
 		pthread_mutex_unlock(&context->video_mutex);
+		pthread_mutex_unlock(&context->replay_mutex);
 		return;
 	}
 	if (context->end) {
@@ -2694,45 +5292,49 @@ static void replay_source_tick(void *data, float seconds)
 	}
 	replay_update_text(context);
 
-	if (context->current_replay.video_frame_count) {
-		if (context->video_frame_position >= context->current_replay.video_frame_count) {
-			context->video_frame_position = context->current_replay.video_frame_count - 1;
+	if (context->current_replay->video_frame_count) {
+		if (context->video_frame_position >= context->current_replay->video_frame_count) {
+			context->video_frame_position = context->current_replay->video_frame_count - 1;
 		}
-		struct obs_source_frame *frame = context->current_replay.video_frames[context->video_frame_position];
+		struct obs_source_frame *frame = context->current_replay->video_frames[context->video_frame_position];
 		if (context->backward) {
 			if (context->restart) {
 				frame = replay_restart_at_end(context, os_timestamp);
 				if (!frame) {
 					pthread_mutex_unlock(&context->video_mutex);
+					pthread_mutex_unlock(&context->replay_mutex);
 					return;
 				}
 			}
 
 			const int64_t video_duration = (int64_t)os_timestamp - (int64_t)context->start_timestamp;
-			//TODO audio backwards
-			int64_t source_duration = (int64_t)((context->current_replay.last_frame_timestamp - frame->timestamp) *
-							    100.0 / context->speed_percent);
-
+			pthread_mutex_lock(&context->audio_mutex);
+			replay_output_reverse_audio(context, video_duration);
+			pthread_mutex_unlock(&context->audio_mutex);
 			struct obs_source_frame *output_frame = frame;
-			while (context->play && video_duration >= source_duration) {
-				output_frame = frame;
-				if (frame->timestamp <=
-				    context->current_replay.first_frame_timestamp + context->current_replay.trim_front) {
+			const uint64_t due = replay_backward_due(context, video_duration);
+			if (due <= context->video_frame_position) {
+				struct replay *replay = context->current_replay;
+				// the last frame at or before the front trim stops playback
+				const uint64_t front = replay_lower_bound(replay->video_timestamps, replay->video_frame_count,
+									  replay->first_frame_timestamp + replay->trim_front + 1);
+				uint64_t stop = front ? front - 1 : 0;
+				if (stop > context->video_frame_position)
+					stop = context->video_frame_position;
+				if (front && stop >= due) {
+					context->video_frame_position = stop;
+					output_frame = replay->video_frames[stop];
 					replay_source_end_action(context);
-					break;
-				}
-				if (context->video_frame_position == 0) {
+				} else if (due == 0) {
+					context->video_frame_position = 0;
+					output_frame = replay->video_frames[0];
 					replay_source_end_action(context);
-					break;
+				} else {
+					context->video_frame_position = due - 1;
+					output_frame = replay->video_frames[due];
 				}
-				context->video_frame_position--;
-
-				frame = context->current_replay.video_frames[context->video_frame_position];
-
-				source_duration = (int64_t)((context->current_replay.last_frame_timestamp - frame->timestamp) *
-							    100.0 / context->speed_percent);
 			}
-			replay_output_frame(context, output_frame);
+			replay_output_frame(context, output_frame, 0);
 			if (context->video_frame_position == 0) {
 				replay_source_end_action(context);
 			}
@@ -2741,152 +5343,184 @@ static void replay_source_tick(void *data, float seconds)
 				frame = replay_restart_at_begin(context, os_timestamp);
 				if (!frame) {
 					pthread_mutex_unlock(&context->video_mutex);
+					pthread_mutex_unlock(&context->replay_mutex);
 					return;
 				}
 			}
 			if (context->start_timestamp > os_timestamp) {
 				pthread_mutex_unlock(&context->video_mutex);
+				pthread_mutex_unlock(&context->replay_mutex);
 				return;
 			}
 			const int64_t video_duration = (int64_t)os_timestamp - (int64_t)context->start_timestamp;
-
-			if (context->current_replay.audio_frame_count > 1) {
+			const int64_t remaining =
+				replay_output_offset(context, context->current_replay, replay_end_offset(context->current_replay)) -
+				video_duration;
+			if (context->play && remaining < (int64_t)NEXT_REPLAY_PREFETCH)
+				replay_prepare_next(context);
+
+			if (context->current_replay->audio_frame_count > 1 &&
+			    !replay_stretch_audio(context, os_timestamp, video_duration)) {
+				struct replay *replay = context->current_replay;
 				pthread_mutex_lock(&context->audio_mutex);
 				struct obs_audio_data peek_audio =
-					context->current_replay.audio_frames[context->audio_frame_position];
-				const int64_t frame_duration = (context->current_replay.last_frame_timestamp -
-								context->current_replay.first_frame_timestamp) /
-							       context->current_replay.video_frame_count;
+					context->current_replay->audio_frames[context->audio_frame_position];
+				replay_skip_audio_samples(context, &peek_audio);
+				const int64_t frame_duration = (context->current_replay->last_frame_timestamp -
+								context->current_replay->first_frame_timestamp) /
+							       context->current_replay->video_frame_count;
 				//const uint64_t duration = audio_frames_to_ns(info.samples_per_sec, peek_audio.frames);
-				int64_t audio_duration = (int64_t)(((int64_t)peek_audio.timestamp -
-								    (int64_t)context->current_replay.first_frame_timestamp) *
-								   100.0 / context->speed_percent);
+				int64_t audio_duration = replay_output_offset(
+					context, replay, (int64_t)(peek_audio.timestamp - replay->first_frame_timestamp));
 				while (context->play && video_duration + frame_duration > audio_duration) {
-					if (peek_audio.timestamp > context->current_replay.first_frame_timestamp - frame_duration &&
-					    peek_audio.timestamp < context->current_replay.last_frame_timestamp + frame_duration) {
+					if (peek_audio.timestamp > context->current_replay->first_frame_timestamp - frame_duration &&
+					    peek_audio.timestamp < context->current_replay->last_frame_timestamp + frame_duration) {
 						context->audio.frames = peek_audio.frames;
 
-						if (context->speed_percent != 100.0f) {
+						if (context->speed_percent != 100.0f || replay->time_map.count) {
+							const int64_t source =
+								(int64_t)(peek_audio.timestamp - replay->first_frame_timestamp);
 							context->audio.timestamp =
-								(uint64_t)(context->start_timestamp +
-									   (((int64_t)peek_audio.timestamp -
-									     (int64_t)context->current_replay.first_frame_timestamp) *
-									    100.0 / context->speed_percent));
+								context->start_timestamp +
+								(uint64_t)replay_output_offset(context, replay, source);
 							context->audio.samples_per_sec =
-								(uint32_t)(context->current_replay.oai.samples_per_sec *
-									   context->speed_percent / 100.0);
+								(uint32_t)(replay->oai.samples_per_sec *
+									   replay_speed_at(context, replay, source) / 100.0);
 						} else {
 							context->audio.timestamp = peek_audio.timestamp + context->start_timestamp -
-										   context->current_replay.first_frame_timestamp;
+										   context->current_replay->first_frame_timestamp;
 							context->audio.samples_per_sec =
-								context->current_replay.oai.samples_per_sec;
+								context->current_replay->oai.samples_per_sec;
 						}
 						for (size_t i = 0; i < MAX_AV_PLANES; i++) {
 							context->audio.data[i] = peek_audio.data[i];
 						}
 
-						context->audio.speakers = context->current_replay.oai.speakers;
-						context->audio.format = context->current_replay.oai.format;
+						context->audio.speakers = context->current_replay->oai.speakers;
+						context->audio.format = context->current_replay->oai.format;
 
 						obs_source_output_audio(context->source, &context->audio);
 					}
 					context->audio_frame_position++;
-					if (context->audio_frame_position >= context->current_replay.audio_frame_count) {
+					if (context->audio_frame_position >= context->current_replay->audio_frame_count) {
 						context->audio_frame_position = 0;
 						break;
 					}
-					peek_audio = context->current_replay.audio_frames[context->audio_frame_position];
-					audio_duration = (int64_t)(((int64_t)peek_audio.timestamp -
-								    (int64_t)context->current_replay.first_frame_timestamp) *
-								   100.0 / context->speed_percent);
+					peek_audio = context->current_replay->audio_frames[context->audio_frame_position];
+					audio_duration = replay_output_offset(
+						context, replay, (int64_t)(peek_audio.timestamp - replay->first_frame_timestamp));
 				}
 				pthread_mutex_unlock(&context->audio_mutex);
 			}
-			int64_t source_duration = (int64_t)((frame->timestamp - context->current_replay.first_frame_timestamp) *
-							    100.0 / context->speed_percent);
 			struct obs_source_frame *output_frame = frame;
-			while (context->play && video_duration >= source_duration) {
-				output_frame = frame;
-				if (frame->timestamp >=
-				    context->current_replay.last_frame_timestamp - context->current_replay.trim_end) {
+			bool interpolate = context->interp.mode != INTERP_MODE_NONE &&
+					   (context->speed_percent < 100.0f || context->current_replay->time_map.count);
+			struct replay *replay = context->current_replay;
+			const uint64_t unpaced = replay_forward_due(context, video_duration);
+			const uint64_t paced = replay_pacing_frame(&context->pacing, replay->video_timestamps,
+								   replay->video_frame_count, &replay->time_map,
+								   context->speed_percent, context->start_timestamp, os_timestamp);
+			if (unpaced)
+				replay_pacing_track(&context->pacing.unpaced, unpaced - 1, os_timestamp,
+						    replay_frame_nominal_time(context, unpaced - 1));
+			replay_pacing_track(&context->pacing.paced, paced, os_timestamp, replay_frame_nominal_time(context, paced));
+			const bool pace = context->frame_pacing && !interpolate;
+			const uint64_t due = pace ? paced + 1 : unpaced;
+			if (due > context->video_frame_position) {
+				// the first frame at or after the end trim stops playback
+				uint64_t stop = replay_lower_bound(replay->video_timestamps, replay->video_frame_count,
+								   replay->last_frame_timestamp - replay->trim_end);
+				if (stop < context->video_frame_position)
+					stop = context->video_frame_position;
+				if (stop < due) {
+					context->video_frame_position = stop;
+					output_frame = replay->video_frames[stop];
+					interpolate = false;
 					replay_source_end_action(context);
-					break;
-				}
-				context->video_frame_position++;
-				if (context->video_frame_position >= context->current_replay.video_frame_count) {
-					context->video_frame_position = context->current_replay.video_frame_count - 1;
+				} else if (due >= replay->video_frame_count) {
+					context->video_frame_position = replay->video_frame_count - 1;
+					output_frame = replay->video_frames[context->video_frame_position];
+					interpolate = false;
 					replay_source_end_action(context);
-					break;
+				} else {
+					context->video_frame_position = due;
+					output_frame = replay->video_frames[due - 1];
 				}
-				frame = context->current_replay.video_frames[context->video_frame_position];
-				source_duration = (int64_t)((frame->timestamp - context->current_replay.first_frame_timestamp) *
-							    100.0 / context->speed_percent);
+			} else if (pace) {
+				output_frame = replay->video_frames[paced];
 			}
-			replay_output_frame(context, output_frame);
-			if (context->video_frame_position >= context->current_replay.video_frame_count - 1) {
-				context->video_frame_position = context->current_replay.video_frame_count - 1;
+			if (interpolate)
+				output_frame = replay_interpolated_frame(context, video_duration, output_frame);
+			replay_output_frame(context, output_frame, pace ? os_timestamp : 0);
+			if (context->video_frame_position >= context->current_replay->video_frame_count - 1) {
+				context->video_frame_position = context->current_replay->video_frame_count - 1;
 				replay_source_end_action(context);
 			}
 		}
-	} else if (context->current_replay.audio_frame_count) {
+	} else if (context->current_replay->audio_frame_count) {
 		//no video, only audio
-		struct obs_audio_data peek_audio = context->current_replay.audio_frames[context->audio_frame_position];
+		struct obs_audio_data peek_audio = context->current_replay->audio_frames[context->audio_frame_position];
+		replay_skip_audio_samples(context, &peek_audio);
 
-		if (context->current_replay.first_frame_timestamp == peek_audio.timestamp) {
+		if (context->current_replay->first_frame_timestamp == peek_audio.timestamp) {
 			context->start_timestamp = os_timestamp;
 			context->pause_timestamp = 0;
 			context->restart = false;
 		} else if (context->restart) {
 			context->audio_frame_position = 0;
-			peek_audio = context->current_replay.audio_frames[context->audio_frame_position];
+			context->audio_sample_offset = 0;
+			peek_audio = context->current_replay->audio_frames[context->audio_frame_position];
 			context->restart = false;
 			context->start_timestamp = os_timestamp;
 			context->pause_timestamp = 0;
 		}
-		if (context->start_timestamp == os_timestamp && context->current_replay.trim_front != 0) {
-			if (context->speed_percent == 100.0f) {
-				context->start_timestamp -= context->current_replay.trim_front;
+		if (context->start_timestamp == os_timestamp && context->current_replay->trim_front != 0) {
+			if (context->speed_percent == 100.0f && !context->current_replay->time_map.count) {
+				context->start_timestamp -= context->current_replay->trim_front;
 			} else {
-				context->start_timestamp -=
-					(uint64_t)(context->current_replay.trim_front * 100.0 / context->speed_percent);
+				context->start_timestamp -= (uint64_t)replay_output_offset(context, context->current_replay,
+											   context->current_replay->trim_front);
 			}
-			if (context->current_replay.trim_front < 0) {
+			if (context->current_replay->trim_front < 0) {
 				pthread_mutex_unlock(&context->video_mutex);
+				pthread_mutex_unlock(&context->replay_mutex);
 				return;
 			}
 			while (peek_audio.timestamp <
-			       context->current_replay.first_frame_timestamp + context->current_replay.trim_front) {
+			       context->current_replay->first_frame_timestamp + context->current_replay->trim_front) {
 				context->audio_frame_position++;
-				if (context->audio_frame_position >= context->current_replay.audio_frame_count) {
+				if (context->audio_frame_position >= context->current_replay->audio_frame_count) {
 					context->audio_frame_position = 0;
 					break;
 				}
-				peek_audio = context->current_replay.audio_frames[context->audio_frame_position];
+				peek_audio = context->current_replay->audio_frames[context->audio_frame_position];
 			}
 		}
 		if (context->start_timestamp > os_timestamp) {
 			pthread_mutex_unlock(&context->video_mutex);
+			pthread_mutex_unlock(&context->replay_mutex);
 			return;
 		}
 
 		const int64_t video_duration = os_timestamp - context->start_timestamp;
 
-		int64_t audio_duration =
-			(int64_t)(((int64_t)peek_audio.timestamp - (int64_t)context->current_replay.first_frame_timestamp) * 100.0 /
-				  context->speed_percent);
+		int64_t audio_duration = replay_output_offset(context, context->current_replay,
+							      (int64_t)peek_audio.timestamp -
+								      (int64_t)context->current_replay->first_frame_timestamp);
 
-		while (context->play && context->current_replay.audio_frame_count > 1 && video_duration >= audio_duration) {
+		while (context->play && context->current_replay->audio_frame_count > 1 && video_duration >= audio_duration) {
 			if (peek_audio.timestamp >=
-			    context->current_replay.last_frame_timestamp - context->current_replay.trim_end) {
+			    context->current_replay->last_frame_timestamp - context->current_replay->trim_end) {
 				if (context->end_action != END_ACTION_LOOP) {
 					context->play = false;
 					context->end = true;
 					obs_source_media_ended(context->source);
-				} else if (context->current_replay.trim_end != 0) {
+				} else if (context->current_replay->trim_end != 0) {
 					context->restart = true;
 				}
 				if (context->next_scene_name && context->active) {
-					obs_source_t *s = obs_get_source_by_name(context->next_scene_name);
+					obs_source_t *s =
+						replay_bind(context, &context->next_scene_binding, context->next_scene_name);
 					if (s) {
 						obs_frontend_set_current_scene(s);
 						obs_source_release(s);
@@ -2896,38 +5530,69 @@ static void replay_source_tick(void *data, float seconds)
 
 			context->audio.frames = peek_audio.frames;
 
-			if (context->speed_percent != 100.0f) {
-				context->audio.timestamp =
-					(uint64_t)(context->start_timestamp +
-						   (peek_audio.timestamp - context->current_replay.first_frame_timestamp) * 100.0 /
-							   context->speed_percent);
+			if (context->speed_percent != 100.0f || context->current_replay->time_map.count) {
+				const int64_t source =
+					(int64_t)peek_audio.timestamp - (int64_t)context->current_replay->first_frame_timestamp;
+				context->audio.timestamp = context->start_timestamp +
+							   (uint64_t)replay_output_offset(context, context->current_replay, source);
 				context->audio.samples_per_sec =
-					(uint32_t)(context->current_replay.oai.samples_per_sec * context->speed_percent / 100.0);
+					(uint32_t)(context->current_replay->oai.samples_per_sec *
+						   replay_speed_at(context, context->current_replay, source) / 100.0);
 			} else {
 				context->audio.timestamp = peek_audio.timestamp + context->start_timestamp -
-							   context->current_replay.first_frame_timestamp;
-				context->audio.samples_per_sec = context->current_replay.oai.samples_per_sec;
+							   context->current_replay->first_frame_timestamp;
+				context->audio.samples_per_sec = context->current_replay->oai.samples_per_sec;
 			}
 			for (size_t i = 0; i < MAX_AV_PLANES; i++) {
 				context->audio.data[i] = peek_audio.data[i];
 			}
-			context->audio.speakers = context->current_replay.oai.speakers;
-			context->audio.format = context->current_replay.oai.format;
+			context->audio.speakers = context->current_replay->oai.speakers;
+			context->audio.format = context->current_replay->oai.format;
 
 			obs_source_output_audio(context->source, &context->audio);
 			context->audio_frame_position++;
-			if (context->audio_frame_position >= context->current_replay.audio_frame_count) {
+			if (context->audio_frame_position >= context->current_replay->audio_frame_count) {
 				context->audio_frame_position = 0;
 				break;
 			}
-			peek_audio = context->current_replay.audio_frames[context->audio_frame_position];
-			audio_duration =
-				(int64_t)(((int64_t)peek_audio.timestamp - (int64_t)context->current_replay.first_frame_timestamp) *
-					  100.0 / context->speed_percent);
+			peek_audio = context->current_replay->audio_frames[context->audio_frame_position];
+			audio_duration = replay_output_offset(context, context->current_replay,
+							      (int64_t)peek_audio.timestamp -
+								      (int64_t)context->current_replay->first_frame_timestamp);
 		}
 	}
 	pthread_mutex_unlock(&context->video_mutex);
+	pthread_mutex_unlock(&context->replay_mutex);
+}
+
+// anything that needs the tick, when none of it is pending the tick does no work at all
+static inline bool replay_source_tick_pending(const struct replay_source *context)
+{
+	return replay_atomic_load_u64(&context->retrieve_timestamp) || context->spill_in_done ||
+	       (!context->filter_loaded && context->bindings_dirty) ||
+	       context->saving_status != SAVING_STATUS_NONE || context->fileOutput || context->live || context->live_frame ||
+	       context->play || context->stepped || !context->idle;
+}
+
+static void replay_source_tick(void *data, float seconds)
+{
+	UNUSED_PARAMETER(seconds);
+	struct replay_source *context = data;
+
+	context->tick_count++;
+	if (!replay_source_tick_pending(context)) {
+		context->tick_idle_count++;
+		return;
+	}
+	const uint64_t start = os_gettime_ns();
+	context->idle = false;
+	replay_source_tick_work(context, obs_get_video_frame_time());
+	const uint64_t elapsed = os_gettime_ns() - start;
+	context->tick_ns += elapsed;
+	if (elapsed > context->tick_max_ns)
+		context->tick_max_ns = elapsed;
 }
+
 static bool EnumVideoSources(void *data, obs_source_t *source)
 {
 	obs_property_t *prop = data;
@@ -2942,6 +5607,13 @@ static bool EnumAudioSources(void *data, obs_source_t *source)
 		obs_property_list_add_string(prop, obs_source_get_name(source), obs_source_get_name(source));
 	return true;
 }
+static bool EnumReplaySources(void *data, obs_source_t *source)
+{
+	obs_property_t *prop = data;
+	if (strcmp(obs_source_get_unversioned_id(source), REPLAY_SOURCE_ID) == 0)
+		obs_property_list_add_string(prop, obs_source_get_name(source), obs_source_get_name(source));
+	return true;
+}
 static bool EnumScenes(void *data, obs_source_t *source)
 {
 	obs_property_t *prop = data;
@@ -3005,8 +5677,11 @@ static bool replay_sound_trigger_modified(obs_properties_t *props, obs_property_
 {
 	UNUSED_PARAMETER(property);
 	const bool sound_trigger = obs_data_get_bool(data, SETTING_SOUND_TRIGGER);
-	obs_property_t *prop = obs_properties_get(props, SETTING_AUDIO_THRESHOLD);
-	obs_property_set_visible(prop, sound_trigger);
+	obs_property_set_visible(obs_properties_get(props, SETTING_AUDIO_THRESHOLD), sound_trigger);
+	obs_property_set_visible(obs_properties_get(props, SETTING_TRIGGER_MODE), sound_trigger);
+	obs_property_set_visible(obs_properties_get(props, SETTING_TRIGGER_WINDOW), sound_trigger);
+	obs_property_set_visible(obs_properties_get(props, SETTING_TRIGGER_HYSTERESIS), sound_trigger);
+	obs_property_set_visible(obs_properties_get(props, SETTING_TRIGGER_MIN_DURATION), sound_trigger);
 	return true;
 }
 
@@ -3028,6 +5703,12 @@ static obs_properties_t *replay_source_properties(void *data)
 				       OBS_COMBO_FORMAT_STRING);
 	obs_property_list_add_string(prop, "", "");
 	obs_enum_sources(EnumAudioSources, prop);
+	obs_properties_add_editable_list(props, SETTING_ANGLE_SOURCES, obs_module_text("AngleSources"),
+					 OBS_EDITABLE_LIST_TYPE_STRINGS, NULL, NULL);
+	prop = obs_properties_add_list(props, SETTING_SHARED_FILTER, obs_module_text("SharedFilter"), OBS_COMBO_TYPE_EDITABLE,
+				       OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(prop, "", "");
+	obs_enum_sources(EnumReplaySources, prop);
 
 	prop = obs_properties_add_int(props, SETTING_DURATION, obs_module_text("Duration"), SETTING_DURATION_MIN,
 				      SETTING_DURATION_MAX, 1000);
@@ -3035,6 +5716,11 @@ static obs_properties_t *replay_source_properties(void *data)
 	prop = obs_properties_add_int(props, SETTING_RETRIEVE_DELAY, obs_module_text("LoadDelay"), 0, 100000, 1000);
 	obs_property_int_set_suffix(prop, "ms");
 	obs_properties_add_int(props, SETTING_REPLAYS, obs_module_text("MaxReplays"), 1, 10, 1);
+	obs_properties_add_int(props, SETTING_SPILL_REPLAYS, obs_module_text("SpillReplays"), 0, 1000, 1);
+	obs_properties_add_path(props, SETTING_SPILL_DIRECTORY, obs_module_text("SpillDirectory"), OBS_PATH_DIRECTORY, NULL,
+				NULL);
+	obs_properties_add_int(props, SETTING_THUMBNAILS, obs_module_text("Thumbnails"), 0, SETTING_THUMBNAILS_MAX, 1);
+	replay_arm_properties(props);
 
 	prop = obs_properties_add_list(props, SETTING_VISIBILITY_ACTION, obs_module_text("VisibilityAction"), OBS_COMBO_TYPE_LIST,
 				       OBS_COMBO_FORMAT_INT);
@@ -3065,6 +5751,20 @@ static obs_properties_t *replay_source_properties(void *data)
 
 	obs_properties_add_float_slider(props, SETTING_SPEED, obs_module_text("SpeedPercentage"), SETTING_SPEED_MIN,
 					SETTING_SPEED_MAX, 1.0);
+	obs_properties_add_bool(props, SETTING_PRESERVE_PITCH, obs_module_text("PreservePitch"));
+	obs_properties_add_text(props, SETTING_SPEED_RAMP, obs_module_text("SpeedRamp"), OBS_TEXT_DEFAULT);
+	prop = obs_properties_add_list(props, SETTING_INTERPOLATION, obs_module_text("Interpolation"), OBS_COMBO_TYPE_LIST,
+				       OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(prop, obs_module_text("InterpolationNone"), INTERP_MODE_NONE);
+	obs_property_list_add_int(prop, obs_module_text("InterpolationBlend"), INTERP_MODE_BLEND);
+	obs_property_list_add_int(prop, obs_module_text("InterpolationMotion"), INTERP_MODE_MOTION);
+	obs_properties_add_bool(props, SETTING_FRAME_PACING, obs_module_text("FramePacing"));
+	obs_properties_add_bool(props, SETTING_LIVE, obs_module_text("Live"));
+	prop = obs_properties_add_int(props, SETTING_LIVE_DELAY, obs_module_text("LiveDelay"), SETTING_LIVE_DELAY_MIN,
+				      SETTING_LIVE_DELAY_MAX, 100);
+	obs_property_int_set_suffix(prop, "ms");
+	obs_properties_add_float_slider(props, SETTING_LIVE_CATCH_UP, obs_module_text("LiveCatchUp"), SETTING_LIVE_CATCH_UP_MIN,
+					SETTING_LIVE_CATCH_UP_MAX, 1.0);
 	obs_properties_add_bool(props, SETTING_BACKWARD, obs_module_text("Backwards"));
 
 	obs_properties_add_path(props, SETTING_DIRECTORY, obs_module_text("Directory"), OBS_PATH_DIRECTORY, NULL, NULL);
@@ -3087,8 +5787,7 @@ static obs_properties_t *replay_source_properties(void *data)
 	prop = obs_properties_add_bool(props, SETTING_SOUND_TRIGGER, obs_module_text("SoundTriggerLoadReplay"));
 	obs_property_set_modified_callback(prop, replay_sound_trigger_modified);
 
-	obs_properties_add_float_slider(props, SETTING_AUDIO_THRESHOLD, obs_module_text("ThresholdDb"), SETTING_AUDIO_THRESHOLD_MIN,
-					SETTING_AUDIO_THRESHOLD_MAX, 0.1);
+	replay_trigger_properties(props);
 
 	prop = obs_properties_add_list(props, SETTING_LOAD_SWITCH_SCENE, obs_module_text("LoadReplaySwitchScene"),
 				       OBS_COMBO_TYPE_EDITABLE, OBS_COMBO_FORMAT_STRING);
@@ -3103,13 +5802,16 @@ static obs_properties_t *replay_source_properties(void *data)
 int64_t replay_get_duration(void *data)
 {
 	struct replay_source *c = data;
-	return (int64_t)((c->current_replay.duration / c->speed_percent * 100.0) / 1000000UL);
+	struct replay *replay = replay_snapshot(c, &c->current_replay);
+	const int64_t duration = replay_output_offset(c, replay, (int64_t)replay->duration) / 1000000;
+	replay_release(replay);
+	return duration;
 }
 
 int64_t replay_get_time(void *data)
 {
 	struct replay_source *c = data;
-	if (c->replays.size && c->start_timestamp) {
+	if (replay_list_count(c) && c->start_timestamp) {
 		uint64_t time = 0;
 		if (c->pause_timestamp > c->start_timestamp) {
 			time = c->pause_timestamp - c->start_timestamp;
@@ -3121,15 +5823,86 @@ int64_t replay_get_time(void *data)
 	return 0;
 }
 
-void replay_set_time(void *data, int64_t seconds)
+// moves playback to a source offset from where playback starts, called with the video and audio mutex held
+static void replay_seek_locked(struct replay_source *c, int64_t offset)
+{
+	struct replay *replay = c->current_replay;
+	const uint64_t now = c->pause_timestamp > c->start_timestamp ? c->pause_timestamp : obs_get_video_frame_time();
+
+	// clamp to the trimmed part of the replay
+	const int64_t duration = (int64_t)replay->duration;
+	const int64_t trim_start = c->backward ? replay->trim_end : replay->trim_front;
+	const int64_t trim_stop = c->backward ? replay->trim_front : replay->trim_end;
+	if (offset < (trim_start > 0 ? trim_start : 0))
+		offset = trim_start > 0 ? trim_start : 0;
+	if (offset > duration - (trim_stop > 0 ? trim_stop : 0))
+		offset = duration - (trim_stop > 0 ? trim_stop : 0);
+	if (offset < 0)
+		offset = 0;
+	const int64_t video_duration =
+		c->backward ? replay_output_offset_back(c, replay, offset) : replay_output_offset(c, replay, offset);
+	c->start_timestamp = now - video_duration;
+
+	if (replay->video_frame_count) {
+		if (c->backward) {
+			c->video_frame_position = replay->video_frame_count - 1;
+			const uint64_t due = replay_backward_due(c, video_duration);
+			c->video_frame_position = due < replay->video_frame_count ? due : replay->video_frame_count - 1;
+		} else {
+			c->video_frame_position = 0;
+			const uint64_t due = replay_forward_due(c, video_duration);
+			c->video_frame_position = due ? due - 1 : 0;
+		}
+	}
+
+	c->audio_frame_position = 0;
+	c->audio_sample_offset = 0;
+	if (replay->audio_frame_count && !c->backward) {
+		const uint64_t target = replay->first_frame_timestamp + (uint64_t)offset;
+		uint64_t position = replay_lower_bound(replay->audio_timestamps, replay->audio_frame_count, target + 1);
+		if (position)
+			position--;
+		c->audio_frame_position = position;
+		if (replay->audio_timestamps[position] < target)
+			c->audio_sample_offset = (uint32_t)(((target - replay->audio_timestamps[position]) *
+							     (uint64_t)replay->oai.samples_per_sec) /
+							    1000000000ULL);
+	}
+
+	c->previous_frame_timestamp = 0;
+	if (!c->play)
+		c->stepped = true;
+}
+
+void replay_set_time(void *data, int64_t ms)
 {
 	struct replay_source *c = data;
 
-	if (c->pause_timestamp > c->start_timestamp) {
-		c->start_timestamp = c->pause_timestamp - seconds * 1000000UL;
-	} else {
-		c->start_timestamp = obs_get_video_frame_time() - seconds * 1000000UL;
+	pthread_mutex_lock(&c->video_mutex);
+	pthread_mutex_lock(&c->audio_mutex);
+	struct replay *replay = c->current_replay;
+	replay_seek_locked(c, c->backward ? replay_source_offset_back(c, replay, ms * 1000000)
+					  : replay_source_offset(c, replay, ms * 1000000));
+	pthread_mutex_unlock(&c->audio_mutex);
+	pthread_mutex_unlock(&c->video_mutex);
+	replay_update_text(c);
+}
+
+// seeks to a frame of the current replay, unlike replay_set_time it is exact for frames closer than a millisecond
+static void replay_seek_frame(struct replay_source *c, uint64_t frame)
+{
+	pthread_mutex_lock(&c->video_mutex);
+	pthread_mutex_lock(&c->audio_mutex);
+	struct replay *replay = c->current_replay;
+	if (replay->video_frame_count) {
+		if (frame >= replay->video_frame_count)
+			frame = replay->video_frame_count - 1;
+		const int64_t source = (int64_t)(replay->video_timestamps[frame] - replay->first_frame_timestamp);
+		replay_seek_locked(c, c->backward ? (int64_t)replay->duration - source : source);
 	}
+	pthread_mutex_unlock(&c->audio_mutex);
+	pthread_mutex_unlock(&c->video_mutex);
+	replay_update_text(c);
 }
 
 enum obs_media_state replay_get_state(void *data)
@@ -3142,6 +5915,224 @@ enum obs_media_state replay_get_state(void *data)
 	return OBS_MEDIA_STATE_PAUSED;
 }
 
+/* the control api gives scripts and plugins typed calls through the proc handler of the source,
+ * without the settings round trip and full update that execute_action needs */
+
+static inline void replay_control_done(struct replay_source *c, uint64_t start)
+{
+	c->control_calls++;
+	c->control_ns += os_gettime_ns() - start;
+}
+
+// the most recently added replay, only compared and never dereferenced
+static struct replay *replay_control_newest(struct replay_source *c)
+{
+	pthread_mutex_lock(&c->replay_mutex);
+	const int count = replay_list_count(c);
+	struct replay *newest = count ? replay_at(c, count - 1) : NULL;
+	pthread_mutex_unlock(&c->replay_mutex);
+	return newest;
+}
+
+// loads a replay of the last duration_ms before end_ms ago, zero duration_ms takes all that is buffered
+static void replay_control_load(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	const long long duration = calldata_int(cd, "duration_ms");
+	const long long end = calldata_int(cd, "end_ms");
+	const struct replay_range range = {duration > 0 ? (uint64_t)duration * 1000000 : 0, end > 0 ? (uint64_t)end * 1000000 : 0};
+	struct replay *last = replay_control_newest(c);
+	if (c->source_name)
+		replay_retrieve_range(c, &range);
+	calldata_set_bool(cd, "success", replay_control_newest(c) != last);
+	replay_control_done(c, start);
+}
+
+// saves the current replay, to path when given
+static void replay_control_save(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	const char *path = calldata_string(cd, "path");
+	const bool idle = c->saving_status == SAVING_STATUS_NONE;
+	if (idle) {
+		bfree(c->save_path);
+		c->save_path = path && *path ? bstrdup(path) : NULL;
+		c->saving_status = SAVING_STATUS_STARTING;
+	}
+	calldata_set_bool(cd, "success", idle);
+	replay_control_done(c, start);
+}
+
+static void replay_control_seek(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	replay_set_time(c, (int64_t)calldata_int(cd, "time_ms"));
+	replay_control_done(c, start);
+}
+
+static void replay_control_seek_frame(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	const long long frame = calldata_int(cd, "frame");
+	replay_seek_frame(c, frame > 0 ? (uint64_t)frame : 0);
+	replay_control_done(c, start);
+}
+
+static void replay_control_set_speed(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	update_speed(c, (float)calldata_float(cd, "speed"));
+	replay_control_done(c, start);
+}
+
+// plays the replay at index, counted from the oldest
+static void replay_control_select(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	const long long index = calldata_int(cd, "index");
+	// the tick and the spill thread change the list and the position under the replay mutex
+	pthread_mutex_lock(&c->replay_mutex);
+	const bool valid = index >= 0 && index < replay_list_count(c);
+	if (valid) {
+		c->replay_position = (int)index;
+		pthread_mutex_lock(&c->video_mutex);
+		replay_update_position(c, false);
+		pthread_mutex_unlock(&c->video_mutex);
+	}
+	pthread_mutex_unlock(&c->replay_mutex);
+	calldata_set_bool(cd, "success", valid);
+	replay_control_done(c, start);
+}
+
+static void replay_control_action(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	const char *action = calldata_string(cd, "action");
+	calldata_set_bool(cd, "success", action && replay_execute_action(c, action));
+	replay_control_done(c, start);
+}
+
+// metadata of the replay at index, an id of 0 when there is none
+static void replay_control_get_replay(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	const long long index = calldata_int(cd, "index");
+	pthread_mutex_lock(&c->replay_mutex);
+	struct replay_library_entry *entry = index >= 0 ? replay_library_at(&c->replays, (size_t)index) : NULL;
+	calldata_set_int(cd, "id", entry ? (long long)entry->id : 0);
+	calldata_set_string(cd, "source", entry && entry->source_name ? entry->source_name : "");
+	calldata_set_int(cd, "capture_time", entry ? (long long)entry->capture_time : 0);
+	const struct replay *replay = entry ? entry->replay : NULL;
+	calldata_set_int(cd, "duration_ms", (long long)((replay ? replay->duration : entry ? entry->duration : 0) / 1000000));
+	calldata_set_int(cd, "trim_front_ms", (replay ? replay->trim_front : entry ? entry->trim_front : 0) / 1000000);
+	calldata_set_int(cd, "trim_end_ms", (replay ? replay->trim_end : entry ? entry->trim_end : 0) / 1000000);
+	calldata_set_string(cd, "tags", entry && entry->tags ? entry->tags : "");
+	calldata_set_bool(cd, "spilled", entry && !replay);
+	pthread_mutex_unlock(&c->replay_mutex);
+	replay_control_done(c, start);
+}
+
+static void replay_control_set_tags(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	pthread_mutex_lock(&c->replay_mutex);
+	struct replay_library_entry *entry = replay_library_find(&c->replays, (uint64_t)calldata_int(cd, "id"));
+	if (entry)
+		replay_library_set_tags(entry, calldata_string(cd, "tags"));
+	pthread_mutex_unlock(&c->replay_mutex);
+	calldata_set_bool(cd, "success", entry != NULL);
+	replay_control_done(c, start);
+}
+
+/* the thumbnail strip of the replay at index or of the selected replay for
+ * -1, copied into buffer when its serial is not known_serial and it fits,
+ * a serial of 0 when there is none yet */
+static void replay_control_get_thumbnails(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	long long index = calldata_int(cd, "index");
+	pthread_mutex_lock(&c->replay_mutex);
+	if (index < 0)
+		index = c->replay_position;
+	struct replay_library_entry *entry = replay_library_at(&c->replays, (size_t)index);
+	struct replay_thumbnails *thumbnails = entry ? entry->thumbnails : NULL;
+	replay_thumbnails_addref(thumbnails);
+	pthread_mutex_unlock(&c->replay_mutex);
+
+	calldata_set_int(cd, "serial", thumbnails ? thumbnails->serial : 0);
+	calldata_set_int(cd, "width", thumbnails ? thumbnails->width : 0);
+	calldata_set_int(cd, "height", thumbnails ? thumbnails->height : 0);
+	calldata_set_int(cd, "count", thumbnails ? thumbnails->count : 0);
+	calldata_set_int(cd, "linesize", thumbnails ? thumbnails->linesize : 0);
+	bool copied = false;
+	if (thumbnails && thumbnails->serial != calldata_int(cd, "known_serial")) {
+		uint8_t *buffer = calldata_ptr(cd, "buffer");
+		const size_t size = (size_t)thumbnails->linesize * thumbnails->height;
+		if (buffer && calldata_int(cd, "size") >= (long long)size) {
+			memcpy(buffer, thumbnails->data, size);
+			copied = true;
+		}
+	}
+	calldata_set_bool(cd, "copied", copied);
+	replay_thumbnails_release(thumbnails);
+	replay_control_done(c, start);
+}
+
+static void replay_control_get_state(void *data, calldata_t *cd)
+{
+	struct replay_source *c = data;
+	const uint64_t start = os_gettime_ns();
+	pthread_mutex_lock(&c->video_mutex);
+	calldata_set_int(cd, "state", (long long)replay_get_state(c));
+	calldata_set_int(cd, "index", c->replay_position);
+	calldata_set_int(cd, "count", (long long)replay_list_count(c));
+	calldata_set_int(cd, "time_ms", replay_get_time(c));
+	struct replay *replay = c->current_replay;
+	calldata_set_int(cd, "duration_ms", replay_output_offset(c, replay, (int64_t)replay->duration) / 1000000);
+	calldata_set_int(cd, "frame", (long long)c->video_frame_position);
+	calldata_set_int(cd, "frame_count", (long long)replay->video_frame_count);
+	calldata_set_float(cd, "speed", c->speed_percent);
+	calldata_set_bool(cd, "backward", c->backward);
+	calldata_set_bool(cd, "saving", c->saving_status != SAVING_STATUS_NONE);
+	pthread_mutex_unlock(&c->video_mutex);
+	replay_control_done(c, start);
+}
+
+static void replay_control_register(struct replay_source *context)
+{
+	proc_handler_t *ph = obs_source_get_proc_handler(context->source);
+	proc_handler_add(ph, "void load(in int duration_ms, in int end_ms, out bool success)", replay_control_load, context);
+	proc_handler_add(ph, "void save(in string path, out bool success)", replay_control_save, context);
+	proc_handler_add(ph, "void seek(in int time_ms)", replay_control_seek, context);
+	proc_handler_add(ph, "void seek_frame(in int frame)", replay_control_seek_frame, context);
+	proc_handler_add(ph, "void set_speed(in float speed)", replay_control_set_speed, context);
+	proc_handler_add(ph, "void select(in int index, out bool success)", replay_control_select, context);
+	proc_handler_add(ph, "void action(in string action, out bool success)", replay_control_action, context);
+	proc_handler_add(ph,
+			 "void get_replay(in int index, out int id, out string source, out int capture_time, out int duration_ms, "
+			 "out int trim_front_ms, out int trim_end_ms, out string tags, out bool spilled)",
+			 replay_control_get_replay, context);
+	proc_handler_add(ph, "void set_tags(in int id, in string tags, out bool success)", replay_control_set_tags, context);
+	proc_handler_add(ph,
+			 "void get_thumbnails(in int index, in int known_serial, in ptr buffer, in int size, out int serial, "
+			 "out int width, out int height, out int count, out int linesize, out bool copied)",
+			 replay_control_get_thumbnails, context);
+	proc_handler_add(ph,
+			 "void get_state(out int state, out int index, out int count, out int time_ms, out int duration_ms, "
+			 "out int frame, out int frame_count, out float speed, out bool backward, out bool saving)",
+			 replay_control_get_state, context);
+}
+
 struct obs_source_info replay_source_info = {
 	.id = REPLAY_SOURCE_ID,
 	.type = OBS_SOURCE_TYPE_INPUT,
@@ -0,0 +1,147 @@
+#include <obs-module.h>
+#include <util/platform.h>
+#include "replay.h"
+
+/* spilled replays are written as a plain sequence of records, every frame is
+ * its struct followed by its planes and every audio packet its frame count,
+ * timestamp and a mask of the planes present followed by those planes, the
+ * file is only read back by the process that wrote it */
+
+bool replay_spill_write(FILE *file, const void *data, size_t size)
+{
+	return !size || fwrite(data, 1, size, file) == size;
+}
+
+bool replay_spill_read(FILE *file, void *data, size_t size)
+{
+	return !size || fread(data, 1, size, file) == size;
+}
+
+// rows of a plane, the chroma planes of 4:2:0 formats have half the rows
+static uint32_t replay_spill_plane_rows(enum video_format format, uint32_t height, size_t plane)
+{
+	if (!plane)
+		return height;
+	switch (format) {
+	case VIDEO_FORMAT_I420:
+	case VIDEO_FORMAT_NV12:
+	case VIDEO_FORMAT_I010:
+	case VIDEO_FORMAT_P010:
+		return (height + 1) / 2;
+	case VIDEO_FORMAT_I40A:
+		return plane < 3 ? (height + 1) / 2 : height;
+	default:
+		return height;
+	}
+}
+
+bool replay_spill_write_video(FILE *file, struct obs_source_frame *const *frames, uint64_t count)
+{
+	for (uint64_t i = 0; i < count; i++) {
+		const struct obs_source_frame *frame = frames[i];
+		if (!replay_spill_write(file, frame, sizeof(*frame)))
+			return false;
+		for (size_t p = 0; p < MAX_AV_PLANES && frame->data[p]; p++) {
+			const size_t size = (size_t)frame->linesize[p] * replay_spill_plane_rows(frame->format, frame->height, p);
+			if (!replay_spill_write(file, frame->data[p], size))
+				return false;
+		}
+	}
+	return true;
+}
+
+// reads count frames into frames, returns how many were read
+uint64_t replay_spill_read_video(FILE *file, struct obs_source_frame **frames, uint64_t count)
+{
+	uint8_t *row = NULL;
+	size_t row_size = 0;
+	uint64_t i = 0;
+	for (; i < count; i++) {
+		struct obs_source_frame header;
+		if (!replay_spill_read(file, &header, sizeof(header)))
+			break;
+		struct obs_source_frame *frame = obs_source_frame_create(header.format, header.width, header.height);
+		bool ok = frame != NULL;
+		for (size_t p = 0; ok && p < MAX_AV_PLANES && header.data[p]; p++) {
+			const uint32_t rows = replay_spill_plane_rows(header.format, header.height, p);
+			if (frame->linesize[p] == header.linesize[p]) {
+				ok = replay_spill_read(file, frame->data[p], (size_t)header.linesize[p] * rows);
+				continue;
+			}
+			// a different alignment than the frame was written with, copy row by row
+			if (row_size < header.linesize[p]) {
+				row_size = header.linesize[p];
+				row = brealloc(row, row_size);
+			}
+			const size_t bytes = frame->linesize[p] < header.linesize[p] ? frame->linesize[p] : header.linesize[p];
+			for (uint32_t y = 0; ok && y < rows; y++) {
+				ok = replay_spill_read(file, row, header.linesize[p]);
+				if (ok)
+					memcpy(frame->data[p] + (size_t)y * frame->linesize[p], row, bytes);
+			}
+		}
+		if (!ok) {
+			if (frame)
+				obs_source_frame_destroy(frame);
+			break;
+		}
+		// take everything but the planes from the stored frame
+		uint8_t *data[MAX_AV_PLANES];
+		uint32_t linesize[MAX_AV_PLANES];
+		memcpy(data, frame->data, sizeof(data));
+		memcpy(linesize, frame->linesize, sizeof(linesize));
+		*frame = header;
+		memcpy(frame->data, data, sizeof(data));
+		memcpy(frame->linesize, linesize, sizeof(linesize));
+		frame->refs = 1;
+		frame->prev_frame = false;
+		frames[i] = frame;
+	}
+	bfree(row);
+	return i;
+}
+
+bool replay_spill_write_audio(FILE *file, const struct obs_audio_data *audio, uint64_t count)
+{
+	for (uint64_t i = 0; i < count; i++) {
+		uint32_t planes = 0;
+		for (size_t p = 0; p < MAX_AV_PLANES; p++) {
+			if (audio[i].data[p])
+				planes |= 1u << p;
+		}
+		if (!replay_spill_write(file, &audio[i].frames, sizeof(audio[i].frames)) ||
+		    !replay_spill_write(file, &audio[i].timestamp, sizeof(audio[i].timestamp)) ||
+		    !replay_spill_write(file, &planes, sizeof(planes)))
+			return false;
+		for (size_t p = 0; p < MAX_AV_PLANES; p++) {
+			if (audio[i].data[p] && !replay_spill_write(file, audio[i].data[p], audio[i].frames * sizeof(float)))
+				return false;
+		}
+	}
+	return true;
+}
+
+// reads count packets of planar float audio into audio, returns how many were read
+uint64_t replay_spill_read_audio(FILE *file, struct obs_audio_data *audio, uint64_t count)
+{
+	uint64_t i = 0;
+	for (; i < count; i++) {
+		struct obs_audio_data packet = {0};
+		uint32_t planes = 0;
+		bool ok = replay_spill_read(file, &packet.frames, sizeof(packet.frames)) &&
+			  replay_spill_read(file, &packet.timestamp, sizeof(packet.timestamp)) &&
+			  replay_spill_read(file, &planes, sizeof(planes));
+		if (ok)
+			replay_audio_packet_alloc(&packet, planes);
+		for (size_t p = 0; ok && p < MAX_AV_PLANES; p++) {
+			if (packet.data[p])
+				ok = replay_spill_read(file, packet.data[p], packet.frames * sizeof(float));
+		}
+		if (!ok) {
+			free_audio_packet(&packet);
+			break;
+		}
+		audio[i] = packet;
+	}
+	return i;
+}
@@ -0,0 +1,204 @@
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/sse-intrin.h>
+#include <inttypes.h>
+#include <math.h>
+#include "replay.h"
+
+/* WSOLA: every output hop overlap-adds a hann windowed input frame taken
+ * near the ideal analysis position, picking the offset within the search
+ * range that best continues the previously used frame */
+
+static float dot_samples(const float *a, const float *b, size_t count)
+{
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+	}
+	float s[4];
+	_mm_storeu_ps(s, _mm_add_ps(sum0, sum1));
+	float sum = s[0] + s[1] + s[2] + s[3];
+	for (; i < count; i++)
+		sum += a[i] * b[i];
+	return sum;
+}
+
+// out = overlap + window * in
+static void overlap_add(float *out, const float *overlap, const float *window, const float *in, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128 v = _mm_mul_ps(_mm_loadu_ps(window + i), _mm_loadu_ps(in + i));
+		_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(overlap + i), v));
+	}
+	for (; i < count; i++)
+		out[i] = overlap[i] + window[i] * in[i];
+}
+
+static void window_samples(float *out, const float *window, const float *in, size_t count)
+{
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(window + i), _mm_loadu_ps(in + i)));
+	for (; i < count; i++)
+		out[i] = window[i] * in[i];
+}
+
+void replay_stretch_init(struct replay_stretch *stretch, size_t channels, uint32_t sample_rate)
+{
+	memset(stretch, 0, sizeof(*stretch));
+	if (channels > MAX_AV_PLANES)
+		channels = MAX_AV_PLANES;
+	stretch->channels = channels;
+	stretch->sample_rate = sample_rate;
+	// about 20 ms frames with half overlap and a quarter frame search range
+	stretch->frame = 256;
+	while (stretch->frame < sample_rate / 50)
+		stretch->frame *= 2;
+	stretch->hop = stretch->frame / 2;
+	stretch->search = stretch->frame / 4;
+	stretch->window = bmalloc(stretch->frame * sizeof(float));
+	for (size_t i = 0; i < stretch->frame; i++)
+		stretch->window[i] = 0.5f - 0.5f * cosf(6.28318531f * (float)i / (float)stretch->frame);
+	for (size_t ch = 0; ch < channels; ch++)
+		stretch->overlap[ch] = bzalloc(stretch->hop * sizeof(float));
+	stretch->speed = 1.0;
+	replay_stretch_reset(stretch);
+}
+
+void replay_stretch_free(struct replay_stretch *stretch)
+{
+	bfree(stretch->window);
+	for (size_t ch = 0; ch < MAX_AV_PLANES; ch++) {
+		bfree(stretch->input[ch]);
+		bfree(stretch->overlap[ch]);
+	}
+	bfree(stretch->mix);
+	memset(stretch, 0, sizeof(*stretch));
+}
+
+void replay_stretch_reset(struct replay_stretch *stretch)
+{
+	stretch->input_size = 0;
+	stretch->input_pos = 0.0;
+	stretch->previous = 0;
+	stretch->consumed = 0;
+	stretch->first = true;
+	for (size_t ch = 0; ch < stretch->channels; ch++)
+		memset(stretch->overlap[ch], 0, stretch->hop * sizeof(float));
+}
+
+void replay_stretch_set_speed(struct replay_stretch *stretch, double speed)
+{
+	stretch->speed = speed;
+}
+
+// input frames still missing before the next hop can be produced
+size_t replay_stretch_needed(const struct replay_stretch *stretch)
+{
+	const size_t end = (size_t)stretch->input_pos + stretch->search + stretch->frame + 1;
+	return end > stretch->input_size ? end - stretch->input_size : 0;
+}
+
+void replay_stretch_push(struct replay_stretch *stretch, float *const *data, size_t frames)
+{
+	if (stretch->input_size + frames > stretch->input_capacity) {
+		stretch->input_capacity = (stretch->input_size + frames) * 2;
+		for (size_t ch = 0; ch < stretch->channels; ch++)
+			stretch->input[ch] = brealloc(stretch->input[ch], stretch->input_capacity * sizeof(float));
+		stretch->mix = brealloc(stretch->mix, stretch->input_capacity * sizeof(float));
+	}
+	for (size_t ch = 0; ch < stretch->channels; ch++) {
+		if (data[ch])
+			memcpy(stretch->input[ch] + stretch->input_size, data[ch], frames * sizeof(float));
+		else
+			memset(stretch->input[ch] + stretch->input_size, 0, frames * sizeof(float));
+	}
+	// correlation runs on the sum of the first two channels
+	for (size_t i = 0; i < frames; i++) {
+		float v = stretch->input[0][stretch->input_size + i];
+		if (stretch->channels > 1)
+			v += stretch->input[1][stretch->input_size + i];
+		stretch->mix[stretch->input_size + i] = v;
+	}
+	stretch->input_size += frames;
+}
+
+static size_t replay_stretch_best_offset(const struct replay_stretch *stretch, size_t ideal)
+{
+	const size_t overlap = stretch->frame - stretch->hop;
+	const float *natural = stretch->mix + stretch->previous + stretch->hop;
+	const size_t from = ideal > stretch->search ? ideal - stretch->search : 0;
+	const size_t to = ideal + stretch->search;
+	size_t best = ideal;
+	float best_score = -INFINITY;
+	for (size_t candidate = from; candidate <= to; candidate++) {
+		const float *c = stretch->mix + candidate;
+		const float energy = dot_samples(c, c, overlap);
+		const float score = dot_samples(c, natural, overlap) / sqrtf(energy + 1e-9f);
+		if (score > best_score) {
+			best_score = score;
+			best = candidate;
+		}
+	}
+	return best;
+}
+
+// produces one hop of output into out, returns the number of frames or 0 when more input is needed
+size_t replay_stretch_process(struct replay_stretch *stretch, float **out)
+{
+	if (replay_stretch_needed(stretch))
+		return 0;
+
+	const uint64_t start = os_gettime_ns();
+	const size_t ideal = (size_t)stretch->input_pos;
+	const size_t chosen = stretch->first ? ideal : replay_stretch_best_offset(stretch, ideal);
+	const size_t hop = stretch->hop;
+	for (size_t ch = 0; ch < stretch->channels; ch++) {
+		const float *in = stretch->input[ch] + chosen;
+		overlap_add(out[ch], stretch->overlap[ch], stretch->window, in, hop);
+		window_samples(stretch->overlap[ch], stretch->window + hop, in + hop, stretch->frame - hop);
+	}
+	stretch->first = false;
+	stretch->previous = chosen;
+	stretch->input_pos += (double)hop * stretch->speed;
+
+	// drop input that can no longer be used
+	const size_t lowest = (size_t)stretch->input_pos > stretch->search ? (size_t)stretch->input_pos - stretch->search : 0;
+	size_t drop = stretch->previous < lowest ? stretch->previous : lowest;
+	if (drop > stretch->input_size)
+		drop = stretch->input_size;
+	if (drop) {
+		for (size_t ch = 0; ch < stretch->channels; ch++)
+			memmove(stretch->input[ch], stretch->input[ch] + drop, (stretch->input_size - drop) * sizeof(float));
+		memmove(stretch->mix, stretch->mix + drop, (stretch->input_size - drop) * sizeof(float));
+		stretch->input_size -= drop;
+		stretch->input_pos -= (double)drop;
+		stretch->previous -= drop;
+		stretch->consumed += drop;
+	}
+
+	stretch->frames_out += hop;
+	stretch->process_ns += os_gettime_ns() - start;
+	return hop;
+}
+
+// source position of the next output hop, in frames since the last reset
+double replay_stretch_position(const struct replay_stretch *stretch)
+{
+	return (double)stretch->consumed + stretch->input_pos;
+}
+
+void replay_stretch_log_stats(struct replay_stretch *stretch, const char *name)
+{
+	if (!stretch->frames_out || !stretch->channels || !stretch->sample_rate)
+		return;
+	const double audio_seconds = (double)stretch->frames_out / (double)stretch->sample_rate;
+	blog(LOG_INFO,
+	     "[replay_source: '%s'] time-stretch used %.3f ms CPU per second of audio per channel, added latency %.1f ms",
+	     name, (double)stretch->process_ns / 1000000.0 / audio_seconds / (double)stretch->channels,
+	     (double)(stretch->frame + stretch->search) * 1000.0 / (double)stretch->sample_rate);
+}
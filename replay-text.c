@@ -0,0 +1,112 @@
+#include <obs-module.h>
+#include <util/dstr.h>
+#include "replay.h"
+
+/* a text template is compiled once into literal runs and tokens, rendering
+ * only formats the values into the output string */
+
+static const struct {
+	const char *name;
+	size_t length;
+	int token;
+} replay_text_tokens[] = {
+	{"%SPEED%", 7, REPLAY_TEXT_SPEED},
+	{"%PROGRESS%", 10, REPLAY_TEXT_PROGRESS},
+	{"%COUNT%", 7, REPLAY_TEXT_COUNT},
+	{"%INDEX%", 7, REPLAY_TEXT_INDEX},
+	{"%DURATION%", 10, REPLAY_TEXT_DURATION},
+	{"%TIME%", 6, REPLAY_TEXT_TIME},
+	{"%FPS%", 5, REPLAY_TEXT_FPS},
+};
+
+static void replay_text_add(struct replay_text_template *tmpl, int token, size_t offset, size_t length)
+{
+	// consecutive literal characters become one run
+	if (token == REPLAY_TEXT_LITERAL && tmpl->count && tmpl->tokens[tmpl->count - 1].token == REPLAY_TEXT_LITERAL) {
+		tmpl->tokens[tmpl->count - 1].length += length;
+		return;
+	}
+	struct replay_text_token *t = &tmpl->tokens[tmpl->count++];
+	t->token = token;
+	t->offset = offset;
+	t->length = length;
+	tmpl->used |= 1u << token;
+}
+
+void replay_text_compile(struct replay_text_template *tmpl, const char *format)
+{
+	replay_text_free(tmpl);
+	if (!format || !*format)
+		return;
+	const size_t length = strlen(format);
+	tmpl->format = bstrdup(format);
+	tmpl->tokens = bzalloc(length * sizeof(struct replay_text_token));
+	size_t pos = 0;
+	while (pos < length) {
+		bool found = false;
+		if (format[pos] == '%') {
+			for (size_t i = 0; i < sizeof(replay_text_tokens) / sizeof(replay_text_tokens[0]); i++) {
+				if (astrcmp_n(format + pos, replay_text_tokens[i].name, replay_text_tokens[i].length) == 0) {
+					replay_text_add(tmpl, replay_text_tokens[i].token, pos, replay_text_tokens[i].length);
+					pos += replay_text_tokens[i].length;
+					found = true;
+					break;
+				}
+			}
+		}
+		if (!found) {
+			replay_text_add(tmpl, REPLAY_TEXT_LITERAL, pos, 1);
+			pos++;
+		}
+	}
+}
+
+void replay_text_free(struct replay_text_template *tmpl)
+{
+	bfree(tmpl->format);
+	bfree(tmpl->tokens);
+	memset(tmpl, 0, sizeof(*tmpl));
+}
+
+// renders the template into out, reusing its allocation
+void replay_text_render(const struct replay_text_template *tmpl, const struct replay_text_values *values, struct dstr *out)
+{
+	if (out->array) {
+		out->len = 0;
+		out->array[0] = 0;
+	}
+	for (size_t i = 0; i < tmpl->count; i++) {
+		const struct replay_text_token *t = &tmpl->tokens[i];
+		switch (t->token) {
+		case REPLAY_TEXT_LITERAL:
+			dstr_ncat(out, tmpl->format + t->offset, t->length);
+			break;
+		case REPLAY_TEXT_SPEED:
+			dstr_catf(out, "%.1f%%", values->speed);
+			break;
+		case REPLAY_TEXT_PROGRESS:
+			if (values->has_progress)
+				dstr_catf(out, "%.1f%%", values->progress);
+			break;
+		case REPLAY_TEXT_COUNT:
+			dstr_catf(out, "%d", values->count);
+			break;
+		case REPLAY_TEXT_INDEX:
+			dstr_catf(out, "%d", values->index);
+			break;
+		case REPLAY_TEXT_DURATION:
+			if (values->has_duration)
+				dstr_catf(out, "%.2f", values->duration);
+			break;
+		case REPLAY_TEXT_TIME:
+			if (values->has_time)
+				dstr_catf(out, "%.2f", values->time);
+			break;
+		case REPLAY_TEXT_FPS:
+			dstr_catf(out, "%d", values->fps);
+			break;
+		}
+	}
+	if (!out->array)
+		dstr_copy(out, "");
+}
@@ -0,0 +1,250 @@
+#include <obs-module.h>
+#include <util/platform.h>
+#include <media-io/video-scaler.h>
+#include "replay.h"
+
+/* the strip is made by the libobs video scaler, it converts to BGRA and
+ * filters down in one pass with the SIMD paths of swscale, so the full size
+ * frames are only read once and never by the render thread */
+
+static bool replay_thumbnail_scaler_prepare(struct replay_thumbnail_scaler *scaler, const struct obs_source_frame *frame,
+					    uint32_t width, uint32_t height)
+{
+	if (frame->format == VIDEO_FORMAT_NONE || !frame->width || !frame->height)
+		return false;
+	const enum video_range_type range = frame->full_range ? VIDEO_RANGE_FULL : VIDEO_RANGE_PARTIAL;
+	if (scaler->scaler && scaler->from.format == frame->format && scaler->from.width == frame->width &&
+	    scaler->from.height == frame->height && scaler->from.range == range && scaler->to.width == width &&
+	    scaler->to.height == height)
+		return true;
+	replay_thumbnail_scaler_free(scaler);
+	scaler->from.format = frame->format;
+	scaler->from.width = frame->width;
+	scaler->from.height = frame->height;
+	scaler->from.range = range;
+	scaler->from.colorspace = VIDEO_CS_DEFAULT;
+	scaler->to.format = VIDEO_FORMAT_BGRA;
+	scaler->to.width = width;
+	scaler->to.height = height;
+	scaler->to.range = VIDEO_RANGE_FULL;
+	scaler->to.colorspace = VIDEO_CS_DEFAULT;
+	if (video_scaler_create(&scaler->scaler, &scaler->to, &scaler->from, VIDEO_SCALE_BILINEAR) != VIDEO_SCALER_SUCCESS) {
+		scaler->scaler = NULL;
+		return false;
+	}
+	return true;
+}
+
+void replay_thumbnail_scaler_free(struct replay_thumbnail_scaler *scaler)
+{
+	if (scaler->scaler)
+		video_scaler_destroy(scaler->scaler);
+	memset(scaler, 0, sizeof(*scaler));
+}
+
+// one thumbnail of width pixels per frame, the height follows the aspect of the first frame
+struct replay_thumbnails *replay_thumbnails_create(struct replay_thumbnail_scaler *scaler, struct obs_source_frame *const *frames,
+						   uint32_t count, uint32_t width)
+{
+	if (!count || !width || !frames[0]->width || !frames[0]->height)
+		return NULL;
+	uint32_t height = (uint32_t)((uint64_t)width * frames[0]->height / frames[0]->width);
+	height = (height + 1) & ~1u;
+	if (height < 2)
+		height = 2;
+
+	struct replay_thumbnails *thumbnails = bzalloc(sizeof(struct replay_thumbnails));
+	thumbnails->refs = 1;
+	thumbnails->width = width;
+	thumbnails->height = height;
+	thumbnails->count = count;
+	thumbnails->linesize = width * 4 * count;
+	thumbnails->data = bzalloc((size_t)thumbnails->linesize * height);
+	for (uint32_t i = 0; i < count; i++) {
+		const struct obs_source_frame *frame = frames[i];
+		// a thumbnail that can not be scaled stays transparent
+		if (!replay_thumbnail_scaler_prepare(scaler, frame, width, height))
+			continue;
+		uint8_t *out[MAX_AV_PLANES] = {thumbnails->data + (size_t)i * width * 4};
+		uint32_t out_linesize[MAX_AV_PLANES] = {thumbnails->linesize};
+		video_scaler_scale(scaler->scaler, out, out_linesize, (const uint8_t *const *)frame->data, frame->linesize);
+	}
+	return thumbnails;
+}
+
+void replay_thumbnails_addref(struct replay_thumbnails *thumbnails)
+{
+	if (thumbnails)
+		os_atomic_inc_long(&thumbnails->refs);
+}
+
+void replay_thumbnails_release(struct replay_thumbnails *thumbnails)
+{
+	if (!thumbnails || os_atomic_dec_long(&thumbnails->refs) != 0)
+		return;
+	bfree(thumbnails->data);
+	bfree(thumbnails);
+}
+
+/* the thumbnails source shows the strip of the replay a replay source has
+ * selected, it asks the replay source for it through get_thumbnails every
+ * tick while showing and only copies the strip when its serial changed */
+struct replay_thumbnails_source {
+	obs_source_t *source;
+	char *replay_source_name;
+	obs_weak_source_t *target;
+	uint64_t lookup_timestamp;
+	long long serial;
+	uint8_t *buffer;
+	size_t size;
+};
+
+static const char *replay_thumbnails_source_get_name(void *type_data)
+{
+	UNUSED_PARAMETER(type_data);
+	return obs_module_text("ReplayThumbnails");
+}
+
+static void replay_thumbnails_source_update(void *data, obs_data_t *settings)
+{
+	struct replay_thumbnails_source *ts = data;
+	const char *name = obs_data_get_string(settings, SETTING_SOURCE);
+	if (ts->replay_source_name && strcmp(ts->replay_source_name, name) == 0)
+		return;
+	bfree(ts->replay_source_name);
+	ts->replay_source_name = bstrdup(name);
+	obs_weak_source_release(ts->target);
+	ts->target = NULL;
+	ts->lookup_timestamp = 0;
+	ts->serial = 0;
+	obs_source_output_video(ts->source, NULL);
+}
+
+static void *replay_thumbnails_source_create(obs_data_t *settings, obs_source_t *source)
+{
+	struct replay_thumbnails_source *ts = bzalloc(sizeof(struct replay_thumbnails_source));
+	ts->source = source;
+	obs_source_set_async_unbuffered(source, true);
+	replay_thumbnails_source_update(ts, settings);
+	return ts;
+}
+
+static void replay_thumbnails_source_destroy(void *data)
+{
+	struct replay_thumbnails_source *ts = data;
+	obs_weak_source_release(ts->target);
+	bfree(ts->replay_source_name);
+	bfree(ts->buffer);
+	bfree(ts);
+}
+
+// the replay source to show, a failed lookup by name is retried once a second
+static obs_source_t *replay_thumbnails_source_target(struct replay_thumbnails_source *ts)
+{
+	if (ts->target) {
+		obs_source_t *s = obs_weak_source_get_source(ts->target);
+		if (s && !obs_source_removed(s))
+			return s;
+		obs_source_release(s);
+		obs_weak_source_release(ts->target);
+		ts->target = NULL;
+	}
+	const uint64_t now = os_gettime_ns();
+	if (!ts->replay_source_name || !*ts->replay_source_name || now < ts->lookup_timestamp)
+		return NULL;
+	ts->lookup_timestamp = now + 1000000000;
+	obs_source_t *s = obs_get_source_by_name(ts->replay_source_name);
+	if (s && strcmp(obs_source_get_unversioned_id(s), REPLAY_SOURCE_ID) != 0) {
+		obs_source_release(s);
+		return NULL;
+	}
+	if (s)
+		ts->target = obs_source_get_weak_source(s);
+	return s;
+}
+
+static void replay_thumbnails_source_tick(void *data, float seconds)
+{
+	UNUSED_PARAMETER(seconds);
+	struct replay_thumbnails_source *ts = data;
+	if (!obs_source_showing(ts->source))
+		return;
+	obs_source_t *target = replay_thumbnails_source_target(ts);
+	if (!target) {
+		if (ts->serial) {
+			ts->serial = 0;
+			obs_source_output_video(ts->source, NULL);
+		}
+		return;
+	}
+	uint8_t stack[512];
+	calldata_t cd;
+	calldata_init_fixed(&cd, stack, sizeof(stack));
+	calldata_set_int(&cd, "index", -1);
+	calldata_set_int(&cd, "known_serial", ts->serial);
+	calldata_set_ptr(&cd, "buffer", ts->buffer);
+	calldata_set_int(&cd, "size", (long long)ts->size);
+	proc_handler_call(obs_source_get_proc_handler(target), "get_thumbnails", &cd);
+	obs_source_release(target);
+
+	const long long serial = calldata_int(&cd, "serial");
+	if (serial == ts->serial)
+		return;
+	if (!serial) {
+		ts->serial = 0;
+		obs_source_output_video(ts->source, NULL);
+		return;
+	}
+	const uint32_t linesize = (uint32_t)calldata_int(&cd, "linesize");
+	const uint32_t height = (uint32_t)calldata_int(&cd, "height");
+	if (!calldata_bool(&cd, "copied")) {
+		// the buffer is too small for the strip, it gets copied on the next tick
+		const size_t size = (size_t)linesize * height;
+		if (size > ts->size) {
+			ts->buffer = brealloc(ts->buffer, size);
+			ts->size = size;
+		}
+		return;
+	}
+	struct obs_source_frame frame = {0};
+	frame.data[0] = ts->buffer;
+	frame.linesize[0] = linesize;
+	frame.width = (uint32_t)(calldata_int(&cd, "width") * calldata_int(&cd, "count"));
+	frame.height = height;
+	frame.format = VIDEO_FORMAT_BGRA;
+	frame.full_range = true;
+	frame.timestamp = os_gettime_ns();
+	obs_source_output_video(ts->source, &frame);
+	ts->serial = serial;
+}
+
+static bool replay_thumbnails_enum_replay_sources(void *data, obs_source_t *source)
+{
+	obs_property_t *prop = data;
+	if (strcmp(obs_source_get_unversioned_id(source), REPLAY_SOURCE_ID) == 0)
+		obs_property_list_add_string(prop, obs_source_get_name(source), obs_source_get_name(source));
+	return true;
+}
+
+static obs_properties_t *replay_thumbnails_source_properties(void *data)
+{
+	UNUSED_PARAMETER(data);
+	obs_properties_t *props = obs_properties_create();
+	obs_property_t *prop = obs_properties_add_list(props, SETTING_SOURCE, obs_module_text("ReplaySource"),
+						       OBS_COMBO_TYPE_EDITABLE, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(prop, "", "");
+	obs_enum_sources(replay_thumbnails_enum_replay_sources, prop);
+	return props;
+}
+
+struct obs_source_info replay_thumbnails_source_info = {
+	.id = REPLAY_THUMBNAILS_ID,
+	.type = OBS_SOURCE_TYPE_INPUT,
+	.output_flags = OBS_SOURCE_ASYNC_VIDEO | OBS_SOURCE_DO_NOT_DUPLICATE,
+	.get_name = replay_thumbnails_source_get_name,
+	.create = replay_thumbnails_source_create,
+	.destroy = replay_thumbnails_source_destroy,
+	.update = replay_thumbnails_source_update,
+	.get_properties = replay_thumbnails_source_properties,
+	.video_tick = replay_thumbnails_source_tick,
+};
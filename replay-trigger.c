@@ -0,0 +1,294 @@
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/sse-intrin.h>
+#include <media-io/audio-math.h>
+#include <inttypes.h>
+#include <math.h>
+#include "replay.h"
+
+void replay_trigger_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_int(settings, SETTING_TRIGGER_MODE, TRIGGER_MODE_PEAK);
+	obs_data_set_default_int(settings, SETTING_TRIGGER_WINDOW, 10);
+	obs_data_set_default_double(settings, SETTING_TRIGGER_HYSTERESIS, 6.0);
+	obs_data_set_default_int(settings, SETTING_TRIGGER_MIN_DURATION, 0);
+}
+
+void replay_trigger_properties(obs_properties_t *props)
+{
+	obs_properties_add_float_slider(props, SETTING_AUDIO_THRESHOLD, obs_module_text("ThresholdDb"), SETTING_AUDIO_THRESHOLD_MIN,
+					SETTING_AUDIO_THRESHOLD_MAX, 0.1);
+	obs_property_t *prop = obs_properties_add_list(props, SETTING_TRIGGER_MODE, obs_module_text("TriggerMode"),
+						       OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(prop, obs_module_text("TriggerModePeak"), TRIGGER_MODE_PEAK);
+	obs_property_list_add_int(prop, obs_module_text("TriggerModeRms"), TRIGGER_MODE_RMS);
+	prop = obs_properties_add_int(props, SETTING_TRIGGER_WINDOW, obs_module_text("TriggerWindow"), SETTING_TRIGGER_WINDOW_MIN,
+				      SETTING_TRIGGER_WINDOW_MAX, 1);
+	obs_property_int_set_suffix(prop, "ms");
+	obs_properties_add_float_slider(props, SETTING_TRIGGER_HYSTERESIS, obs_module_text("TriggerHysteresisDb"),
+					SETTING_TRIGGER_HYSTERESIS_MIN, SETTING_TRIGGER_HYSTERESIS_MAX, 0.1);
+	prop = obs_properties_add_int(props, SETTING_TRIGGER_MIN_DURATION, obs_module_text("TriggerMinDuration"),
+				      SETTING_TRIGGER_MIN_DURATION_MIN, SETTING_TRIGGER_MIN_DURATION_MAX, 1);
+	obs_property_int_set_suffix(prop, "ms");
+}
+
+void replay_trigger_update(struct replay_trigger *trigger, obs_data_t *settings)
+{
+	const double db = obs_data_get_double(settings, SETTING_AUDIO_THRESHOLD);
+	const double hysteresis = obs_data_get_double(settings, SETTING_TRIGGER_HYSTERESIS);
+	trigger->attack = db_to_mul((float)db);
+	trigger->release = db_to_mul((float)(db - hysteresis));
+	trigger->mode = (int)obs_data_get_int(settings, SETTING_TRIGGER_MODE);
+	trigger->window_ms = obs_data_get_int(settings, SETTING_TRIGGER_WINDOW);
+	if (trigger->window_ms < SETTING_TRIGGER_WINDOW_MIN)
+		trigger->window_ms = SETTING_TRIGGER_WINDOW_MIN;
+	trigger->min_duration = (uint64_t)obs_data_get_int(settings, SETTING_TRIGGER_MIN_DURATION) * MSEC_TO_NSEC;
+}
+
+static void level_float(const float *samples, size_t count, float *peak, double *energy)
+{
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	__m128 max0 = _mm_setzero_ps();
+	__m128 max1 = _mm_setzero_ps();
+	__m128 sum0 = _mm_setzero_ps();
+	__m128 sum1 = _mm_setzero_ps();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m128 a = _mm_loadu_ps(samples + i);
+		const __m128 b = _mm_loadu_ps(samples + i + 4);
+		max0 = _mm_max_ps(max0, _mm_and_ps(a, abs_mask));
+		max1 = _mm_max_ps(max1, _mm_and_ps(b, abs_mask));
+		sum0 = _mm_add_ps(sum0, _mm_mul_ps(a, a));
+		sum1 = _mm_add_ps(sum1, _mm_mul_ps(b, b));
+	}
+	float m[4];
+	float s[4];
+	_mm_storeu_ps(m, _mm_max_ps(max0, max1));
+	_mm_storeu_ps(s, _mm_add_ps(sum0, sum1));
+
+	float p = *peak;
+	double e = (double)s[0] + s[1] + s[2] + s[3];
+	for (size_t j = 0; j < 4; j++) {
+		if (m[j] > p)
+			p = m[j];
+	}
+	for (; i < count; i++) {
+		const float a = fabsf(samples[i]);
+		if (a > p)
+			p = a;
+		e += samples[i] * samples[i];
+	}
+	*peak = p;
+	*energy += e;
+}
+
+static inline void level_accumulate(__m128 v, __m128 abs_mask, __m128 *max, __m128 *sum)
+{
+	*max = _mm_max_ps(*max, _mm_and_ps(v, abs_mask));
+	*sum = _mm_add_ps(*sum, _mm_mul_ps(v, v));
+}
+
+static inline void level_reduce(__m128 max, __m128 sum, float *peak, double *energy)
+{
+	float m[4];
+	float s[4];
+	_mm_storeu_ps(m, max);
+	_mm_storeu_ps(s, sum);
+	for (size_t j = 0; j < 4; j++) {
+		if (m[j] > *peak)
+			*peak = m[j];
+	}
+	*energy += (double)s[0] + s[1] + s[2] + s[3];
+}
+
+// 8 samples a step, sign extended to 32 bits and converted to float in the registers
+static void level_int16(const int16_t *samples, size_t count, float *peak, double *energy)
+{
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+	__m128 max = _mm_setzero_ps();
+	__m128 sum = _mm_setzero_ps();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(samples + i));
+		const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+		const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+		level_accumulate(_mm_mul_ps(_mm_cvtepi32_ps(lo), scale), abs_mask, &max, &sum);
+		level_accumulate(_mm_mul_ps(_mm_cvtepi32_ps(hi), scale), abs_mask, &max, &sum);
+	}
+	level_reduce(max, sum, peak, energy);
+
+	float p = *peak;
+	double e = 0.0;
+	for (; i < count; i++) {
+		const float a = fabsf(samples[i] / 32768.0f);
+		if (a > p)
+			p = a;
+		e += a * a;
+	}
+	*peak = p;
+	*energy += e;
+}
+
+// 8 samples a step, the conversion to float keeps the 24 most significant bits which is plenty for a level
+static void level_int32(const int32_t *samples, size_t count, float *peak, double *energy)
+{
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 scale = _mm_set1_ps(1.0f / 2147483648.0f);
+	__m128 max = _mm_setzero_ps();
+	__m128 sum = _mm_setzero_ps();
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m128i a = _mm_loadu_si128((const __m128i *)(samples + i));
+		const __m128i b = _mm_loadu_si128((const __m128i *)(samples + i + 4));
+		level_accumulate(_mm_mul_ps(_mm_cvtepi32_ps(a), scale), abs_mask, &max, &sum);
+		level_accumulate(_mm_mul_ps(_mm_cvtepi32_ps(b), scale), abs_mask, &max, &sum);
+	}
+	level_reduce(max, sum, peak, energy);
+
+	float p = *peak;
+	double e = 0.0;
+	for (; i < count; i++) {
+		const float a = (float)fabs(samples[i] / 2147483648.0);
+		if (a > p)
+			p = a;
+		e += a * a;
+	}
+	*peak = p;
+	*energy += e;
+}
+
+static float sample_level(enum audio_format format, const uint8_t *data, size_t index)
+{
+	switch (format) {
+	case AUDIO_FORMAT_16BIT:
+	case AUDIO_FORMAT_16BIT_PLANAR:
+		return fabsf(((const int16_t *)data)[index] / 32768.0f);
+	case AUDIO_FORMAT_32BIT:
+	case AUDIO_FORMAT_32BIT_PLANAR:
+		return (float)fabs(((const int32_t *)data)[index] / 2147483648.0);
+	case AUDIO_FORMAT_FLOAT:
+	case AUDIO_FORMAT_FLOAT_PLANAR:
+		return fabsf(((const float *)data)[index]);
+	default:
+		return 0.0f;
+	}
+}
+
+static void block_level(enum audio_format format, const uint8_t *data, size_t offset, size_t count, float *peak,
+			double *energy)
+{
+	switch (format) {
+	case AUDIO_FORMAT_16BIT:
+	case AUDIO_FORMAT_16BIT_PLANAR:
+		level_int16((const int16_t *)data + offset, count, peak, energy);
+		break;
+	case AUDIO_FORMAT_32BIT:
+	case AUDIO_FORMAT_32BIT_PLANAR:
+		level_int32((const int32_t *)data + offset, count, peak, energy);
+		break;
+	case AUDIO_FORMAT_FLOAT:
+	case AUDIO_FORMAT_FLOAT_PLANAR:
+		level_float((const float *)data + offset, count, peak, energy);
+		break;
+	default:
+		break;
+	}
+}
+
+// returns true when the trigger fires, with the timestamp of the first sample over the attack threshold
+bool replay_trigger_process(struct replay_trigger *trigger, uint8_t *const *data, enum audio_format format, size_t channels,
+			    uint32_t frames, uint32_t sample_rate, uint64_t timestamp, uint64_t *trigger_timestamp)
+{
+	if (!frames || !sample_rate || !channels)
+		return false;
+
+	const uint64_t start = os_gettime_ns();
+	const bool planar = is_audio_planar(format);
+	const size_t planes = planar ? (channels < MAX_AV_PLANES ? channels : MAX_AV_PLANES) : 1;
+	const size_t stride = planar ? 1 : channels;
+	uint32_t window_frames = (uint32_t)((uint64_t)sample_rate * (uint64_t)trigger->window_ms / 1000);
+	if (!window_frames)
+		window_frames = 1;
+	if (trigger->window_fill >= window_frames)
+		trigger->window_fill = 0;
+
+	bool fired = false;
+	uint32_t pos = 0;
+	while (pos < frames) {
+		if (!trigger->window_fill) {
+			trigger->window_peak = 0.0f;
+			trigger->window_cross = 0;
+			for (size_t p = 0; p < MAX_AV_PLANES; p++)
+				trigger->window_energy[p] = 0.0;
+		}
+		uint32_t count = frames - pos;
+		if (count > window_frames - trigger->window_fill)
+			count = window_frames - trigger->window_fill;
+
+		const uint64_t block_start = timestamp + audio_frames_to_ns(sample_rate, pos);
+		for (size_t p = 0; p < planes && data[p]; p++) {
+			float peak = 0.0f;
+			block_level(format, data[p], pos * stride, count * stride, &peak, &trigger->window_energy[p]);
+			if (peak > trigger->window_peak)
+				trigger->window_peak = peak;
+			if (peak < trigger->attack || (trigger->window_cross && trigger->window_cross < block_start))
+				continue;
+
+			// locate the crossing sample only in the block that contains it
+			for (size_t i = 0; i < count * stride; i++) {
+				if (sample_level(format, data[p], pos * stride + i) >= trigger->attack) {
+					const uint64_t cross = timestamp + audio_frames_to_ns(sample_rate, pos + i / stride);
+					if (!trigger->window_cross || cross < trigger->window_cross)
+						trigger->window_cross = cross;
+					break;
+				}
+			}
+		}
+		pos += count;
+		trigger->window_fill += count;
+		if (trigger->window_fill < window_frames)
+			break;
+
+		trigger->window_fill = 0;
+		const uint64_t window_end = timestamp + audio_frames_to_ns(sample_rate, pos);
+		float level = trigger->window_peak;
+		if (trigger->mode == TRIGGER_MODE_RMS) {
+			level = 0.0f;
+			for (size_t p = 0; p < planes; p++) {
+				const float rms = (float)sqrt(trigger->window_energy[p] / ((double)window_frames * stride));
+				if (rms > level)
+					level = rms;
+			}
+		}
+
+		if (level >= trigger->attack) {
+			if (!trigger->onset)
+				trigger->onset = trigger->window_cross ? trigger->window_cross
+								       : window_end - audio_frames_to_ns(sample_rate, window_frames);
+		} else if (level < trigger->release) {
+			trigger->onset = 0;
+			trigger->triggered = false;
+		}
+		if (trigger->onset && !trigger->triggered && window_end - trigger->onset >= trigger->min_duration) {
+			trigger->triggered = true;
+			if (!fired) {
+				*trigger_timestamp = trigger->onset;
+				fired = true;
+			}
+		}
+	}
+
+	trigger->channels = channels;
+	trigger->samples += (uint64_t)frames * channels;
+	trigger->process_ns += os_gettime_ns() - start;
+	return fired;
+}
+
+void replay_trigger_log_stats(struct replay_trigger *trigger, const char *name)
+{
+	if (!trigger->samples || !trigger->process_ns)
+		return;
+	blog(LOG_INFO, "[replay_filter: '%s'] trigger detector processed %" PRIu64 " samples of %d channels at %.1f Msamples/s",
+	     name, trigger->samples, (int)trigger->channels, (double)trigger->samples * 1000.0 / (double)trigger->process_ns);
+}
@@ -3,11 +3,296 @@
 #include <util/platform.h>
 #include "replay.h"
 
-void free_audio_data(struct replay_filter *filter)
+static inline uint8_t *replay_spsc_item(const struct replay_spsc *queue, struct replay_spsc_block *block, long index)
 {
-	while (filter->audio_frames.size) {
+	return (uint8_t *)(block + 1) + (size_t)index * queue->item_size;
+}
+
+static struct replay_spsc_block *replay_spsc_block_create(struct replay_spsc *queue)
+{
+	os_atomic_inc_long(&queue->blocks_allocated);
+	return bzalloc(sizeof(struct replay_spsc_block) + queue->item_size * (size_t)queue->block_size);
+}
+
+void replay_spsc_init(struct replay_spsc *queue, size_t item_size, long block_size)
+{
+	memset(queue, 0, sizeof(*queue));
+	queue->item_size = item_size;
+	queue->block_size = block_size;
+	queue->write = queue->read = replay_spsc_block_create(queue);
+}
+
+void replay_spsc_free(struct replay_spsc *queue)
+{
+	struct replay_spsc_block *block = queue->read;
+	while (block) {
+		struct replay_spsc_block *next = block->next;
+		bfree(block);
+		block = next;
+	}
+	bfree(queue->spare);
+	queue->read = queue->write = queue->spare = NULL;
+}
+
+void replay_spsc_push(struct replay_spsc *queue, const void *item)
+{
+	struct replay_spsc_block *block = queue->write;
+	long tail = block->tail;
+	if (tail == queue->block_size) {
+		struct replay_spsc_block *next = replay_atomic_exchange_ptr((void *volatile *)&queue->spare, NULL);
+		if (next)
+			memset(next, 0, sizeof(*next));
+		else
+			next = replay_spsc_block_create(queue);
+		replay_atomic_exchange_ptr((void *volatile *)&block->next, next);
+		queue->write = block = next;
+		tail = 0;
+	}
+	memcpy(replay_spsc_item(queue, block, tail), item, queue->item_size);
+	os_atomic_set_long(&block->tail, tail + 1);
+}
+
+bool replay_spsc_pop(struct replay_spsc *queue, void *item)
+{
+	struct replay_spsc_block *block = queue->read;
+	if (block->head == queue->block_size) {
+		struct replay_spsc_block *next = replay_atomic_load_ptr((void *volatile *)&block->next);
+		if (!next)
+			return false;
+		queue->read = next;
+		bfree(replay_atomic_exchange_ptr((void *volatile *)&queue->spare, block));
+		block = next;
+	}
+	if (block->head == os_atomic_load_long(&block->tail))
+		return false;
+	memcpy(item, replay_spsc_item(queue, block, block->head), queue->item_size);
+	block->head++;
+	return true;
+}
+
+void replay_filter_init_queues(struct replay_filter *filter)
+{
+	replay_spsc_init(&filter->video_queue, sizeof(struct obs_source_frame *), REPLAY_VIDEO_QUEUE_SIZE);
+	replay_spsc_init(&filter->audio_queue, sizeof(struct obs_audio_data), REPLAY_AUDIO_QUEUE_SIZE);
+}
+
+void replay_filter_free_queues(struct replay_filter *filter)
+{
+	blog(LOG_INFO, "[replay_filter: '%s'] ingest allocated %ld video and %ld audio queue blocks",
+	     filter->src ? obs_source_get_name(filter->src) : "", filter->video_queue.blocks_allocated,
+	     filter->audio_queue.blocks_allocated);
+	replay_spsc_free(&filter->video_queue);
+	replay_spsc_free(&filter->audio_queue);
+}
+
+static void replay_filter_drain_video(struct replay_filter *filter)
+{
+	struct obs_source_frame *frame;
+	uint64_t last_timestamp = 0;
+	while (replay_spsc_pop(&filter->video_queue, &frame)) {
+		circlebuf_push_back(&filter->video_frames, &frame, sizeof(struct obs_source_frame *));
+		last_timestamp = frame->timestamp;
+	}
+	if (!last_timestamp)
+		return;
+
+	circlebuf_peek_front(&filter->video_frames, &frame, sizeof(struct obs_source_frame *));
+	uint64_t cur_duration = last_timestamp - frame->timestamp;
+	while (cur_duration > 0 && cur_duration > filter->duration) {
+		circlebuf_pop_front(&filter->video_frames, NULL, sizeof(struct obs_source_frame *));
+
+		if (os_atomic_dec_long(&frame->refs) <= 0) {
+			obs_source_frame_destroy(frame);
+			frame = NULL;
+		}
+		if (filter->video_frames.size) {
+			circlebuf_peek_front(&filter->video_frames, &frame, sizeof(struct obs_source_frame *));
+			cur_duration = last_timestamp - frame->timestamp;
+		} else {
+			cur_duration = 0;
+		}
+	}
+}
+
+static void replay_filter_drain_audio(struct replay_filter *filter)
+{
+	struct obs_audio_data cached;
+	uint64_t last_timestamp = 0;
+	while (replay_spsc_pop(&filter->audio_queue, &cached)) {
+		circlebuf_push_back(&filter->audio_frames, &cached, sizeof(cached));
+		last_timestamp = cached.timestamp;
+	}
+	if (!last_timestamp)
+		return;
+
+	circlebuf_peek_front(&filter->audio_frames, &cached, sizeof(cached));
+	uint64_t cur_duration = last_timestamp - cached.timestamp;
+	while (filter->audio_frames.size > sizeof(cached) && cur_duration >= filter->duration + MAX_TS_VAR) {
+
+		circlebuf_pop_front(&filter->audio_frames, NULL, sizeof(cached));
+
+		free_audio_packet(&cached);
+		circlebuf_peek_front(&filter->audio_frames, &cached, sizeof(cached));
+		cur_duration = last_timestamp - cached.timestamp;
+	}
+}
+
+// must be called with the filter mutex locked
+void replay_filter_drain(struct replay_filter *filter)
+{
+	replay_filter_drain_video(filter);
+	replay_filter_drain_audio(filter);
+}
+
+// the capture threads only queue, frames are evicted and destroyed by whoever drains
+void replay_filter_push_video(struct replay_filter *filter, struct obs_source_frame *frame)
+{
+	filter->last_video_timestamp = frame->timestamp;
+	replay_spsc_push(&filter->video_queue, &frame);
+}
+
+void replay_filter_push_audio(struct replay_filter *filter, struct obs_audio_data *audio)
+{
+	replay_spsc_push(&filter->audio_queue, audio);
+}
+
+// oldest and newest buffered timestamp, from the video frames or else the audio packets
+bool replay_filter_live_range(struct replay_filter *filter, uint64_t *first, uint64_t *last)
+{
+	bool found = false;
+	pthread_mutex_lock(&filter->mutex);
+	replay_filter_drain(filter);
+	if (filter->video_frames.size) {
+		struct obs_source_frame *frame;
+		circlebuf_peek_front(&filter->video_frames, &frame, sizeof(struct obs_source_frame *));
+		*first = frame->timestamp;
+		circlebuf_peek_back(&filter->video_frames, &frame, sizeof(struct obs_source_frame *));
+		*last = frame->timestamp;
+		found = true;
+	} else if (filter->audio_frames.size) {
 		struct obs_audio_data audio;
+		circlebuf_peek_front(&filter->audio_frames, &audio, sizeof(struct obs_audio_data));
+		*first = audio.timestamp;
+		circlebuf_peek_back(&filter->audio_frames, &audio, sizeof(struct obs_audio_data));
+		*last = audio.timestamp;
+		found = true;
+	}
+	pthread_mutex_unlock(&filter->mutex);
+	return found;
+}
+
+// last buffered frame at or before timestamp, read in place with a reference the caller releases
+struct obs_source_frame *replay_filter_live_frame(struct replay_filter *filter, uint64_t timestamp)
+{
+	struct obs_source_frame *frame = NULL;
+	pthread_mutex_lock(&filter->mutex);
+	const size_t count = filter->video_frames.size / sizeof(struct obs_source_frame *);
+	size_t i = 0;
+	size_t j = count;
+	while (i < j) {
+		const size_t mid = i + (j - i) / 2;
+		struct obs_source_frame *f =
+			*(struct obs_source_frame **)circlebuf_data(&filter->video_frames, mid * sizeof(struct obs_source_frame *));
+		if (f->timestamp <= timestamp)
+			i = mid + 1;
+		else
+			j = mid;
+	}
+	if (count) {
+		frame = *(struct obs_source_frame **)circlebuf_data(&filter->video_frames,
+								    (i ? i - 1 : 0) * sizeof(struct obs_source_frame *));
+		os_atomic_inc_long(&frame->refs);
+	}
+	pthread_mutex_unlock(&filter->mutex);
+	return frame;
+}
+
+// calls callback for every buffered packet from timestamp from up to to, the packets are only valid during the callback
+void replay_filter_live_audio(struct replay_filter *filter, uint64_t from, uint64_t to, replay_live_audio_callback callback,
+			      void *param)
+{
+	pthread_mutex_lock(&filter->mutex);
+	const size_t count = filter->audio_frames.size / sizeof(struct obs_audio_data);
+	size_t i = 0;
+	size_t j = count;
+	while (i < j) {
+		const size_t mid = i + (j - i) / 2;
+		const struct obs_audio_data *audio = circlebuf_data(&filter->audio_frames, mid * sizeof(struct obs_audio_data));
+		if (audio->timestamp < from)
+			i = mid + 1;
+		else
+			j = mid;
+	}
+	for (; i < count; i++) {
+		const struct obs_audio_data *audio = circlebuf_data(&filter->audio_frames, i * sizeof(struct obs_audio_data));
+		if (audio->timestamp >= to)
+			break;
+		callback(param, audio, &filter->oai);
+	}
+	pthread_mutex_unlock(&filter->mutex);
+}
+
+// references the buffered frames newer than the cursor into out, the buffer itself stays shared with other consumers
+void replay_filter_read_video(struct replay_filter *filter, struct replay_filter_cursor *cursor, struct replay_circlebuf *out)
+{
+	pthread_mutex_lock(&filter->mutex);
+	replay_filter_drain(filter);
+	const size_t count = filter->video_frames.size / sizeof(struct obs_source_frame *);
+	size_t i = 0;
+	size_t j = count;
+	while (i < j) {
+		const size_t mid = i + (j - i) / 2;
+		struct obs_source_frame *f =
+			*(struct obs_source_frame **)circlebuf_data(&filter->video_frames, mid * sizeof(struct obs_source_frame *));
+		if (f->timestamp <= cursor->video)
+			i = mid + 1;
+		else
+			j = mid;
+	}
+	for (; i < count; i++) {
+		struct obs_source_frame *frame =
+			*(struct obs_source_frame **)circlebuf_data(&filter->video_frames, i * sizeof(struct obs_source_frame *));
+		os_atomic_inc_long(&frame->refs);
+		circlebuf_push_back(out, &frame, sizeof(struct obs_source_frame *));
+		cursor->video = frame->timestamp;
+	}
+	pthread_mutex_unlock(&filter->mutex);
+}
+
+// references the buffered audio packets newer than the cursor into out, the planes stay shared with other consumers
+void replay_filter_read_audio(struct replay_filter *filter, struct replay_filter_cursor *cursor, struct replay_circlebuf *out,
+			      struct audio_convert_info *oai)
+{
+	pthread_mutex_lock(&filter->mutex);
+	replay_filter_drain(filter);
+	*oai = filter->oai;
+	const size_t count = filter->audio_frames.size / sizeof(struct obs_audio_data);
+	size_t i = 0;
+	size_t j = count;
+	while (i < j) {
+		const size_t mid = i + (j - i) / 2;
+		const struct obs_audio_data *audio = circlebuf_data(&filter->audio_frames, mid * sizeof(struct obs_audio_data));
+		if (audio->timestamp <= cursor->audio)
+			i = mid + 1;
+		else
+			j = mid;
+	}
+	for (; i < count; i++) {
+		const struct obs_audio_data *audio = circlebuf_data(&filter->audio_frames, i * sizeof(struct obs_audio_data));
+		replay_audio_packet_addref(audio);
+		circlebuf_push_back(out, audio, sizeof(*audio));
+		cursor->audio = audio->timestamp;
+	}
+	pthread_mutex_unlock(&filter->mutex);
+}
+
+void free_audio_data(struct replay_filter *filter)
+{
+	struct obs_audio_data audio;
+	while (replay_spsc_pop(&filter->audio_queue, &audio))
+		free_audio_packet(&audio);
 
+	while (filter->audio_frames.size) {
 		circlebuf_pop_front(&filter->audio_frames, &audio, sizeof(struct obs_audio_data));
 		free_audio_packet(&audio);
 	}
@@ -15,9 +300,13 @@ void free_audio_data(struct replay_filter *filter)
 
 void free_video_data(struct replay_filter *filter)
 {
-	while (filter->video_frames.size) {
-		struct obs_source_frame *frame;
+	struct obs_source_frame *frame;
+	while (replay_spsc_pop(&filter->video_queue, &frame)) {
+		if (os_atomic_dec_long(&frame->refs) <= 0)
+			obs_source_frame_destroy(frame);
+	}
 
+	while (filter->video_frames.size) {
 		circlebuf_pop_front(&filter->video_frames, &frame, sizeof(struct obs_source_frame *));
 
 		if (os_atomic_dec_long(&frame->refs) <= 0) {
@@ -25,7 +314,161 @@ void free_video_data(struct replay_filter *filter)
 			frame = NULL;
 		}
 	}
+	filter->last_video_timestamp = 0;
+}
+/* the buffer of a disarmed filter, freed by the release worker so the tick
+ * that disarms does not free every frame */
+struct replay_filter_ring {
+	struct replay_circlebuf video_frames;
+	struct replay_circlebuf audio_frames;
+};
+
+static void replay_filter_ring_free(struct replay_filter_ring *ring)
+{
+	while (ring->video_frames.size) {
+		struct obs_source_frame *frame;
+		circlebuf_pop_front(&ring->video_frames, &frame, sizeof(struct obs_source_frame *));
+		if (os_atomic_dec_long(&frame->refs) <= 0)
+			obs_source_frame_destroy(frame);
+	}
+	while (ring->audio_frames.size) {
+		struct obs_audio_data audio;
+		circlebuf_pop_front(&ring->audio_frames, &audio, sizeof(struct obs_audio_data));
+		free_audio_packet(&audio);
+	}
+	circlebuf_free(&ring->video_frames);
+	circlebuf_free(&ring->audio_frames);
+	bfree(ring);
+}
+
+#define REPLAY_RELEASE_RING 0
+#define REPLAY_RELEASE_VIDEO_OUTPUT 1
+
+struct replay_release_job {
+	int type;
+	void *data;
+};
+
+/* one worker for the whole module frees the buffers of disarmed filters and
+ * closes video outputs, both can take long and are kept off the tick and
+ * the render thread, the mutex guards the jobs */
+static struct {
+	pthread_t thread;
+	os_sem_t *sem;
+	pthread_mutex_t mutex;
+	struct replay_circlebuf jobs;
+	volatile bool stop;
+	bool thread_active;
+} replay_release_worker;
+
+static void replay_release_run(struct replay_release_job *job)
+{
+	if (job->type == REPLAY_RELEASE_RING)
+		replay_filter_ring_free(job->data);
+	else if (job->type == REPLAY_RELEASE_VIDEO_OUTPUT)
+		video_output_close(job->data);
+}
+
+static void *replay_release_thread(void *data)
+{
+	UNUSED_PARAMETER(data);
+	os_set_thread_name("replay_filter: release");
+	while (os_sem_wait(replay_release_worker.sem) == 0) {
+		struct replay_release_job job;
+		bool found = false;
+		pthread_mutex_lock(&replay_release_worker.mutex);
+		if (replay_release_worker.jobs.size) {
+			circlebuf_pop_front(&replay_release_worker.jobs, &job, sizeof(job));
+			found = true;
+		}
+		pthread_mutex_unlock(&replay_release_worker.mutex);
+		if (found)
+			replay_release_run(&job);
+		else if (replay_release_worker.stop)
+			break;
+	}
+	return NULL;
+}
+
+// runs the job on the release worker, or right away when it is not running
+static void replay_release_post(int type, void *data)
+{
+	struct replay_release_job job = {type, data};
+	if (!replay_release_worker.thread_active) {
+		replay_release_run(&job);
+		return;
+	}
+	pthread_mutex_lock(&replay_release_worker.mutex);
+	circlebuf_push_back(&replay_release_worker.jobs, &job, sizeof(job));
+	pthread_mutex_unlock(&replay_release_worker.mutex);
+	os_sem_post(replay_release_worker.sem);
+}
+
+void replay_release_video_output(video_t *video_output)
+{
+	if (video_output)
+		replay_release_post(REPLAY_RELEASE_VIDEO_OUTPUT, video_output);
+}
+
+static void replay_release_worker_start(void)
+{
+	pthread_mutex_init(&replay_release_worker.mutex, NULL);
+	circlebuf_init(&replay_release_worker.jobs);
+	replay_release_worker.stop = false;
+	if (os_sem_init(&replay_release_worker.sem, 0) == 0)
+		replay_release_worker.thread_active =
+			pthread_create(&replay_release_worker.thread, NULL, replay_release_thread, NULL) == 0;
+}
+
+// the queued jobs are finished before the worker stops
+static void replay_release_worker_stop(void)
+{
+	if (replay_release_worker.thread_active) {
+		replay_release_worker.stop = true;
+		os_sem_post(replay_release_worker.sem);
+		pthread_join(replay_release_worker.thread, NULL);
+		replay_release_worker.thread_active = false;
+	}
+	struct replay_release_job job;
+	while (replay_release_worker.jobs.size) {
+		circlebuf_pop_front(&replay_release_worker.jobs, &job, sizeof(job));
+		replay_release_run(&job);
+	}
+	circlebuf_free(&replay_release_worker.jobs);
+	os_sem_destroy(replay_release_worker.sem);
+	replay_release_worker.sem = NULL;
+	pthread_mutex_destroy(&replay_release_worker.mutex);
 }
+
+void replay_filter_defaults(obs_data_t *settings)
+{
+	replay_trigger_defaults(settings);
+	replay_arm_defaults(settings);
+}
+
+/* drains what the capture threads queued since the last tick, checks the
+ * capture policy and hands the buffer of a filter that got disarmed to the
+ * release worker */
+void replay_filter_buffer_tick(struct replay_filter *filter)
+{
+	const bool disarmed =
+		replay_arm_tick(&filter->arm, obs_filter_get_parent(filter->src), obs_source_get_name(filter->src));
+	pthread_mutex_lock(&filter->mutex);
+	replay_filter_drain(filter);
+	if (!disarmed) {
+		pthread_mutex_unlock(&filter->mutex);
+		return;
+	}
+	struct replay_filter_ring *ring = bzalloc(sizeof(struct replay_filter_ring));
+	ring->video_frames = filter->video_frames;
+	ring->audio_frames = filter->audio_frames;
+	circlebuf_init(&filter->video_frames);
+	circlebuf_init(&filter->audio_frames);
+	filter->last_video_timestamp = 0;
+	pthread_mutex_unlock(&filter->mutex);
+	replay_release_post(REPLAY_RELEASE_RING, ring);
+}
+
 static inline uint64_t uint64_diff(uint64_t ts1, uint64_t ts2)
 {
 	return (ts1 < ts2) ? (ts2 - ts1) : (ts1 - ts2);
@@ -36,8 +479,9 @@ EXPORT uint64_t os_gettime_ns(void);
 struct obs_audio_data *replay_filter_audio(void *data, struct obs_audio_data *audio)
 {
 	struct replay_filter *filter = data;
+	if (!filter->arm.armed)
+		return audio;
 	struct obs_audio_data cached = *audio;
-	bool threshold_trigger = !filter->trigger_threshold;
 	if (filter->oai.samples_per_sec == 0 || filter->oai.format != AUDIO_FORMAT_FLOAT_PLANAR) {
 		struct obs_audio_info oai;
 		obs_get_audio_info(&oai);
@@ -46,19 +490,13 @@ struct obs_audio_data *replay_filter_audio(void *data, struct obs_audio_data *au
 		filter->oai.samples_per_sec = oai.samples_per_sec;
 	}
 
+	uint32_t planes = 0;
+	for (size_t i = 0; i < MAX_AV_PLANES && audio->data[i]; i++)
+		planes |= 1u << i;
+	replay_audio_packet_alloc(&cached, planes);
 	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
-		if (!audio->data[i])
-			break;
-
-		cached.data[i] = bmemdup(audio->data[i], audio->frames * sizeof(float));
-
-		for (size_t j = 0; !threshold_trigger && j < audio->frames; j++) {
-			if (fabsf(((float *)audio->data[i])[j]) > filter->threshold)
-				threshold_trigger = true;
-		}
-	}
-	if (filter->trigger_threshold && threshold_trigger) {
-		filter->trigger_threshold(filter->threshold_data);
+		if (cached.data[i])
+			memcpy(cached.data[i], audio->data[i], audio->frames * sizeof(float));
 	}
 	const uint64_t timestamp = cached.timestamp;
 	uint64_t adjusted_time = timestamp + filter->timing_adjust;
@@ -72,22 +510,13 @@ struct obs_audio_data *replay_filter_audio(void *data, struct obs_audio_data *au
 	}
 	cached.timestamp = adjusted_time;
 
-	pthread_mutex_lock(&filter->mutex);
-
-	circlebuf_push_back(&filter->audio_frames, &cached, sizeof(cached));
-
-	circlebuf_peek_front(&filter->audio_frames, &cached, sizeof(cached));
-
-	uint64_t cur_duration = adjusted_time - cached.timestamp;
-	while (filter->audio_frames.size > sizeof(cached) && cur_duration >= filter->duration + MAX_TS_VAR) {
-
-		circlebuf_pop_front(&filter->audio_frames, NULL, sizeof(cached));
+	uint64_t trigger_timestamp;
+	if (filter->trigger_threshold &&
+	    replay_trigger_process(&filter->trigger, audio->data, AUDIO_FORMAT_FLOAT_PLANAR, get_audio_channels(filter->oai.speakers),
+				   audio->frames, filter->oai.samples_per_sec, adjusted_time, &trigger_timestamp))
+		filter->trigger_threshold(filter->threshold_data, trigger_timestamp);
 
-		free_audio_packet(&cached);
-		circlebuf_peek_front(&filter->audio_frames, &cached, sizeof(cached));
-		cur_duration = adjusted_time - cached.timestamp;
-	}
-	pthread_mutex_unlock(&filter->mutex);
+	replay_filter_push_audio(filter, &cached);
 	return audio;
 }
 
@@ -98,21 +527,81 @@ extern struct obs_source_info replay_filter_info;
 extern struct obs_source_info replay_filter_audio_info;
 extern struct obs_source_info replay_filter_async_info;
 extern struct obs_source_info replay_source_info;
+extern struct obs_source_info replay_thumbnails_source_info;
 
 bool obs_module_load(void)
 {
 	blog(LOG_INFO, "[Replay Source] loaded version %s", PROJECT_VERSION);
+	replay_release_worker_start();
+	replay_arm_module_load();
 	obs_register_source(&replay_source_info);
+	obs_register_source(&replay_thumbnails_source_info);
 	obs_register_source(&replay_filter_info);
 	obs_register_source(&replay_filter_audio_info);
 	obs_register_source(&replay_filter_async_info);
 	return true;
 }
 
+void obs_module_unload(void)
+{
+	replay_arm_module_unload();
+	replay_release_worker_stop();
+}
+
+/* the planes of a packet are one allocation, the reference count sits in
+ * front of the first plane */
+#define REPLAY_AUDIO_PACKET_HEADER 16
+
+static inline volatile long *replay_audio_packet_refs(const struct obs_audio_data *audio)
+{
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		if (audio->data[i])
+			return (volatile long *)(audio->data[i] - REPLAY_AUDIO_PACKET_HEADER);
+	}
+	return NULL;
+}
+
+// allocates the planes in the bits of planes for audio->frames samples each, the packet has one reference
+void replay_audio_packet_alloc(struct obs_audio_data *audio, uint32_t planes)
+{
+	replay_audio_packet_alloc_size(audio, planes, audio->frames * sizeof(float));
+}
+
+// same as replay_audio_packet_alloc for planes of plane_size bytes, for audio that is not planar float
+void replay_audio_packet_alloc_size(struct obs_audio_data *audio, uint32_t planes, size_t plane_size)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		if (planes & (1u << i))
+			count++;
+	}
+	memset(audio->data, 0, sizeof(audio->data));
+	if (!count)
+		return;
+	uint8_t *block = bmalloc(REPLAY_AUDIO_PACKET_HEADER + count * plane_size);
+	*(volatile long *)block = 1;
+	uint8_t *plane = block + REPLAY_AUDIO_PACKET_HEADER;
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		if (planes & (1u << i)) {
+			audio->data[i] = plane;
+			plane += plane_size;
+		}
+	}
+}
+
+void replay_audio_packet_addref(const struct obs_audio_data *audio)
+{
+	volatile long *refs = replay_audio_packet_refs(audio);
+	if (refs)
+		os_atomic_inc_long(refs);
+}
+
+// releases the reference of audio to its planes and clears it
 void free_audio_packet(struct obs_audio_data *audio)
 {
-	for (size_t i = 0; i < MAX_AV_PLANES; i++)
-		bfree(audio->data[i]);
+	volatile long *refs = replay_audio_packet_refs(audio);
+	if (refs && os_atomic_dec_long(refs) == 0)
+		bfree((void *)refs);
 	memset(audio, 0, sizeof(*audio));
 }
 
@@ -131,13 +620,30 @@ const char *obs_module_author(void)
 	return "Exeldro";
 }
 
+// the replay source the filter belongs to, found by name once and then followed through a weak reference so renames keep it
+obs_source_t *replay_filter_owner(struct replay_filter *filter)
+{
+	if (filter->owner) {
+		obs_source_t *s = obs_weak_source_get_source(filter->owner);
+		if (s && obs_source_removed(s)) {
+			obs_source_release(s);
+			return NULL;
+		}
+		return s;
+	}
+	obs_source_t *s = obs_get_source_by_name(obs_source_get_name(filter->src));
+	if (s)
+		filter->owner = obs_source_get_weak_source(s);
+	return s;
+}
+
 void replay_filter_check(void *data)
 {
 	struct replay_filter *filter = data;
 	if (filter->last_check && filter->last_check + 3 * SEC_TO_NSEC > obs_get_video_frame_time())
 		return;
 	filter->last_check = obs_get_video_frame_time();
-	obs_source_t *s = obs_get_source_by_name(obs_source_get_name(filter->src));
+	obs_source_t *s = replay_filter_owner(filter);
 	if (s) {
 		if (!filter->trigger_threshold) {
 			obs_data_t *settings = obs_source_get_settings(s);
@@ -1,6 +1,9 @@
 #pragma once
 #include <obs-module.h>
 #include <util/threading.h>
+#include <util/dstr.h>
+#include <media-io/video-scaler.h>
+#include <stdio.h>
 
 #if LIBOBS_API_VER >= MAKE_SEMANTIC_VERSION(30, 1, 0)
 #include <util/deque.h>
@@ -17,10 +20,144 @@
 #include <util/circlebuf.h>
 #endif
 
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+static inline void *replay_atomic_load_ptr(void *volatile *ptr)
+{
+#ifdef _MSC_VER
+	return _InterlockedCompareExchangePointer(ptr, NULL, NULL);
+#else
+	return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline void *replay_atomic_exchange_ptr(void *volatile *ptr, void *val)
+{
+#ifdef _MSC_VER
+	return _InterlockedExchangePointer(ptr, val);
+#else
+	return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST);
+#endif
+}
+
+/* libobs only has atomics for long and bool, timestamps shared between
+ * threads need 64 bits */
+static inline uint64_t replay_atomic_load_u64(const volatile uint64_t *ptr)
+{
+#ifdef _MSC_VER
+	return (uint64_t)_InterlockedCompareExchange64((volatile __int64 *)ptr, 0, 0);
+#else
+	return __atomic_load_n(ptr, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline void replay_atomic_set_u64(volatile uint64_t *ptr, uint64_t val)
+{
+#ifdef _MSC_VER
+	_InterlockedExchange64((volatile __int64 *)ptr, (__int64)val);
+#else
+	__atomic_store_n(ptr, val, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline bool replay_atomic_compare_swap_u64(volatile uint64_t *ptr, uint64_t expected, uint64_t val)
+{
+#ifdef _MSC_VER
+	return (uint64_t)_InterlockedCompareExchange64((volatile __int64 *)ptr, (__int64)val, (__int64)expected) == expected;
+#else
+	return __atomic_compare_exchange_n(ptr, &expected, val, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+#if LIBOBS_API_VER >= MAKE_SEMANTIC_VERSION(30, 1, 0)
+#define replay_circlebuf deque
+#else
+#define replay_circlebuf circlebuf
+#endif
+
+/* a block of a replay_spsc, the items follow the block in memory */
+struct replay_spsc_block {
+	struct replay_spsc_block *volatile next;
+	long head;
+	volatile long tail;
+};
+
+/* wait-free single producer single consumer queue of fixed size items in a
+ * chain of blocks, a full block gets another one linked after it so a push
+ * never fails, the consumer hands the block it finished back as spare so a
+ * steady stream does not allocate, the consumer side must be serialized by
+ * the owner of the queue */
+struct replay_spsc {
+	struct replay_spsc_block *write;
+	struct replay_spsc_block *read;
+	struct replay_spsc_block *volatile spare;
+	size_t item_size;
+	long block_size;
+	volatile long blocks_allocated;
+};
+
+#define REPLAY_VIDEO_QUEUE_SIZE 256
+#define REPLAY_AUDIO_QUEUE_SIZE 512
+
+#define TRIGGER_MODE_PEAK 0
+#define TRIGGER_MODE_RMS 1
+
+/* windowed level detector, fires once the level stays above the attack
+ * threshold for the minimum duration and rearms below the release level */
+struct replay_trigger {
+	float attack;
+	float release;
+	int mode;
+	int64_t window_ms;
+	uint64_t min_duration;
+
+	uint32_t window_fill;
+	float window_peak;
+	double window_energy[MAX_AV_PLANES];
+	uint64_t window_cross;
+	uint64_t onset;
+	bool triggered;
+
+	size_t channels;
+	uint64_t samples;
+	uint64_t process_ns;
+};
+
+#define CAPTURE_POLICY_ALWAYS 0
+#define CAPTURE_POLICY_PARENT_ACTIVE 1
+#define CAPTURE_POLICY_SCENE 2
+#define CAPTURE_POLICY_SCHEDULE 3
+#define REPLAY_ARM_MAX_WINDOWS 16
+#define REPLAY_ARM_CHECK_INTERVAL (100 * 1000000ULL)
+
+/* whether a replay filter captures, the policy is checked from the filter
+ * tick and capture stops disarm_delay after the policy last wanted it, the
+ * schedule windows are minutes since local midnight and wrap past it when
+ * to is before from, the mutex guards everything but armed */
+struct replay_arm {
+	pthread_mutex_t mutex;
+	int policy;
+	char *scene_name;
+	int window_from[REPLAY_ARM_MAX_WINDOWS];
+	int window_to[REPLAY_ARM_MAX_WINDOWS];
+	size_t window_count;
+	uint64_t disarm_delay;
+	uint64_t wanted_timestamp;
+	uint64_t check_timestamp;
+	volatile bool armed;
+
+	uint64_t created;
+	uint64_t armed_since;
+	uint64_t armed_ns;
+	uint64_t disarm_count;
+};
+
 struct replay_filter {
 
 #if LIBOBS_API_VER >= MAKE_SEMANTIC_VERSION(30, 1, 0)
@@ -37,6 +174,12 @@ struct replay_filter {
 	struct circlebuf audio_frames;
 #endif
 
+	/* capture threads only push into these, the filter tick and readers
+	 * drain them into the frames above with the mutex held */
+	struct replay_spsc video_queue;
+	struct replay_spsc audio_queue;
+	uint64_t last_video_timestamp;
+
 	struct obs_video_info ovi;
 	struct audio_convert_info oai;
 
@@ -55,18 +198,337 @@ struct replay_filter {
 	pthread_mutex_t mutex;
 	int64_t timing_adjust;
 	bool internal_frames;
-	float threshold;
-	void (*trigger_threshold)(void *data);
+	struct replay_trigger trigger;
+	struct replay_arm arm;
+	void (*trigger_threshold)(void *data, uint64_t timestamp);
 	void *threshold_data;
 	uint64_t last_check;
 	size_t target_offset;
+	/* the replay source named like the filter when it was first checked */
+	obs_weak_source_t *owner;
 };
 
+/* read position of one consumer of a shared replay filter, the timestamps
+ * of the newest video frame and audio packet it has retrieved */
+struct replay_filter_cursor {
+	uint64_t video;
+	uint64_t audio;
+};
+
+/* pitch preserving time-stretch of planar float audio */
+struct replay_stretch {
+	size_t channels;
+	uint32_t sample_rate;
+	size_t frame;
+	size_t hop;
+	size_t search;
+	float *window;
+	float *input[MAX_AV_PLANES];
+	float *mix;
+	size_t input_size;
+	size_t input_capacity;
+	double input_pos;
+	size_t previous;
+	uint64_t consumed;
+	float *overlap[MAX_AV_PLANES];
+	double speed;
+	bool first;
+
+	uint64_t frames_out;
+	uint64_t process_ns;
+};
+
+#define REPLAY_RAMP_MAX_POINTS 32
+#define REPLAY_RAMP_STEP (10 * 1000000LL)
+
+/* speed ramp points as set in the source settings */
+struct replay_speed_ramp {
+	size_t count;
+	int64_t time[REPLAY_RAMP_MAX_POINTS];
+	bool from_end[REPLAY_RAMP_MAX_POINTS];
+	double speed[REPLAY_RAMP_MAX_POINTS];
+};
+
+/* piecewise linear map between source offset and output time of a replay,
+ * speed is the source time per output time of the segment from each knot,
+ * an empty map is the identity */
+struct replay_time_map {
+	size_t count;
+	int64_t *source;
+	int64_t *output;
+	double *speed;
+};
+
+#define REPLAY_PACING_PLAN 32
+#define REPLAY_PACING_WINDOW 16
+#define REPLAY_PACING_DEAD_BAND 0.25
+
+/* presentation error of successive frames, jitter is its change per frame */
+struct replay_pacing_track {
+	bool active;
+	uint64_t frame;
+	int64_t error;
+	uint64_t frames;
+	uint64_t skipped;
+	double jitter_sum;
+	int64_t jitter_max;
+};
+
+/* source frame per render tick planned REPLAY_PACING_PLAN ticks ahead, the
+ * plan is dropped when the replay, speed or start of playback changes */
+struct replay_pacing {
+	const uint64_t *timestamps;
+	uint64_t count;
+	float speed_percent;
+	uint64_t start_timestamp;
+	uint64_t interval;
+	uint64_t plan_start;
+	uint64_t next_tick;
+	size_t planned;
+	uint64_t plan[REPLAY_PACING_PLAN];
+	double phase;
+	bool anchored;
+
+	struct replay_pacing_track paced;
+	struct replay_pacing_track unpaced;
+};
+
+#define REPLAY_TEXT_LITERAL 0
+#define REPLAY_TEXT_SPEED 1
+#define REPLAY_TEXT_PROGRESS 2
+#define REPLAY_TEXT_COUNT 3
+#define REPLAY_TEXT_INDEX 4
+#define REPLAY_TEXT_DURATION 5
+#define REPLAY_TEXT_TIME 6
+#define REPLAY_TEXT_FPS 7
+
+/* literal run of the format or a token to replace with its value */
+struct replay_text_token {
+	int token;
+	size_t offset;
+	size_t length;
+};
+
+/* compiled text overlay format, used has a bit per token type present */
+struct replay_text_template {
+	char *format;
+	struct replay_text_token *tokens;
+	size_t count;
+	uint32_t used;
+};
+
+struct replay_text_values {
+	double speed;
+	bool has_progress;
+	double progress;
+	int count;
+	int index;
+	bool has_duration;
+	double duration;
+	bool has_time;
+	double time;
+	int fps;
+};
+
+#define INTERP_MODE_NONE 0
+#define INTERP_MODE_BLEND 1
+#define INTERP_MODE_MOTION 2
+#define REPLAY_INTERP_MAX_STEPS 8
+#define REPLAY_INTERP_PAIRS 6
+#define REPLAY_INTERP_LOOKAHEAD 3
+#define REPLAY_INTERP_MAX_THREADS 8
+
+/* frames synthesized between two stored frames at step / steps */
+struct replay_interp_pair {
+	struct obs_source_frame *from;
+	struct obs_source_frame *to;
+	uint32_t steps;
+	int mode;
+	int state;
+	struct obs_source_frame *frames[REPLAY_INTERP_MAX_STEPS];
+};
+
+/* slow motion frame synthesis ahead of the playhead on a pool of worker
+ * threads, pairs are only evicted by the thread that prefetches so frames
+ * returned by replay_interp_get stay valid until the next prefetch */
+struct replay_interp {
+	int mode;
+	pthread_mutex_t mutex;
+	os_sem_t *jobs;
+	pthread_t threads[REPLAY_INTERP_MAX_THREADS];
+	size_t thread_count;
+	volatile bool stop;
+	struct replay_interp_pair pairs[REPLAY_INTERP_PAIRS];
+
+	uint64_t frames_synthesized;
+	uint64_t synthesize_ns;
+	uint64_t hits;
+	uint64_t misses;
+};
+
+struct replay;
+
+/* downscaled BGRA thumbnails of a replay side by side in one strip, made
+ * once on the thumbnail thread and shared by reference afterwards */
+struct replay_thumbnails {
+	volatile long refs;
+	uint32_t width;
+	uint32_t height;
+	uint32_t count;
+	uint32_t linesize;
+	uint8_t *data;
+	/* changes with every strip so a viewer only copies new ones */
+	long long serial;
+};
+
+/* the scaler is kept between strips and only recreated when the frames
+ * have another format or size than the previous ones */
+struct replay_thumbnail_scaler {
+	video_scaler_t *scaler;
+	struct video_scale_info from;
+	struct video_scale_info to;
+};
+
+/* a replay in the library with its metadata, the id stays the same while
+ * other replays are added or removed, the pointer only until the next add */
+struct replay_library_entry {
+	uint64_t id;
+	struct replay *replay;
+	char *source_name;
+	uint64_t capture_time;
+	char *tags;
+	/* a reference to the thumbnails, NULL until the thumbnail thread made them */
+	struct replay_thumbnails *thumbnails;
+	/* file the replay is spilled to, replay is NULL while it is only on
+	 * disk and the length stays listed here, the trims are always those
+	 * of the last published replay of the entry */
+	char *spill_path;
+	bool spilling;
+	bool paging_in;
+	uint64_t last_used;
+	uint64_t duration;
+	int64_t trim_front;
+	int64_t trim_end;
+	uint32_t generation;
+	uint32_t next_free;
+};
+
+/* replays in the order they were added, entries live in reused slots and
+ * the order is a window of slot indices, so access by position or id and
+ * adding or removing at either end are constant time */
+struct replay_library {
+	struct replay_library_entry *entries;
+	uint32_t capacity;
+	uint32_t free_slot;
+	uint32_t *order;
+	size_t first;
+	size_t count;
+	size_t order_capacity;
+};
+
+static inline size_t replay_library_count(const struct replay_library *library)
+{
+	return library->count;
+}
+
+void replay_spsc_init(struct replay_spsc *queue, size_t item_size, long block_size);
+void replay_spsc_free(struct replay_spsc *queue);
+void replay_spsc_push(struct replay_spsc *queue, const void *item);
+bool replay_spsc_pop(struct replay_spsc *queue, void *item);
+void replay_filter_init_queues(struct replay_filter *filter);
+void replay_filter_free_queues(struct replay_filter *filter);
+void replay_filter_push_video(struct replay_filter *filter, struct obs_source_frame *frame);
+void replay_filter_push_audio(struct replay_filter *filter, struct obs_audio_data *audio);
+void replay_filter_drain(struct replay_filter *filter);
+typedef void (*replay_live_audio_callback)(void *param, const struct obs_audio_data *audio,
+					   const struct audio_convert_info *oai);
+bool replay_filter_live_range(struct replay_filter *filter, uint64_t *first, uint64_t *last);
+struct obs_source_frame *replay_filter_live_frame(struct replay_filter *filter, uint64_t timestamp);
+void replay_filter_live_audio(struct replay_filter *filter, uint64_t from, uint64_t to, replay_live_audio_callback callback,
+			      void *param);
+void replay_filter_read_video(struct replay_filter *filter, struct replay_filter_cursor *cursor, struct replay_circlebuf *out);
+void replay_filter_read_audio(struct replay_filter *filter, struct replay_filter_cursor *cursor, struct replay_circlebuf *out,
+			      struct audio_convert_info *oai);
+void replay_audio_packet_alloc(struct obs_audio_data *audio, uint32_t planes);
+void replay_audio_packet_alloc_size(struct obs_audio_data *audio, uint32_t planes, size_t plane_size);
+void replay_audio_packet_addref(const struct obs_audio_data *audio);
 void free_audio_packet(struct obs_audio_data *audio);
 struct obs_audio_data *replay_filter_audio(void *data, struct obs_audio_data *audio);
 void free_video_data(struct replay_filter *filter);
 void free_audio_data(struct replay_filter *filter);
-void replay_trigger_threshold(void *data);
+void replay_trigger_threshold(void *data, uint64_t timestamp);
+void replay_stretch_init(struct replay_stretch *stretch, size_t channels, uint32_t sample_rate);
+void replay_stretch_free(struct replay_stretch *stretch);
+void replay_stretch_reset(struct replay_stretch *stretch);
+void replay_stretch_set_speed(struct replay_stretch *stretch, double speed);
+size_t replay_stretch_needed(const struct replay_stretch *stretch);
+void replay_stretch_push(struct replay_stretch *stretch, float *const *data, size_t frames);
+size_t replay_stretch_process(struct replay_stretch *stretch, float **out);
+double replay_stretch_position(const struct replay_stretch *stretch);
+void replay_stretch_log_stats(struct replay_stretch *stretch, const char *name);
+void replay_speed_ramp_parse(struct replay_speed_ramp *ramp, const char *text);
+void replay_time_map_build(struct replay_time_map *map, const struct replay_speed_ramp *ramp, uint64_t duration);
+void replay_time_map_slice(struct replay_time_map *map, const struct replay_time_map *from, int64_t offset);
+void replay_time_map_free(struct replay_time_map *map);
+int64_t replay_time_map_output(const struct replay_time_map *map, int64_t source);
+int64_t replay_time_map_source(const struct replay_time_map *map, int64_t output);
+double replay_time_map_speed(const struct replay_time_map *map, int64_t source);
+void replay_pacing_reset(struct replay_pacing *pacing);
+uint64_t replay_pacing_frame(struct replay_pacing *pacing, const uint64_t *timestamps, uint64_t count,
+			     const struct replay_time_map *map, float speed_percent, uint64_t start_timestamp,
+			     uint64_t tick_timestamp);
+void replay_pacing_track(struct replay_pacing_track *track, uint64_t frame, uint64_t presented, uint64_t ideal);
+void replay_pacing_log_stats(struct replay_pacing *pacing, const char *name);
+void replay_interp_init(struct replay_interp *interp);
+void replay_interp_free(struct replay_interp *interp);
+void replay_interp_set_mode(struct replay_interp *interp, int mode);
+void replay_interp_prefetch(struct replay_interp *interp, struct obs_source_frame **frames, uint64_t count, uint64_t index,
+			    uint32_t steps);
+struct obs_source_frame *replay_interp_get(struct replay_interp *interp, struct obs_source_frame *from,
+					   struct obs_source_frame *to, uint32_t steps, uint32_t step);
+void replay_interp_log_stats(struct replay_interp *interp, const char *name);
+void replay_text_compile(struct replay_text_template *tmpl, const char *format);
+void replay_text_free(struct replay_text_template *tmpl);
+void replay_text_render(const struct replay_text_template *tmpl, const struct replay_text_values *values, struct dstr *out);
+void replay_library_init(struct replay_library *library);
+void replay_library_free(struct replay_library *library);
+struct replay_library_entry *replay_library_add(struct replay_library *library, struct replay *replay, const char *source_name,
+						 uint64_t capture_time);
+struct replay *replay_library_remove(struct replay_library *library, size_t position);
+struct replay_library_entry *replay_library_at(struct replay_library *library, size_t position);
+struct replay_library_entry *replay_library_find(struct replay_library *library, uint64_t id);
+size_t replay_library_position(const struct replay_library *library, uint64_t id);
+void replay_library_set_tags(struct replay_library_entry *entry, const char *tags);
+bool replay_spill_write(FILE *file, const void *data, size_t size);
+bool replay_spill_read(FILE *file, void *data, size_t size);
+bool replay_spill_write_video(FILE *file, struct obs_source_frame *const *frames, uint64_t count);
+uint64_t replay_spill_read_video(FILE *file, struct obs_source_frame **frames, uint64_t count);
+bool replay_spill_write_audio(FILE *file, const struct obs_audio_data *audio, uint64_t count);
+uint64_t replay_spill_read_audio(FILE *file, struct obs_audio_data *audio, uint64_t count);
+struct replay_thumbnails *replay_thumbnails_create(struct replay_thumbnail_scaler *scaler, struct obs_source_frame *const *frames,
+						   uint32_t count, uint32_t width);
+void replay_thumbnails_addref(struct replay_thumbnails *thumbnails);
+void replay_thumbnails_release(struct replay_thumbnails *thumbnails);
+void replay_thumbnail_scaler_free(struct replay_thumbnail_scaler *scaler);
+void replay_trigger_defaults(obs_data_t *settings);
+void replay_trigger_properties(obs_properties_t *props);
+void replay_trigger_update(struct replay_trigger *trigger, obs_data_t *settings);
+bool replay_trigger_process(struct replay_trigger *trigger, uint8_t *const *data, enum audio_format format, size_t channels,
+			    uint32_t frames, uint32_t sample_rate, uint64_t timestamp, uint64_t *trigger_timestamp);
+void replay_trigger_log_stats(struct replay_trigger *trigger, const char *name);
+void replay_arm_init(struct replay_arm *arm);
+void replay_arm_free(struct replay_arm *arm);
+void replay_arm_defaults(obs_data_t *settings);
+void replay_arm_properties(obs_properties_t *props);
+void replay_arm_update(struct replay_arm *arm, obs_data_t *settings);
+bool replay_arm_tick(struct replay_arm *arm, obs_source_t *parent, const char *name);
+void replay_arm_log_stats(struct replay_arm *arm, const char *name);
+void replay_arm_module_load(void);
+void replay_arm_module_unload(void);
+void replay_filter_defaults(obs_data_t *settings);
+void replay_filter_buffer_tick(struct replay_filter *filter);
+void replay_release_video_output(video_t *video_output);
+obs_source_t *replay_filter_owner(struct replay_filter *filter);
 void replay_filter_check(void *data);
 
 #define REPLAY_FILTER_ID "replay_filter"
@@ -75,6 +537,8 @@ void replay_filter_check(void *data);
 #define REPLAY_FILTER_ASYNC_ID "replay_filter_async"
 //#define TEXT_FILTER_ASYNC_NAME "Replay filter async"
 #define REPLAY_SOURCE_ID "replay_source"
+#define REPLAY_THUMBNAILS_ID "replay_thumbnails"
+#define REPLAY_THUMBNAIL_WIDTH 160
 #define SETTING_DURATION "duration"
 #define SETTING_DURATION_MIN 1
 #define SETTING_DURATION_MAX 200000
@@ -87,6 +551,17 @@ void replay_filter_check(void *data);
 #define SETTING_SPEED_MIN 0.01f
 #define SETTING_SPEED_MAX 400.0f
 #define SETTING_BACKWARD "backward"
+#define SETTING_PRESERVE_PITCH "preserve_pitch"
+#define SETTING_SPEED_RAMP "speed_ramp"
+#define SETTING_INTERPOLATION "interpolation"
+#define SETTING_FRAME_PACING "frame_pacing"
+#define SETTING_LIVE "live"
+#define SETTING_LIVE_DELAY "live_delay"
+#define SETTING_LIVE_DELAY_MIN 0
+#define SETTING_LIVE_DELAY_MAX 200000
+#define SETTING_LIVE_CATCH_UP "live_catch_up"
+#define SETTING_LIVE_CATCH_UP_MIN 100.0
+#define SETTING_LIVE_CATCH_UP_MAX SETTING_SPEED_MAX
 #define SETTING_VISIBILITY_ACTION "visibility_action"
 #define SETTING_START_DELAY "start_delay"
 #define SETTING_FRAME_STEP_COUNT "frame_step_count"
@@ -95,10 +570,21 @@ void replay_filter_check(void *data);
 #define SETTING_SOURCE "source"
 //#define TEXT_SOURCE "Video source"
 #define SETTING_SOURCE_AUDIO "source_audio"
+#define SETTING_ANGLE_SOURCES "angle_sources"
+#define SETTING_SHARED_FILTER "shared_filter"
 //#define TEXT_SOURCE_AUDIO "Audio source"
 #define SETTING_NEXT_SCENE "next_scene"
 //#define TEXT_NEXT_SCENE "Next scene"
 #define SETTING_DIRECTORY "directory"
+#define SETTING_SPILL_DIRECTORY "spill_directory"
+#define SETTING_SPILL_REPLAYS "spill_replays"
+#define SETTING_THUMBNAILS "thumbnails"
+#define SETTING_THUMBNAILS_MAX 32
+#define SETTING_CAPTURE_POLICY "capture_policy"
+#define SETTING_CAPTURE_SCENE "capture_scene"
+#define SETTING_CAPTURE_SCHEDULE "capture_schedule"
+#define SETTING_CAPTURE_DISARM_DELAY "capture_disarm_delay"
+#define SETTING_CAPTURE_DISARM_DELAY_MAX 3600000
 #define SETTING_FILE_FORMAT "file_format"
 #define SETTING_LOSSLESS "lossless"
 #define SETTING_PROGRESS_SOURCE "progress_source"
@@ -109,6 +595,16 @@ void replay_filter_check(void *data);
 #define SETTING_AUDIO_THRESHOLD "threshold"
 #define SETTING_AUDIO_THRESHOLD_MIN -60.0
 #define SETTING_AUDIO_THRESHOLD_MAX 0.0f
+#define SETTING_TRIGGER_MODE "trigger_mode"
+#define SETTING_TRIGGER_WINDOW "trigger_window"
+#define SETTING_TRIGGER_WINDOW_MIN 1
+#define SETTING_TRIGGER_WINDOW_MAX 1000
+#define SETTING_TRIGGER_HYSTERESIS "trigger_hysteresis"
+#define SETTING_TRIGGER_HYSTERESIS_MIN 0.0
+#define SETTING_TRIGGER_HYSTERESIS_MAX 30.0
+#define SETTING_TRIGGER_MIN_DURATION "trigger_min_duration"
+#define SETTING_TRIGGER_MIN_DURATION_MIN 0
+#define SETTING_TRIGGER_MIN_DURATION_MAX 5000
 #define SETTING_LOAD_SWITCH_SCENE "load_switch_scene"
 #define SETTING_EXECUTE_ACTION "execute_action"
 
@@ -0,0 +1,143 @@
+#include <obs-module.h>
+#include <util/platform.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../replay.h"
+
+/* latency of the two ways to control a replay source, the same action is
+ * issued through the execute_action setting with obs_source_update and
+ * through the action procedure of the control api. A video source applies
+ * new settings on the next video tick, so the setting path is timed until
+ * the update signal of the source, the procedure runs on the calling thread.
+ * The plugin is loaded from the built module so the measured paths are the
+ * ones OBS runs, the video pipeline needs a graphics module */
+
+#define BENCH_SETTING_CALLS 600
+#define BENCH_PROC_CALLS 20000
+#define BENCH_WARMUP 10
+#define BENCH_ACTION "NormalSpeed"
+
+#ifndef REPLAY_SOURCE_MODULE_PATH
+#define REPLAY_SOURCE_MODULE_PATH "replay-source"
+#endif
+#ifndef REPLAY_SOURCE_DATA_PATH
+#define REPLAY_SOURCE_DATA_PATH "data"
+#endif
+#ifndef REPLAY_SOURCE_GRAPHICS_MODULE
+#ifdef _WIN32
+#define REPLAY_SOURCE_GRAPHICS_MODULE "libobs-d3d11"
+#else
+#define REPLAY_SOURCE_GRAPHICS_MODULE "libobs-opengl"
+#endif
+#endif
+
+static volatile bool bench_updated = false;
+
+static void bench_update_signal(void *data, calldata_t *cd)
+{
+	UNUSED_PARAMETER(data);
+	UNUSED_PARAMETER(cd);
+	os_atomic_set_bool(&bench_updated, true);
+}
+
+static uint64_t bench_setting_call(obs_source_t *source)
+{
+	os_atomic_set_bool(&bench_updated, false);
+	const uint64_t start = os_gettime_ns();
+	obs_data_t *settings = obs_data_create();
+	obs_data_set_string(settings, SETTING_EXECUTE_ACTION, BENCH_ACTION);
+	obs_source_update(source, settings);
+	obs_data_release(settings);
+	while (!os_atomic_load_bool(&bench_updated))
+		os_sleep_ms(0);
+	return os_gettime_ns() - start;
+}
+
+static uint64_t bench_proc_call(obs_source_t *source)
+{
+	const uint64_t start = os_gettime_ns();
+	uint8_t stack[128];
+	calldata_t cd;
+	calldata_init_fixed(&cd, stack, sizeof(stack));
+	calldata_set_string(&cd, "action", BENCH_ACTION);
+	proc_handler_call(obs_source_get_proc_handler(source), "action", &cd);
+	return os_gettime_ns() - start;
+}
+
+static int bench_compare(const void *a, const void *b)
+{
+	const uint64_t x = *(const uint64_t *)a;
+	const uint64_t y = *(const uint64_t *)b;
+	return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static double bench_run(obs_source_t *source, uint64_t (*call)(obs_source_t *), int calls, const char *name)
+{
+	for (int i = 0; i < BENCH_WARMUP; i++)
+		call(source);
+	uint64_t *ns = bmalloc(calls * sizeof(uint64_t));
+	uint64_t total = 0;
+	for (int i = 0; i < calls; i++) {
+		ns[i] = call(source);
+		total += ns[i];
+	}
+	qsort(ns, calls, sizeof(uint64_t), bench_compare);
+	const double mean = (double)total / calls / 1000.0;
+	printf("%-22s %6d calls, mean %9.3f us, median %9.3f us, p99 %9.3f us, max %9.3f us\n", name, calls, mean,
+	       (double)ns[calls / 2] / 1000.0, (double)ns[calls * 99 / 100] / 1000.0, (double)ns[calls - 1] / 1000.0);
+	bfree(ns);
+	return mean;
+}
+
+int main(int argc, char **argv)
+{
+	const char *module_path = argc > 1 ? argv[1] : REPLAY_SOURCE_MODULE_PATH;
+	const char *data_path = argc > 2 ? argv[2] : REPLAY_SOURCE_DATA_PATH;
+	if (!obs_startup("en-US", NULL, NULL)) {
+		fprintf(stderr, "could not start libobs\n");
+		return 1;
+	}
+	struct obs_video_info ovi = {0};
+	ovi.graphics_module = REPLAY_SOURCE_GRAPHICS_MODULE;
+	ovi.fps_num = 60;
+	ovi.fps_den = 1;
+	ovi.base_width = ovi.output_width = 640;
+	ovi.base_height = ovi.output_height = 360;
+	ovi.output_format = VIDEO_FORMAT_NV12;
+	ovi.colorspace = VIDEO_CS_709;
+	ovi.range = VIDEO_RANGE_PARTIAL;
+	ovi.scale_type = OBS_SCALE_BILINEAR;
+	ovi.gpu_conversion = true;
+	if (obs_reset_video(&ovi) != OBS_VIDEO_SUCCESS) {
+		fprintf(stderr, "could not start video with '%s'\n", ovi.graphics_module);
+		obs_shutdown();
+		return 1;
+	}
+	obs_module_t *module = NULL;
+	if (obs_open_module(&module, module_path, data_path) != MODULE_SUCCESS || !obs_init_module(module)) {
+		fprintf(stderr, "could not load '%s'\n", module_path);
+		obs_shutdown();
+		return 1;
+	}
+	obs_source_t *source = obs_source_create(REPLAY_SOURCE_ID, "replay-control-bench", NULL, NULL);
+	if (!source) {
+		fprintf(stderr, "could not create a replay source\n");
+		obs_shutdown();
+		return 1;
+	}
+	signal_handler_connect(obs_source_get_signal_handler(source), "update", bench_update_signal, NULL);
+
+	printf("the %s action at %d fps video\n", BENCH_ACTION, (int)(ovi.fps_num / ovi.fps_den));
+	const double setting = bench_run(source, bench_setting_call, BENCH_SETTING_CALLS, "execute_action setting");
+	const double proc = bench_run(source, bench_proc_call, BENCH_PROC_CALLS, "action procedure");
+	if (proc > 0.0)
+		printf("the setting path takes %.0fx as long as the procedure\n", setting / proc);
+
+	signal_handler_disconnect(obs_source_get_signal_handler(source), "update", bench_update_signal, NULL);
+	// the source logs the time its update callback spent on execute_action when it is destroyed
+	obs_source_remove(source);
+	obs_source_release(source);
+	obs_shutdown();
+	return 0;
+}
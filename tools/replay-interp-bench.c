@@ -0,0 +1,105 @@
+#include <obs-module.h>
+#include <util/platform.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "../replay.h"
+
+/* throughput of the slow motion frame synthesis at 1080p, a ring of frames
+ * with a moving pattern is played through the interpolation worker pool the
+ * way the replay source does at 4x slowdown: the pairs ahead of the playhead
+ * are prefetched and the playhead only moves on once every synthesized frame
+ * of its pair is ready. At 4x slowdown of 60 fps playback 3 of every 4 output
+ * frames are synthesized, so realtime needs 45 synthesized frames/s */
+
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_FRAMES 16
+#define BENCH_PAIRS 240
+#define BENCH_STEPS 4
+#define BENCH_OUTPUT_FPS 60
+
+// pattern moving right and down by a few pixels a frame so the motion search has work to do
+static uint8_t bench_pattern(uint32_t x, uint32_t y, uint32_t index, uint32_t channel)
+{
+	const uint32_t mx = x - index * 6;
+	const uint32_t my = y - index * 3;
+	return (uint8_t)(((mx >> 3) ^ (my >> 3)) * 37 + ((mx * 5 + my * 3) & 0x3f) + channel * 64);
+}
+
+static struct obs_source_frame *bench_frame(enum video_format format, uint32_t index)
+{
+	struct obs_source_frame *frame = obs_source_frame_create(format, BENCH_WIDTH, BENCH_HEIGHT);
+	frame->refs = 1;
+	frame->timestamp = (uint64_t)index * 1000000000ULL / BENCH_OUTPUT_FPS;
+	frame->full_range = true;
+	if (format == VIDEO_FORMAT_BGRA) {
+		for (uint32_t y = 0; y < BENCH_HEIGHT; y++) {
+			uint8_t *row = frame->data[0] + (size_t)y * frame->linesize[0];
+			for (uint32_t x = 0; x < BENCH_WIDTH; x++) {
+				for (uint32_t c = 0; c < 3; c++)
+					row[x * 4 + c] = bench_pattern(x, y, index, c);
+				row[x * 4 + 3] = 255;
+			}
+		}
+	} else {
+		for (uint32_t y = 0; y < BENCH_HEIGHT; y++) {
+			uint8_t *row = frame->data[0] + (size_t)y * frame->linesize[0];
+			for (uint32_t x = 0; x < BENCH_WIDTH; x++)
+				row[x] = bench_pattern(x, y, index, 0);
+		}
+		for (uint32_t y = 0; y < BENCH_HEIGHT / 2; y++) {
+			uint8_t *row = frame->data[1] + (size_t)y * frame->linesize[1];
+			for (uint32_t x = 0; x < BENCH_WIDTH / 2; x++) {
+				row[x * 2] = bench_pattern(x * 2, y * 2, index, 1);
+				row[x * 2 + 1] = bench_pattern(x * 2, y * 2, index, 2);
+			}
+		}
+	}
+	return frame;
+}
+
+static void bench_run(enum video_format format, const char *format_name, int mode)
+{
+	struct obs_source_frame *frames[BENCH_FRAMES];
+	for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+		frames[i] = bench_frame(format, i);
+
+	struct replay_interp interp;
+	replay_interp_init(&interp);
+	replay_interp_set_mode(&interp, mode);
+
+	const uint64_t start = os_gettime_ns();
+	for (uint32_t p = 0; p < BENCH_PAIRS; p++) {
+		const uint64_t index = p % (BENCH_FRAMES - 1);
+		replay_interp_prefetch(&interp, frames, BENCH_FRAMES, index, BENCH_STEPS);
+		for (uint32_t step = 1; step < BENCH_STEPS; step++) {
+			while (!replay_interp_get(&interp, frames[index], frames[index + 1], BENCH_STEPS, step))
+				os_sleep_ms(0);
+		}
+	}
+	const uint64_t elapsed = os_gettime_ns() - start;
+
+	const double synthesized = (double)BENCH_PAIRS * (BENCH_STEPS - 1);
+	const double fps = elapsed ? synthesized * 1000000000.0 / (double)elapsed : 0.0;
+	const double needed = (double)BENCH_OUTPUT_FPS * (BENCH_STEPS - 1) / BENCH_STEPS;
+	const double ms = interp.frames_synthesized ? (double)interp.synthesize_ns / 1000000.0 / (double)interp.frames_synthesized
+						    : 0.0;
+	printf("%-4s %-6s %d threads: %7.1f frames/s (%.2f ms a frame on one thread), %.1f needed for %dx at %d fps: %s\n",
+	       format_name, mode == INTERP_MODE_MOTION ? "motion" : "blend", (int)interp.thread_count, fps, ms, needed, BENCH_STEPS,
+	       BENCH_OUTPUT_FPS, fps >= needed ? "keeps up" : "falls behind");
+
+	replay_interp_free(&interp);
+	for (uint32_t i = 0; i < BENCH_FRAMES; i++)
+		obs_source_frame_destroy(frames[i]);
+}
+
+int main(void)
+{
+	printf("%d logical cores, %dx%d, %d synthesized frames per run\n", os_get_logical_cores(), BENCH_WIDTH, BENCH_HEIGHT,
+	       BENCH_PAIRS * (BENCH_STEPS - 1));
+	bench_run(VIDEO_FORMAT_BGRA, "bgra", INTERP_MODE_BLEND);
+	bench_run(VIDEO_FORMAT_BGRA, "bgra", INTERP_MODE_MOTION);
+	bench_run(VIDEO_FORMAT_NV12, "nv12", INTERP_MODE_BLEND);
+	bench_run(VIDEO_FORMAT_NV12, "nv12", INTERP_MODE_MOTION);
+	return 0;
+}
@@ -0,0 +1,100 @@
+#include <obs-module.h>
+#include <util/platform.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../replay.h"
+
+/* single core throughput of the trigger detector, planar packets of 1024
+ * frames at 48 kHz are fed to replay_trigger_process for each sample format
+ * and channel count, the input is a fixed pseudo random signal so runs can be
+ * compared between builds and machines */
+
+#define BENCH_FRAMES 1024
+#define BENCH_SAMPLE_RATE 48000
+#define BENCH_SECONDS 3600
+
+const char *obs_module_text(const char *lookup_string)
+{
+	return lookup_string;
+}
+
+static uint32_t bench_seed = 0x5eed1234;
+
+static float bench_random(void)
+{
+	bench_seed = bench_seed * 1664525u + 1013904223u;
+	return (float)(bench_seed >> 8) / (float)(1 << 24) * 2.0f - 1.0f;
+}
+
+static void bench_fill(uint8_t *plane, enum audio_format format)
+{
+	for (size_t i = 0; i < BENCH_FRAMES; i++) {
+		// quiet enough to never trigger, so every packet takes the full detector path
+		const float v = bench_random() * 0.05f;
+		if (format == AUDIO_FORMAT_FLOAT_PLANAR)
+			((float *)plane)[i] = v;
+		else if (format == AUDIO_FORMAT_16BIT_PLANAR)
+			((int16_t *)plane)[i] = (int16_t)(v * 32767.0f);
+		else
+			((int32_t *)plane)[i] = (int32_t)(v * 2147483647.0);
+	}
+}
+
+static void bench_run(enum audio_format format, const char *format_name, size_t channels, int mode)
+{
+	const size_t sample_size = format == AUDIO_FORMAT_16BIT_PLANAR ? sizeof(int16_t) : sizeof(float);
+	uint8_t *data[MAX_AV_PLANES] = {0};
+	for (size_t c = 0; c < channels; c++) {
+		data[c] = bmalloc(BENCH_FRAMES * sample_size);
+		bench_fill(data[c], format);
+	}
+
+	struct replay_trigger trigger = {0};
+	trigger.attack = 1.0f;
+	trigger.release = 0.5f;
+	trigger.mode = mode;
+	trigger.window_ms = 10;
+
+	const uint64_t packets = (uint64_t)BENCH_SECONDS * BENCH_SAMPLE_RATE / BENCH_FRAMES;
+	const uint64_t packet_ns = (uint64_t)BENCH_FRAMES * 1000000000ULL / BENCH_SAMPLE_RATE;
+	uint64_t timestamp = 0;
+	uint64_t trigger_timestamp = 0;
+	uint64_t triggers = 0;
+	const uint64_t start = os_gettime_ns();
+	for (uint64_t p = 0; p < packets; p++) {
+		if (replay_trigger_process(&trigger, data, format, channels, BENCH_FRAMES, BENCH_SAMPLE_RATE, timestamp,
+					   &trigger_timestamp))
+			triggers++;
+		timestamp += packet_ns;
+	}
+	const uint64_t elapsed = os_gettime_ns() - start;
+
+	const double samples = (double)packets * BENCH_FRAMES * (double)channels;
+	printf("%-6s %-4s %zu channels: %8.1f Msamples/s (%" PRIu64 " packets, %.3f s, %" PRIu64 " triggers)\n", format_name,
+	       mode == TRIGGER_MODE_RMS ? "rms" : "peak", channels, elapsed ? samples * 1000.0 / (double)elapsed : 0.0, packets,
+	       (double)elapsed / 1000000000.0, triggers);
+
+	for (size_t c = 0; c < channels; c++)
+		bfree(data[c]);
+}
+
+int main(void)
+{
+	static const size_t channel_counts[] = {2, 6, 8};
+	static const struct {
+		enum audio_format format;
+		const char *name;
+	} formats[] = {
+		{AUDIO_FORMAT_FLOAT_PLANAR, "float"},
+		{AUDIO_FORMAT_16BIT_PLANAR, "int16"},
+		{AUDIO_FORMAT_32BIT_PLANAR, "int32"},
+	};
+	for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+		for (size_t c = 0; c < sizeof(channel_counts) / sizeof(channel_counts[0]); c++) {
+			bench_run(formats[f].format, formats[f].name, channel_counts[c], TRIGGER_MODE_PEAK);
+			bench_run(formats[f].format, formats[f].name, channel_counts[c], TRIGGER_MODE_RMS);
+		}
+	}
+	return 0;
+}
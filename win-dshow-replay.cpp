@@ -231,6 +231,7 @@ struct DShowReplayInput {
 		circlebuf_init(&replay_filter.video_frames);
 		circlebuf_init(&replay_filter.audio_frames);
 		pthread_mutex_init(&replay_filter.mutex, NULL);
+		replay_filter_init_queues(&replay_filter);
 
 		av_log_set_level(AV_LOG_WARNING);
 		av_log_set_callback(ffmpeg_log);
@@ -271,12 +272,15 @@ struct DShowReplayInput {
 		ReleaseSemaphore(semaphore, 1, nullptr);
 
 		WaitForSingleObject(thread, INFINITE);
+		replay_trigger_log_stats(&replay_filter.trigger,
+					 obs_source_get_name(source));
 		pthread_mutex_lock(&replay_filter.mutex);
 		free_video_data(&replay_filter);
 		free_audio_data(&replay_filter);
 		pthread_mutex_unlock(&replay_filter.mutex);
 		circlebuf_free(&replay_filter.video_frames);
 		circlebuf_free(&replay_filter.audio_frames);
+		replay_filter_free_queues(&replay_filter);
 		pthread_mutex_destroy(&replay_filter.mutex);
 	}
 
@@ -539,33 +543,7 @@ void DShowReplayInput::OnVideoOutput(struct obs_source_frame2 *frame)
 		adjusted_time = os_time;
 	}
 	new_frame->timestamp = adjusted_time;
-	pthread_mutex_lock(&replay_filter.mutex);
-	circlebuf_push_back(&replay_filter.video_frames, &new_frame,
-			    sizeof(struct obs_source_frame *));
-	struct obs_source_frame *output;
-	circlebuf_peek_front(&replay_filter.video_frames, &output,
-			     sizeof(struct obs_source_frame *));
-	uint64_t cur_duration = new_frame->timestamp - output->timestamp;
-	while (cur_duration > 0 && cur_duration > replay_filter.duration) {
-		circlebuf_pop_front(&replay_filter.video_frames, NULL,
-				    sizeof(struct obs_source_frame *));
-		if (os_atomic_dec_long(&output->refs) <= 0) {
-			obs_source_frame_destroy(output);
-			output = NULL;
-		} else {
-			int t = 0;
-		}
-		if (replay_filter.video_frames.size) {
-			circlebuf_peek_front(&replay_filter.video_frames,
-					     &output,
-					     sizeof(struct obs_source_frame *));
-			cur_duration = new_frame->timestamp - output->timestamp;
-		} else {
-			cur_duration = 0;
-		}
-	}
-	if (replay_filter.mutex)
-		pthread_mutex_unlock(&replay_filter.mutex);
+	replay_filter_push_video(&replay_filter, new_frame);
 }
 
 void DShowReplayInput::OnAudioOutput(obs_source_audio *audio)
@@ -589,67 +567,37 @@ void DShowReplayInput::OnAudioOutput(obs_source_audio *audio)
 	replay_filter.oai.samples_per_sec = audio->samples_per_sec;
 	replay_filter.oai.speakers = audio->speakers;
 	replay_filter.oai.format = audio->format;
-	bool threshold = !replay_filter.trigger_threshold;
-
+	const size_t channels = get_audio_channels(audio->speakers);
+
+	/* the buffered packets are shared by reference, so they must be
+	 * allocated with the reference count in front of the planes */
+	const size_t plane_size =
+		(size_t)audio->frames *
+		get_audio_bytes_per_channel(audio->format) *
+		(is_audio_planar(audio->format) ? 1 : channels);
+	uint32_t planes = 0;
 	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
-		if (!audio->data[i]) {
-			cached.data[i] = NULL;
+		if (!audio->data[i])
 			break;
-		}
-		const size_t block_size =
-			get_audio_bytes_per_channel(audio->format) *
-			get_audio_channels(audio->speakers);
-
-		cached.data[i] = (uint8_t *)bmemdup(audio->data[i],
-						    audio->frames * block_size);
-
-		const size_t samples = (size_t)audio->frames *
-				       get_audio_channels(audio->speakers);
-		for (size_t j = 0; !threshold && j < samples; j++) {
-			if ((audio->format == AUDIO_FORMAT_16BIT ||
-			     audio->format == AUDIO_FORMAT_16BIT_PLANAR) &&
-			    abs(((int16_t *)audio->data[i])[j]) >
-				    replay_filter.threshold * 32768.0)
-				threshold = true;
-			if ((audio->format == AUDIO_FORMAT_32BIT ||
-			     audio->format == AUDIO_FORMAT_32BIT_PLANAR) &&
-			    abs(((int32_t *)audio->data[i])[j]) >
-				    replay_filter.threshold * 2147483648.0)
-				threshold = true;
-			if ((audio->format == AUDIO_FORMAT_FLOAT ||
-			     audio->format == AUDIO_FORMAT_FLOAT_PLANAR) &&
-			    fabsf(((float *)audio->data[i])[j]) >
-				    replay_filter.threshold)
-				threshold = true;
-		}
+		planes |= 1u << i;
 	}
-	if (replay_filter.trigger_threshold && threshold) {
-		replay_filter.trigger_threshold(replay_filter.threshold_data);
+	replay_audio_packet_alloc_size(&cached, planes, plane_size);
+	for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+		if (cached.data[i])
+			memcpy(cached.data[i], audio->data[i], plane_size);
 	}
-
-	pthread_mutex_lock(&replay_filter.mutex);
-
-	circlebuf_push_back(&replay_filter.audio_frames, &cached,
-			    sizeof(cached));
-
-	circlebuf_peek_front(&replay_filter.audio_frames, &cached,
-			     sizeof(cached));
-
-	uint64_t cur_duration = adjusted_time - cached.timestamp;
-	while (replay_filter.audio_frames.size > sizeof(cached) &&
-	       cur_duration >= replay_filter.duration + MAX_TS_VAR) {
-
-		circlebuf_pop_front(&replay_filter.audio_frames, NULL,
-				    sizeof(cached));
-		for (size_t i = 0; i < MAX_AV_PLANES; i++)
-			bfree(cached.data[i]);
-		memset(&cached, 0, sizeof(cached));
-		circlebuf_peek_front(&replay_filter.audio_frames, &cached,
-				     sizeof(cached));
-		cur_duration = adjusted_time - cached.timestamp;
+	uint64_t trigger_timestamp;
+	if (replay_filter.trigger_threshold &&
+	    replay_trigger_process(&replay_filter.trigger,
+				   (uint8_t *const *)audio->data, audio->format,
+				   channels, audio->frames,
+				   audio->samples_per_sec, adjusted_time,
+				   &trigger_timestamp)) {
+		replay_filter.trigger_threshold(replay_filter.threshold_data,
+						trigger_timestamp);
 	}
-	if (replay_filter.mutex)
-		pthread_mutex_unlock(&replay_filter.mutex);
+
+	replay_filter_push_audio(&replay_filter, &cached);
 	//replay_filter_check(filter);
 }
 //#define LOG_ENCODED_VIDEO_TS 1
@@ -1396,9 +1344,7 @@ static void UpdateDShowReplayInput(void *data, obs_data_t *settings)
 		//pthread_mutex_unlock(&input->replay_filter.mutex);
 	}
 	input->replay_filter.duration = new_duration;
-	const float db =
-		(float)obs_data_get_double(settings, SETTING_AUDIO_THRESHOLD);
-	input->replay_filter.threshold = db_to_mul(db);
+	replay_trigger_update(&input->replay_filter.trigger, settings);
 }
 
 static void *CreateDShowReplayInput(obs_data_t *settings, obs_source_t *source)
@@ -1435,6 +1381,7 @@ static void GetDShowReplayDefaults(obs_data_t *settings)
 				 (int)AudioMode::Capture);
 	obs_data_set_default_bool(settings, AUTOROTATION, true);
 	obs_data_set_default_bool(settings, HW_DECODE, false);
+	replay_trigger_defaults(settings);
 }
 
 struct Resolution {
@@ -2231,10 +2178,7 @@ static obs_properties_t *GetDShowReplayProperties(void *obj)
 				   SETTING_DURATION_MIN, SETTING_DURATION_MAX,
 				   1000);
 	obs_property_int_set_suffix(p, "ms");
-	obs_properties_add_float_slider(ppts, SETTING_AUDIO_THRESHOLD,
-					obs_module_text("ThresholdDb"),
-					SETTING_AUDIO_THRESHOLD_MIN,
-					SETTING_AUDIO_THRESHOLD_MAX, 0.1);
+	replay_trigger_properties(ppts);
 	return ppts;
 }
 
@@ -2281,6 +2225,20 @@ static void ShowDShowReplayInput(void *data)
 		input->QueueAction(Action::Activate);
 }
 
+/* the output callbacks only queue, the buffer is drained and trimmed to
+ * the duration here like replay_filter_buffer_tick does for the filters,
+ * the input has no arming so only the drain is needed */
+static void TickDShowReplayInput(void *data, float seconds)
+{
+	DShowReplayInput *input = reinterpret_cast<DShowReplayInput *>(data);
+
+	pthread_mutex_lock(&input->replay_filter.mutex);
+	replay_filter_drain(&input->replay_filter);
+	pthread_mutex_unlock(&input->replay_filter.mutex);
+
+	UNUSED_PARAMETER(seconds);
+}
+
 extern "C" void RegisterDShowReplaySource();
 
 void RegisterDShowReplaySource()
@@ -2294,6 +2252,7 @@ void RegisterDShowReplaySource()
 			    OBS_SOURCE_ASYNC | OBS_SOURCE_DO_NOT_DUPLICATE;
 	info.show = ShowDShowReplayInput;
 	info.hide = HideDShowReplayInput;
+	info.video_tick = TickDShowReplayInput;
 	info.get_name = GetDShowReplayInputName;
 	info.create = CreateDShowReplayInput;
 	info.destroy = DestroyDShowReplayInput;